@@ -0,0 +1,123 @@
+﻿/**
+ * LayoutBench.cpp: 3D 场存储布局的基准测试
+ * 在 192^3 的网格上计时一遍 CPU 端半拉格朗日对流（按速度策略回溯 + 按标量策略插值密度），比较 Linear 与 Bricked 布局
+ * 每种布局各按两种顺序遍历单元：按行（j 层、k 行、i 列）和按 8^3 块
+ */
+
+#include "GridData3d.h"
+#include "GridInterp.h"
+#include "Configure.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+namespace {
+    typedef Glb::DefaultInterpPolicies Policies;
+    typedef Glb::InterpGridData3d<Glb::GridData3dX<float>, Policies::Velocity> FieldU;
+    typedef Glb::InterpGridData3d<Glb::GridData3dY<float>, Policies::Velocity> FieldV;
+    typedef Glb::InterpGridData3d<Glb::GridData3dZ<float>, Policies::Velocity> FieldW;
+    typedef Glb::InterpGridData3d<Glb::GridData3d<float>, Policies::Scalar> FieldD;
+
+    const int kDim = 192;
+    const int kRepeats = 3;
+
+    // 绕 z 轴旋转并沿 z 上升的涡，外圈一步回溯约 3 个单元，相邻单元的回溯终点分散到不同的行和层
+    glm::vec3 swirl(const glm::vec3& pt, float h)
+    {
+        const float c = 0.5f * kDim * h;
+        const float x = pt.x - c, y = pt.y - c, z = pt.z - c;
+        return glm::vec3(-y, x, 0.25f * (x + y) + 0.1f * z) * (6.0f / kDim);
+    }
+
+    // 返回 [按行, 按块] 两种遍历顺序各自最快一遍的毫秒数；checksum 用于确认两种布局的结果相同
+    void run(Glb::GridLayout layout, double* ms, double& checksum)
+    {
+        const float h = Eulerian3dPara::theCellSize3d;
+        FieldU u;
+        FieldV v;
+        FieldW w;
+        FieldD d, out;
+        u.setLayout(layout);
+        v.setLayout(layout);
+        w.setLayout(layout);
+        d.setLayout(layout);
+        out.setLayout(layout);
+        u.initialize(0.0);
+        v.initialize(0.0);
+        w.initialize(0.0);
+        d.initialize(0.0);
+        out.initialize(0.0);
+
+        for (int k = 0; k <= kDim; k++)
+            for (int j = 0; j <= kDim; j++)
+                for (int i = 0; i <= kDim; i++) {
+                    if (j < kDim && k < kDim) u.at(i, j, k) = swirl(glm::vec3(i, j + 0.5f, k + 0.5f) * h, h).x;
+                    if (i < kDim && k < kDim) v.at(i, j, k) = swirl(glm::vec3(i + 0.5f, j, k + 0.5f) * h, h).y;
+                    if (i < kDim && j < kDim) w.at(i, j, k) = swirl(glm::vec3(i + 0.5f, j + 0.5f, k) * h, h).z;
+                    if (i < kDim && j < kDim && k < kDim)
+                        d.at(i, j, k) = 0.5f + 0.5f * std::sin(0.1f * i) * std::cos(0.13f * j) * std::sin(0.07f * k);
+                }
+        u.fillGhost();
+        v.fillGhost();
+        w.fillGhost();
+        d.fillGhost();
+
+        const float dt = 1.0f;
+        const float hi = (kDim - 1) * h;
+        auto advect = [&](int i, int j, int k) {
+            glm::vec3 pt((i + 0.5f) * h, (j + 0.5f) * h, (k + 0.5f) * h);
+            glm::vec3 vel((float)u.interpolate(pt), (float)v.interpolate(pt), (float)w.interpolate(pt));
+            glm::vec3 pos = pt - vel * dt;
+            for (int a = 0; a < 3; a++)
+                pos[a] = (std::min)((std::max)(pos[a], 0.5f * h), hi + 0.5f * h);
+            out.at(i, j, k) = (float)d.interpolate(pos);
+        };
+        // tile 为 1 时即按存储的 j 层、k 行、i 列逐行遍历
+        const int tiles[2] = { 1, 8 };
+        for (int t = 0; t < 2; t++) {
+            const int tile = tiles[t];
+            ms[t] = 1e30;
+            for (int r = 0; r < kRepeats; r++) {
+                auto t0 = std::chrono::steady_clock::now();
+                if (tile == 1) {
+                    for (int j = 0; j < kDim; j++)
+                        for (int k = 0; k < kDim; k++)
+                            for (int i = 0; i < kDim; i++)
+                                advect(i, j, k);
+                }
+                else {
+                    for (int jb = 0; jb < kDim; jb += tile)
+                        for (int kb = 0; kb < kDim; kb += tile)
+                            for (int ib = 0; ib < kDim; ib += tile)
+                                for (int j = jb; j < (std::min)(jb + tile, kDim); j++)
+                                    for (int k = kb; k < (std::min)(kb + tile, kDim); k++)
+                                        for (int i = ib; i < (std::min)(ib + tile, kDim); i++)
+                                            advect(i, j, k);
+                }
+                ms[t] = (std::min)(ms[t], std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count());
+            }
+        }
+
+        checksum = 0.0;
+        for (int k = 0; k < kDim; k++)
+            for (int j = 0; j < kDim; j++)
+                for (int i = 0; i < kDim; i++)
+                    checksum += out.at(i, j, k);
+    }
+}
+
+int main()
+{
+    Eulerian3dPara::theDim3d[0] = Eulerian3dPara::theDim3d[1] = Eulerian3dPara::theDim3d[2] = kDim;
+    double sumLinear = 0.0, sumBricked = 0.0;
+    double linear[2], bricked[2];
+    run(Glb::GridLayout::Linear, linear, sumLinear);
+    run(Glb::GridLayout::Bricked, bricked, sumBricked);
+    std::printf("semi-Lagrangian pass on %d^3 (best of %d)\n", kDim, kRepeats);
+    std::printf("               row order    brick order\n");
+    std::printf("  Linear : %9.1f ms %11.1f ms\n", linear[0], linear[1]);
+    std::printf("  Bricked: %9.1f ms %11.1f ms\n", bricked[0], bricked[1]);
+    std::printf("  speedup: %9.2fx %11.2fx\n", linear[0] / bricked[0], linear[1] / bricked[1]);
+    std::printf("  checksum: %s\n", sumLinear == sumBricked ? "identical" : "MISMATCH");
+    return sumLinear == sumBricked ? 0 : 1;
+}
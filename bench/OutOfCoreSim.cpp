@@ -0,0 +1,138 @@
+﻿/**
+ * OutOfCoreSim.cpp: 外存 3D 烟雾的离线仿真驱动
+ * 各场映射到 --dir 目录下的文件，由 OutOfCoreSolver 按 z 层窗口流式求解，网格总大小可以超过物理内存
+ * 用法：ooc_sim [--dim nx ny nz] [--frames n] [--dir path] [--slab n] [--solver 0|1|2] [--iterations n]
+ *               [--omega w] [--cold-start] [--scheme 0|1|2] [--order 1|2|3] [--vorticity eps] [--dt t]
+ *               [--adaptive] [--cfl c] [--substeps n]
+ * 参数的含义与 Eulerian3dPara 中的同名项相同，未给出的取 Configure.cpp 中的默认值
+ */
+
+#include "fluid3d/Eulerian/include/OutOfCoreSolver.h"
+#include "Configure.h"
+#include "Logger.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+using namespace FluidSimulation::Eulerian3d;
+
+namespace {
+    // 进程的峰值常驻内存（MB）
+    double peakResidentMB()
+    {
+#if defined(_WIN32)
+        PROCESS_MEMORY_COUNTERS counters;
+        if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+            return 0.0;
+        return counters.PeakWorkingSetSize / (1024.0 * 1024.0);
+#else
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_maxrss / 1024.0;
+#endif
+    }
+
+    // 各场映射文件的总大小（MB），与 OutOfCoreGrid3d::open 中的场一一对应
+    double mappedMB(const int *dim)
+    {
+        double cells = (double)dim[0] * dim[1] * dim[2];
+        double faces = (double)(dim[0] + 1) * dim[1] * dim[2] + (double)dim[0] * (dim[1] + 1) * dim[2] +
+                       (double)dim[0] * dim[1] * (dim[2] + 1);
+        return ((2.0 * faces + 7.0 * cells) * sizeof(float) + cells) / (1024.0 * 1024.0);
+    }
+
+    void usage()
+    {
+        std::printf("usage: ooc_sim [--dim nx ny nz] [--frames n] [--dir path] [--slab n] [--solver 0|1|2]\n"
+                    "               [--iterations n] [--omega w] [--cold-start] [--scheme 0|1|2] [--order 1|2|3]\n"
+                    "               [--vorticity eps] [--dt t] [--adaptive] [--cfl c] [--substeps n]\n"
+                    "  --solver  pressure iteration: 0 Gauss-Seidel, 1 red-black SOR, 2 Chebyshev-Jacobi\n"
+                    "  --cold-start  start every pressure solve from zero instead of the last pressure\n"
+                    "  --scheme  advection: 0 semi-Lagrangian, 1 MacCormack, 2 BFECC\n"
+                    "  --adaptive  split each frame of length --dt into CFL-limited substeps\n");
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int frames = 10;
+    std::string dir = Eulerian3dPara::outOfCoreDir.empty() ? std::string(".") : Eulerian3dPara::outOfCoreDir;
+    for (int a = 1; a < argc; a++) {
+        const char *opt = argv[a];
+        // 除 --adaptive、--cold-start 外每个选项都带参数，--dim 带三个
+        int need = (!std::strcmp(opt, "--adaptive") || !std::strcmp(opt, "--cold-start")) ? 0 : !std::strcmp(opt, "--dim") ? 3 : 1;
+        if (a + need >= argc) {
+            usage();
+            return 1;
+        }
+        if (!std::strcmp(opt, "--dim")) {
+            for (int d = 0; d < 3; d++)
+                Eulerian3dPara::theDim3d[d] = std::atoi(argv[a + 1 + d]);
+        }
+        else if (!std::strcmp(opt, "--frames")) frames = std::atoi(argv[a + 1]);
+        else if (!std::strcmp(opt, "--dir")) dir = argv[a + 1];
+        else if (!std::strcmp(opt, "--slab")) Eulerian3dPara::slabDepth = std::atoi(argv[a + 1]);
+        else if (!std::strcmp(opt, "--solver")) Eulerian3dPara::pressureSolver = std::atoi(argv[a + 1]);
+        else if (!std::strcmp(opt, "--iterations")) Eulerian3dPara::pressureIterations = std::atoi(argv[a + 1]);
+        else if (!std::strcmp(opt, "--omega")) Eulerian3dPara::sorOmega = (float)std::atof(argv[a + 1]);
+        else if (!std::strcmp(opt, "--cold-start")) Eulerian3dPara::warmStart = false;
+        else if (!std::strcmp(opt, "--scheme")) Eulerian3dPara::advectionScheme = std::atoi(argv[a + 1]);
+        else if (!std::strcmp(opt, "--order")) Eulerian3dPara::backtraceOrder = std::atoi(argv[a + 1]);
+        else if (!std::strcmp(opt, "--vorticity")) Eulerian3dPara::vorticityConst = (float)std::atof(argv[a + 1]);
+        else if (!std::strcmp(opt, "--dt")) Eulerian3dPara::dt = (float)std::atof(argv[a + 1]);
+        else if (!std::strcmp(opt, "--adaptive")) Eulerian3dPara::adaptiveTimeStep = true;
+        else if (!std::strcmp(opt, "--cfl")) Eulerian3dPara::cflNumber = (float)std::atof(argv[a + 1]);
+        else if (!std::strcmp(opt, "--substeps")) Eulerian3dPara::maxSubsteps = (std::max)(std::atoi(argv[a + 1]), 1);
+        else {
+            usage();
+            return 1;
+        }
+        a += need;
+    }
+    const int *dim = Eulerian3dPara::theDim3d;
+    if (dim[0] <= 0 || dim[1] <= 0 || dim[2] <= 0) {
+        usage();
+        return 1;
+    }
+    // 默认烟雾源按 Configure.cpp 中的默认尺寸放在底面中心，换尺寸后重新居中
+    if (!Eulerian3dPara::source.empty())
+        Eulerian3dPara::source[0].position = glm::ivec3(dim[0] / 2, dim[1] / 2, 0);
+
+    OutOfCoreGrid3d grid;
+    if (!grid.open(dir)) {
+        const std::vector<std::string> &log = Glb::Logger::getInstance().getLog();
+        std::fprintf(stderr, "%s\n", log.empty() ? "failed to open the out-of-core grid" : log.back().c_str());
+        return 1;
+    }
+    OutOfCoreSolver solver(grid);
+    std::printf("out-of-core grid %d x %d x %d in %s: %.0f MB mapped\n", dim[0], dim[1], dim[2], dir.c_str(), mappedMB(dim));
+
+    for (int f = 0; f < frames; f++) {
+        auto t0 = std::chrono::steady_clock::now();
+        grid.updateSources();
+        solver.solve();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        // 按 z 层逐层累加，只读取密度场，读过的层按窗口释放
+        const int depth = (std::max)(Eulerian3dPara::slabDepth, 1);
+        double density = 0.0;
+        for (int k = 0; k < dim[2]; k++) {
+            for (int j = 0; j < dim[1]; j++)
+                for (int i = 0; i < dim[0]; i++)
+                    density += grid.mD.at(i, j, k);
+            if ((k + 1) % depth == 0 || k + 1 == dim[2])
+                grid.mD.evictSlabs(0, k + 1);
+        }
+        std::printf("frame %3d: %8.2f s  total density %.6g  peak resident %.0f MB\n", f, seconds, density, peakResidentMB());
+    }
+    return 0;
+}
@@ -0,0 +1,64 @@
+﻿#pragma once
+#ifndef __ADAPTIVE_TIME_STEP_H__
+#define __ADAPTIVE_TIME_STEP_H__
+
+#include "Global.h"
+#include <algorithm>
+
+namespace Glb {
+
+	// 按 CFL 条件把一帧的时间分成若干子步：每个子步内速度分量最多移动 cfl 个单元
+	// 剩余时间不足两个 CFL 步长时平分，避免最后一个子步过短；达到 maxSubsteps 时最后一个子步走完剩余时间
+	// 不自适应时整帧只走一步，仍统计 CFL 数
+	class AdaptiveTimeStep
+	{
+	public:
+		// cellSize 为速度所用长度单位下的单元边长
+		AdaptiveTimeStep(float frameTime, bool adaptive, float cfl, int maxSubsteps, double cellSize)
+			: mRemaining(frameTime), mAdaptive(adaptive && cfl > 0.0f), mCfl(cfl), mMaxSubsteps((std::max)(maxSubsteps, 1)),
+			  mCellSize(cellSize), mSubsteps(0), mMinStep(frameTime), mMaxCfl(0.0) {}
+
+		bool done() const { return mRemaining <= 0.0f; }
+
+		// 下一个子步的步长，maxVelocity 为当前速度分量绝对值的最大值
+		float next(double maxVelocity)
+		{
+			float dt = mRemaining;
+			if (mAdaptive && maxVelocity > 0.0 && mSubsteps + 1 < mMaxSubsteps) {
+				const float cflStep = (float)(mCfl * mCellSize / maxVelocity);
+				if (cflStep < mRemaining)
+					dt = (std::min)(cflStep, 0.5f * mRemaining);
+			}
+			mRemaining -= dt;
+			mSubsteps++;
+			mMinStep = (std::min)(mMinStep, dt);
+			mMaxCfl = (std::max)(mMaxCfl, maxVelocity * dt / mCellSize);
+			return dt;
+		}
+
+		int substeps() const { return mSubsteps; }
+		float minStep() const { return mMinStep; }
+		double maxCfl() const { return mMaxCfl; }
+
+		// 在计时器面板显示本帧的最小子步长、子步数和最大 CFL 数
+		void record() const
+		{
+			Timer& timer = Timer::getInstance();
+			timer.recordValue("Time step", (double)mMinStep);
+			timer.recordValue("Substeps", mSubsteps);
+			timer.recordValue("CFL", mMaxCfl);
+		}
+
+	private:
+		float mRemaining;
+		bool mAdaptive;
+		float mCfl;
+		int mMaxSubsteps;
+		double mCellSize;
+		int mSubsteps;
+		float mMinStep;
+		double mMaxCfl;
+	};
+}
+
+#endif
@@ -25,6 +25,7 @@ namespace Glb {
 		virtual void init() = 0;         // ʼ
 		virtual void simulate() = 0;     // ģ
 		virtual GLuint getRenderedTexture() = 0;  // ȡȾ
+		virtual void resample() { init(); }  // е·ֱزǰ״̬Ĭ³ʼ
 	};
 }
 
@@ -62,7 +62,23 @@ namespace Eulerian2dPara
     extern float theCellSize2d;
     extern bool addSolid;
 
-    extern float dt;
+    extern float dt;                // 开启自适应步长时为每帧推进的时间
+    extern bool adaptiveTimeStep;   // 按 CFL 数自动分子步
+    extern float cflNumber;         // 每个子步内速度分量最多移动的单元数
+    extern int maxSubsteps;         // 每帧最多的子步数
+    extern int backtraceOrder;      // 对流回溯的 Runge-Kutta 阶数（1 ~ 3）
+    extern int advectionScheme;     // 对流格式，取值见 Glb::AdvectionScheme
+    extern int numThreads;          // 2D 求解器的线程数，0 表示使用 OpenMP 默认值（全部核心）
+    extern int pressureSolver;      // 压力迭代方法，取值见 Glb::PressureSolverType
+    extern int pressureIterations;  // 每次投影的压力迭代次数
+    extern int multigridCycle;      // 多重网格的循环类型：0 V 循环，1 F 循环
+    extern bool fastPoisson;        // 没有固体时用 DCT 直接求解压力
+    extern float dctSolidFraction;  // 固体单元比例不超过该值时 PCG 以 DCT 为预条件子
+    extern float sorOmega;          // 红黑 SOR 的松弛因子，不在 (0, 2) 内时自动取最优值
+    extern float pressureTolerance; // 压力求解的相对残差（最大范数）阈值
+    extern int residualInterval;    // 定常迭代每隔多少次检查一次残差
+    extern int temporalBlocking;    // 定常迭代在每个行块上连续做的迭代次数
+    extern bool warmStart;          // 以上一步的压力为初值
 
     extern float contrast;
     extern int drawModel;
@@ -96,6 +112,19 @@ namespace Eulerian3dPara
     extern float theCellSize3d;
     extern std::vector<SourceSmoke> source;
     extern bool addSolid;
+    extern bool brickedLayout;
+    extern std::string outOfCoreDir;
+    extern int slabDepth;
+    extern int pressureSolver;      // 离线外存求解的压力迭代方法，取值见 Glb::PressureSolverType
+    extern int pressureIterations;  // 离线外存求解每次投影的压力迭代次数
+    extern float sorOmega;          // 离线外存求解红黑 SOR 的松弛因子
+    extern float pressureTolerance; // CPU 端 MAC 场投影（Solver::projectMAC）的 PCG 相对残差阈值
+    extern bool fastPoisson;        // CPU 端 MAC 场投影在没有固体时用 DCT 直接求解
+    extern float dctSolidFraction;  // 固体单元比例不超过该值时 CPU 端 PCG 以 DCT 为预条件子
+    extern int gpuPressureIterations;   // GPU 端每次投影的 Jacobi 迭代次数上限
+    extern float gpuPressureTolerance;  // GPU 端 Jacobi 迭代的相对残差阈值
+    extern int residualInterval;    // GPU 端每隔多少次迭代检查一次残差
+    extern bool warmStart;          // 以上一步的压力为初值
 
     extern float contrast;
     extern int drawModel;
@@ -103,7 +132,12 @@ namespace Eulerian3dPara
     extern int gridNumY;
     extern int gridNumZ;
 
-    extern float dt;
+    extern float dt;                // 开启自适应步长时为每帧推进的时间
+    extern bool adaptiveTimeStep;   // 按 CFL 数自动分子步
+    extern float cflNumber;         // 每个子步内速度分量最多移动的单元数
+    extern int maxSubsteps;         // 每帧最多的子步数
+    extern int backtraceOrder;      // 离线外存求解对流回溯的 Runge-Kutta 阶数（1 ~ 3）
+    extern int advectionScheme;     // 离线外存求解的对流格式，取值见 Glb::AdvectionScheme
     extern bool useBFECC;
     extern bool useReflection;
 
@@ -0,0 +1,126 @@
+﻿#pragma once
+#ifndef __FFT_H__
+#define __FFT_H__
+
+#include <cmath>
+#include <complex>
+#include <vector>
+
+namespace Glb {
+
+	// 任意长度的复数 FFT，混合基 Cooley-Tukey（按时间抽取，递归）
+	// 长度按 2、3、5 和其余素因子分解：基 2 用专门的蝶形，其余用通用蝶形，素因子 p 的代价为 O(n p)
+	// 变换不归一化；实例初始化后只读，可被多个线程同时使用
+	class FFT
+	{
+	public:
+		typedef std::complex<double> Complex;
+
+		FFT() : mSize(0), mMaxFactor(1) {}
+		explicit FFT(int n) { init(n); }
+
+		void init(int n)
+		{
+			const double pi = 3.14159265358979323846;
+			mSize = n;
+			mTwiddle.resize(n);
+			mTwiddleInv.resize(n);
+			for (int j = 0; j < n; j++) {
+				mTwiddle[j] = Complex(std::cos(-2.0 * pi * j / n), std::sin(-2.0 * pi * j / n));
+				mTwiddleInv[j] = std::conj(mTwiddle[j]);
+			}
+			// 因子表为 (p, 剩余长度) 对
+			mFactors.clear();
+			mMaxFactor = 1;
+			int p = 2;
+			while (n > 1) {
+				while (n % p) {
+					p = p == 2 ? 3 : p + 2;
+					if (p * p > n)
+						p = n;
+				}
+				n /= p;
+				mFactors.push_back(p);
+				mFactors.push_back(n);
+				mMaxFactor = p > mMaxFactor ? p : mMaxFactor;
+			}
+		}
+
+		int size() const { return mSize; }
+
+		// 变换使用的临时缓冲区的长度（最大素因子），不超过 size()
+		int scratchSize() const { return mMaxFactor; }
+
+		// out[k] = sum(in[m] * exp(-2 pi i k m / n))，in 与 out 不能重叠
+		// scratch 至少有 scratchSize() 个元素，多个线程同时变换时各用各的 scratch
+		void forward(const Complex* in, Complex* out, Complex* scratch) const { transform(in, out, scratch, false); }
+		// out[m] = sum(in[k] * exp(2 pi i k m / n))，不除以 n
+		void inverse(const Complex* in, Complex* out, Complex* scratch) const { transform(in, out, scratch, true); }
+
+	private:
+		void transform(const Complex* in, Complex* out, Complex* scratch, bool inv) const
+		{
+			if (mSize <= 1) {
+				if (mSize == 1)
+					out[0] = in[0];
+				return;
+			}
+			work(out, in, 1, mFactors.data(), inv ? mTwiddleInv.data() : mTwiddle.data(), scratch);
+		}
+
+		// 不检查 inf / nan 的复数乘法，std::complex 的乘法在部分编译器上要调用库函数
+		static Complex mul(const Complex& a, const Complex& b)
+		{
+			return Complex(a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real());
+		}
+
+		// 把 in 中步长为 fstride 的子序列变换到 out，长度为 factors[0] * factors[1]
+		void work(Complex* out, const Complex* in, int fstride, const int* factors, const Complex* twiddle, Complex* scratch) const
+		{
+			const int p = factors[0], m = factors[1];
+			if (m == 1) {
+				for (int q = 0; q < p; q++)
+					out[q] = in[q * fstride];
+			}
+			else {
+				// p 个长度为 m 的子变换
+				for (int q = 0; q < p; q++)
+					work(out + q * m, in + q * fstride, fstride * p, factors + 2, twiddle, scratch);
+			}
+
+			if (p == 2) {
+				for (int k = 0; k < m; k++) {
+					const Complex t = mul(out[m + k], twiddle[k * fstride]);
+					out[m + k] = out[k] - t;
+					out[k] += t;
+				}
+				return;
+			}
+			// 通用蝶形
+			for (int u = 0; u < m; u++) {
+				for (int q = 0; q < p; q++)
+					scratch[q] = out[u + q * m];
+				for (int q1 = 0; q1 < p; q1++) {
+					const int k = u + q1 * m;
+					Complex sum = scratch[0];
+					int j = 0;
+					for (int q = 1; q < p; q++) {
+						j += fstride * k;
+						if (j >= mSize)
+							j %= mSize;
+						sum += mul(scratch[q], twiddle[j]);
+					}
+					out[k] = sum;
+				}
+			}
+		}
+
+		int mSize;
+		int mMaxFactor;
+		std::vector<int> mFactors;
+		std::vector<Complex> mTwiddle;		// exp(-2 pi i j / n)
+		std::vector<Complex> mTwiddleInv;	// exp(2 pi i j / n)
+	};
+}
+
+#endif
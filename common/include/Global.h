@@ -4,6 +4,8 @@
 #include <chrono>
 #include <random>
 #include <unordered_map>
+#include <map>
+#include <cstdio>
 #include <glm/glm.hpp>
 #include <string>
 
@@ -32,16 +34,18 @@ namespace Glb {
         std::chrono::system_clock::time_point now;          // 性能分析的当前时间点
 
         std::unordered_map<std::string, unsigned long long int> record;  // 记录各阶段耗时
+        std::map<std::string, std::string> values;  // 求解器统计量（迭代次数、残差等），按名称排序显示
 
     public:
         // 检查记录是否为空
         bool empty() {
-            return record.empty();
+            return record.empty() && values.empty();
         }
 
         // 清空记录
         void clear() {
             record.clear();
+            values.clear();
         }
 
         // 开始计时
@@ -82,6 +86,21 @@ namespace Glb {
             }
         }
 
+        // 记录某个统计量的最新值，与耗时一起显示
+        void recordValue(const std::string& name, const std::string& value) {
+            values[name] = value;
+        }
+
+        void recordValue(const std::string& name, int value) {
+            values[name] = std::to_string(value);
+        }
+
+        void recordValue(const std::string& name, double value) {
+            char buf[32];
+            std::snprintf(buf, sizeof(buf), "%.3g", value);
+            values[name] = buf;
+        }
+
         // 获取当前性能统计信息
         std::string currentStatus() {
             std::string str;
@@ -90,9 +109,16 @@ namespace Glb {
                 total_time += timing.second;
             }
 
-            for (const auto& timing : record) {
-                float percentage = static_cast<float>(timing.second) / total_time * 100;
-                str += timing.first + ": " + std::to_string(percentage).substr(0, 5) + "%% \n";
+            if (total_time > 0) {
+                for (const auto& timing : record) {
+                    float percentage = static_cast<float>(timing.second) / total_time * 100;
+                    str += timing.first + ": " + std::to_string(percentage).substr(0, 5) + "%% \n";
+                }
+            }
+
+            // 结果作为 ImGui::Text 的格式串，统计量中不应含 %
+            for (const auto& value : values) {
+                str += value.first + ": " + value.second + " \n";
             }
 
             return str;
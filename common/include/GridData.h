@@ -0,0 +1,261 @@
+﻿#pragma once
+#ifndef __GRID_DATA_H__
+#define __GRID_DATA_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <cassert>
+#include <new>
+#include <vector>
+#include <algorithm>
+#include "GridPool.h"
+
+namespace Glb {
+
+	// 场数据的对齐字节数：一个缓存行，同时满足 AVX2 / AVX-512 的对齐加载
+	const std::size_t kGridDataAlignment = 64;
+
+	// 按 Alignment 字节对齐分配内存的分配器，供 std::vector 使用
+	template <typename T, std::size_t Alignment = kGridDataAlignment>
+	class AlignedAllocator
+	{
+	public:
+		typedef T value_type;
+
+		template <typename U>
+		struct rebind { typedef AlignedAllocator<U, Alignment> other; };
+
+		AlignedAllocator() noexcept {}
+		template <typename U>
+		AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept {}
+
+		// 大块经过 GridMemoryPool，重新初始化同样尺寸的场时复用已释放的内存
+		// 小块多申请 Alignment 字节，对齐后的地址之前保存原始指针（不依赖 C++17 的对齐 new）
+		T* allocate(std::size_t n)
+		{
+			if (pooled(n))
+				return static_cast<T*>(GridMemoryPool::getInstance().acquire(n * sizeof(T)));
+			void* raw = ::operator new(n * sizeof(T) + Alignment + sizeof(void*));
+			std::uintptr_t addr = reinterpret_cast<std::uintptr_t>(raw) + sizeof(void*);
+			addr = (addr + Alignment - 1) & ~(std::uintptr_t)(Alignment - 1);
+			reinterpret_cast<void**>(addr)[-1] = raw;
+			return reinterpret_cast<T*>(addr);
+		}
+
+		void deallocate(T* p, std::size_t n) noexcept
+		{
+			if (!p)
+				return;
+			if (pooled(n))
+				GridMemoryPool::getInstance().release(p, n * sizeof(T));
+			else
+				::operator delete(reinterpret_cast<void**>(p)[-1]);
+		}
+
+		template <typename U>
+		bool operator==(const AlignedAllocator<U, Alignment>&) const noexcept { return true; }
+		template <typename U>
+		bool operator!=(const AlignedAllocator<U, Alignment>&) const noexcept { return false; }
+
+	private:
+		// 内存池只保证 kGridDataAlignment 字节对齐
+		static bool pooled(std::size_t n)
+		{
+			return Alignment <= kGridDataAlignment && n * sizeof(T) >= GridMemoryPool::kMinPooledBytes;
+		}
+	};
+
+	// 并行填充的分块长度（元素个数），小于一块的存储直接串行填充
+	const std::ptrdiff_t kParallelFillChunk = 64 * 1024;
+
+	// 填充 [p, p + n)；开启 OpenMP 时按块并行，重置大场的耗时接近一次多线程 memset
+	template <typename T>
+	void parallelFill(T* p, std::size_t n, T value)
+	{
+		const std::ptrdiff_t total = (std::ptrdiff_t)n;
+		if (total <= kParallelFillChunk) {
+			std::fill(p, p + total, value);
+			return;
+		}
+		const std::ptrdiff_t chunks = (total + kParallelFillChunk - 1) / kParallelFillChunk;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+		for (std::ptrdiff_t c = 0; c < chunks; c++) {
+			std::ptrdiff_t begin = c * kParallelFillChunk;
+			std::ptrdiff_t end = (std::min)(total, begin + kParallelFillChunk);
+			std::fill(p + begin, p + end, value);
+		}
+	}
+
+	// 存储布局
+	//   Linear : 按原有下标顺序线性排列
+	//   Bricked: 仅 3D，8x8x8 分块，块之间按 j、k、i 排列，块内按 Morton 顺序排列
+	//            三线性 / 三次插值的相邻访问大多落在同一块（4KB 以内）
+	enum class GridLayout { Linear, Bricked };
+
+	// N 维稠密场存储
+	// 连续、64 字节对齐的一维数组，值类型按场选择（速度 double/float，标量 float，掩码 uint8_t）
+	// 每一维两侧各带 ghost 层，(i, j, k) 的有效范围为 [-ghost, extent + ghost)
+	// Linear 布局下下标顺序与原有 GridData2d / GridData3d 一致：
+	//   2D: i + j * dim0
+	//   3D: i + k * dim0 + j * dim0 * dim2
+	template <typename T, int N>
+	class GridData
+	{
+	public:
+		typedef T value_type;
+		typedef std::vector<T, AlignedAllocator<T> > Storage;
+
+		// 分块边长为 2^kBrickLog2
+		static const int kBrickLog2 = 3;
+		static const int kBrickSize = 1 << kBrickLog2;
+
+		GridData() : mGhost(0), mOrigin(0), mLayout(GridLayout::Linear)
+		{
+			for (int d = 0; d < N; d++) {
+				mExtent[d] = 0;
+				mStride[d] = 0;
+				mBricks[d] = 0;
+			}
+		}
+
+		// 选择存储布局，在 resize 之前调用；2D 场只支持 Linear
+		void setLayout(GridLayout layout)
+		{
+			assert(N == 3 || layout == GridLayout::Linear);
+			mLayout = (N == 3) ? layout : GridLayout::Linear;
+		}
+
+		GridLayout layout() const { return mLayout; }
+
+		// 按各维长度和 ghost 层数分配存储，不保留原有数据
+		// 元素个数不变时保留原有内存；改变时先释放再按准确长度申请，旧块回到内存池
+		void resize(const int* extent, int ghost = 0)
+		{
+			mGhost = ghost;
+			int padded[N];
+			std::size_t n = 1;
+			for (int d = 0; d < N; d++) {
+				mExtent[d] = extent[d];
+				padded[d] = extent[d] + 2 * ghost;
+				n *= padded[d];
+			}
+			// 2D 按 j 行优先；3D 按 j 层、k 行、i 列排列
+			mStride[0] = 1;
+			if (N == 2) {
+				mStride[1] = padded[0];
+			}
+			else {
+				mStride[N - 1] = padded[0];
+				mStride[1] = (std::ptrdiff_t)padded[0] * padded[N - 1];
+			}
+			mOrigin = 0;
+			for (int d = 0; d < N; d++) mOrigin += ghost * mStride[d];
+			if (mLayout == GridLayout::Bricked) {
+				// 各维向上取整到整块，尾部块中未使用的部分只占内存不参与计算
+				n = 1;
+				for (int d = 0; d < N; d++) {
+					mBricks[d] = (padded[d] + kBrickSize - 1) >> kBrickLog2;
+					n *= (std::size_t)mBricks[d] << kBrickLog2;
+				}
+			}
+			if (n != mData.size()) {
+				Storage().swap(mData);
+				mData.resize(n);
+			}
+		}
+
+		// 与同类型存储交换全部内容，O(1)，不复制数据
+		void swap(GridData& other)
+		{
+			mData.swap(other.mData);
+			for (int d = 0; d < N; d++) {
+				std::swap(mExtent[d], other.mExtent[d]);
+				std::swap(mStride[d], other.mStride[d]);
+				std::swap(mBricks[d], other.mBricks[d]);
+			}
+			std::swap(mGhost, other.mGhost);
+			std::swap(mOrigin, other.mOrigin);
+			std::swap(mLayout, other.mLayout);
+		}
+
+		// 填充全部存储（包括 ghost 层）
+		void fill(T value)
+		{
+			parallelFill(mData.data(), mData.size(), value);
+		}
+
+		int extent(int d) const { return mExtent[d]; }
+		int ghost() const { return mGhost; }
+		// 线性布局下各维步长，Bricked 布局下无意义
+		std::ptrdiff_t stride(int d) const { return mStride[d]; }
+		std::size_t size() const { return mData.size(); }
+
+		T* data() { return mData.data(); }
+		const T* data() const { return mData.data(); }
+
+		typename Storage::iterator begin() { return mData.begin(); }
+		typename Storage::iterator end() { return mData.end(); }
+
+		T& operator[](std::size_t idx) { return mData[idx]; }
+		const T& operator[](std::size_t idx) const { return mData[idx]; }
+
+		std::size_t index(int i, int j) const
+		{
+			return (std::size_t)(mOrigin + i + j * mStride[1]);
+		}
+
+		std::size_t index(int i, int j, int k) const
+		{
+			if (mLayout == GridLayout::Bricked)
+				return brickedIndex(i, j, k);
+			return (std::size_t)(mOrigin + i + j * mStride[1] + k * mStride[2]);
+		}
+
+		// 不做边界检查的访问，下标可落在 ghost 层内
+		T& at(int i, int j) { return mData[index(i, j)]; }
+		const T& at(int i, int j) const { return mData[index(i, j)]; }
+		T& at(int i, int j, int k) { return mData[index(i, j, k)]; }
+		const T& at(int i, int j, int k) const { return mData[index(i, j, k)]; }
+
+		// Bricked 布局的下标按维可分：index(i, j, k) = brickedAxis(0, i) + brickedAxis(1, j) + brickedAxis(2, k)
+		// 块号与块内 Morton 码占用互不重叠的位，插值模板可以按维各算一次再相加
+		std::size_t brickedAxis(int d, int v) const
+		{
+			const unsigned u = (unsigned)(v + mGhost);
+			const std::size_t brickStride[3] = { 1, (std::size_t)mBricks[2] * mBricks[0], (std::size_t)mBricks[0] };
+			return (((std::size_t)(u >> kBrickLog2) * brickStride[d]) << (3 * kBrickLog2)) | (mortonSpread(u & (kBrickSize - 1)) << d);
+		}
+
+	private:
+		// 块内 3 位坐标展开为 Morton 码中的对应位：abc -> a00b00c
+		static std::size_t mortonSpread(unsigned v)
+		{
+			static const unsigned char kSpread[8] = { 0, 1, 8, 9, 64, 65, 72, 73 };
+			return kSpread[v];
+		}
+
+		std::size_t brickedIndex(int i, int j, int k) const
+		{
+			const unsigned mask = kBrickSize - 1;
+			unsigned x = (unsigned)(i + mGhost);
+			unsigned y = (unsigned)(j + mGhost);
+			unsigned z = (unsigned)(k + mGhost);
+			std::size_t brick = (x >> kBrickLog2) +
+				((std::size_t)(z >> kBrickLog2) + (std::size_t)(y >> kBrickLog2) * mBricks[2]) * mBricks[0];
+			std::size_t cell = mortonSpread(x & mask) | (mortonSpread(y & mask) << 1) | (mortonSpread(z & mask) << 2);
+			return (brick << (3 * kBrickLog2)) | cell;
+		}
+
+		Storage mData;					// 对齐的连续存储（含 ghost 层）
+		int mExtent[N];					// 各维长度（不含 ghost 层）
+		int mGhost;						// 每侧 ghost 层数
+		std::ptrdiff_t mStride[N];		// 各维步长
+		std::ptrdiff_t mOrigin;			// (0, 0, 0) 在存储中的偏移
+		GridLayout mLayout;				// 存储布局
+		int mBricks[N];					// Bricked 布局下各维块数
+	};
+}
+
+#endif
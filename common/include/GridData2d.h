@@ -3,18 +3,26 @@
 #define __GRID_DATA_2D_H__
 
 #pragma warning(disable: 4244 4267 4996)
-#include <boost/numeric/ublas/vector.hpp>
-#include <boost/numeric/ublas/io.hpp>
 #include <glm/glm.hpp>
+#include "GridData.h"
+#include "GridExpr.h"
+#include "Half.h"
+#include "GridInterp.h"
+#include <type_traits>
 
-namespace Glb {
+// ģʵλ GridData2d.cpp float / double / Half / uint8_t ʽʵ
 
-	using namespace boost::numeric;
+namespace Glb {
 
 	// 2Dݻ,ڴ洢ʹMACϵı
-	class GridData2d
+	// T ΪóĴ洢ͣfloat / double / uint8_t
+	template <typename T = double>
+	class GridData2d : public GridExpr<GridData2d<T> >
 	{
 	public:
+		static const bool kGridExprTerminal = true;
+		typedef T value_type;
+
 		GridData2d();
 		GridData2d(const GridData2d& orig);
 		virtual ~GridData2d();
@@ -23,65 +31,154 @@ namespace Glb {
 		// Ĭֵʼ
 		virtual void initialize(double dfltValue = 0.0);
 
-		// (i,j)λϵĿɸı
-		// ʹ GridData2d(i, j) = num ʽиֵ
-		virtual double& operator()(int i, int j);
+		// һͬೡݣO(1)ǰ󻺳ֻ
+		void swap(GridData2d& other);
+
+		// ÿ ghost  initialize ֮ǰ
+		void setGhostLayers(int ghost);
+
+		// ֻ߽ʣڷȵ룩Խλ÷Ĭֵֵأڶ߳ʹ
+		T operator()(int i, int j) const { return get(i, j); }
+		T get(int i, int j) const;
+
+		// ߽д룬Խд뱻
+		void set(int i, int j, T value);
+
+		// ߽ĿٷʣҪ -ghost <= i, j < dim + ghost
+		// ߽ȡֵ ghost У fillGhost() ά
+		T& at(int i, int j) { return mData.at(i, j); }
+		const T& at(int i, int j) const { return mData.at(i, j); }
+
+		// ߽ ghost 㣬д֮ʹ at() ȡ֮ǰ
+		void fillGhost();
 
 		// ꣬زֵõֵ
 		// ڳΧĵ㣬Ĭֵ
 		virtual double interpolate(const glm::vec2& pt);	
 
-		// ݣmDataΪublasв
-		ublas::vector<double>& data();
+		// ֵxs / ys Ϊ n ꣬д out
+		//  interpolate(pt) ͬ AVX2 ʱÿ 8 һ飬 gather ָȡֵ
+		virtual void interpolate(const float* xs, const float* ys, double* out, std::size_t n);
+		void interpolate(const float* xs, const float* ys, float* out, std::size_t n);
+
+		// ʵײ洢
+		GridData<T, 2>& data();
+		const GridData<T, 2>& data() const { return mData; }
+
+		// ʽֵ u = 2.0 * u - u_backչΪһԪѭ ghost 㣩
+		template <typename E>
+		GridData2d& operator=(const GridExpr<E>& e)
+		{
+			evalGridExpr(mData.data(), mData.size(), e);
+			return *this;
+		}
+
+		GridData2d& operator*=(double s)
+		{
+			evalGridExpr(mData.data(), mData.size(), *this * s);
+			return *this;
+		}
+
+		// ֻ mask λøֵmask 뱾״ͬ u.masked(faceMask) = ...
+		GridMaskedRef<T> masked(const GridData2d<std::uint8_t>& mask)
+		{
+			assert(mask.data().size() == mData.size());
+			return GridMaskedRef<T>(mData.data(), mData.size(), mask.data().data());
+		}
+
+		// ʽֵʱ洢±Ԫضȡ
+		double operator[](std::size_t idx) const { return mData[idx]; }
+		std::size_t size() const { return mData.size(); }
 
 		// ꣬ظõڵԪ
 		virtual void getCell(const glm::vec2& pt, int& i, int& j);
 
 		virtual glm::vec2 worldToSelf(const glm::vec2& pt) const;
-		double mDfltValue;				// Ĭֵڳʼ
+		T mDfltValue;					// Ĭֵڳʼ
 		glm::vec2 mMax;					// άռе꣬ʾĳߴ
-		ublas::vector<double> mData;	    // 洢ݵһά
+		GridData<T, 2> mData;			// 洢ݵһά飨64ֽڶ룬 ghost 㣩
 		float cellSize;                  // ԪС
 		int dim[2];                      // ά
+
+	protected:
+		//  (i,j) ӳ䵽洢еλã false ʾλȡĬֵ
+		virtual bool clampIndex(int& i, int& j) const;
+
+		// worldToSelf мȥƫֵ˼
+		virtual glm::dvec2 sampleOffset() const;
+
+		// µ˫Բֵ
+		double interpolateSelf(const glm::vec2& pos) const;
+
+		int mGhost;						// ÿ ghost 
 	};
 
 	// Xٶȷ
-	class GridData2dX : public GridData2d
+	template <typename T = double>
+	class GridData2dX : public GridData2d<T>
 	{
 	public:
+		using GridData2d<T>::operator=;
+
 		GridData2dX();
 		virtual ~GridData2dX();
 		virtual void initialize(double dfltValue = 0.0);
-		virtual double& operator()(int i, int j);
 		virtual glm::vec2 worldToSelf(const glm::vec2& pt) const;
+
+	protected:
+		virtual bool clampIndex(int& i, int& j) const;
+		virtual glm::dvec2 sampleOffset() const;
 	};
 
 	// Yٶȷ
-	class GridData2dY : public GridData2d
+	template <typename T = double>
+	class GridData2dY : public GridData2d<T>
 	{
 	public:
+		using GridData2d<T>::operator=;
+
 		GridData2dY();
 		virtual ~GridData2dY();
 		virtual void initialize(double dfltValue = 0.0);
-		virtual double& operator()(int i, int j);
 		virtual glm::vec2 worldToSelf(const glm::vec2& pt) const;
+
+	protected:
+		virtual bool clampIndex(int& i, int& j) const;
+		virtual glm::dvec2 sampleOffset() const;
 	};
 
-	// ʹβֵ
-	class CubicGridData2d : public GridData2d
+	// ֵ Policy ĳBase Ϊ GridData2d 
+	// ֵڱȷֵڲѭû麯
+	template <typename Base, typename Policy>
+	class InterpGridData2d : public Base
 	{
 	public:
-		CubicGridData2d();
-		CubicGridData2d(const CubicGridData2d& orig);
-		virtual ~CubicGridData2d();
+		typedef Policy InterpPolicy;
+		typedef typename Base::value_type T;
+
+		using Base::operator=;
+		using Base::interpolate;
+
+		InterpGridData2d();
+		InterpGridData2d(const InterpGridData2d& orig);
+		InterpGridData2d& operator=(const InterpGridData2d& orig);
+		virtual ~InterpGridData2d();
 		virtual double interpolate(const glm::vec2& pt);
 
-	protected:
-		// βֵ
-		double cubic(double q1, double q2, double q3, double q4, double t);
-		double interpX(int i, int j, double fracty, double fractx);
-		double interpY(int i, int j, double fracty);
+		// ֵ interpolate(pt) ͬԲû AVX2 ʵ
+		virtual void interpolate(const float* xs, const float* ys, double* out, std::size_t n);
+
+		// ° Policy ֵģ尴һζ룬άԼ
+		double sample(const glm::vec2& pos) const;
+
+	private:
+		void interpolateBatch(const float* xs, const float* ys, double* out, std::size_t n, std::true_type);
+		void interpolateBatch(const float* xs, const float* ys, double* out, std::size_t n, std::false_type);
 	};
+
+	// ʹõβֵ࣬4x4 ģҪ 3  ghost
+	template <typename T = double>
+	using CubicGridData2d = InterpGridData2d<GridData2d<T>, InterpMonotoneCubic>;
 }
 
 #endif
\ No newline at end of file
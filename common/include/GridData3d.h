@@ -3,18 +3,26 @@
 #define __GRID_DATA_3D_H__
 
 #pragma warning(disable: 4244 4267 4996)
-#include <boost/numeric/ublas/vector.hpp>
-#include <boost/numeric/ublas/io.hpp>
 #include <glm/glm.hpp>
+#include "GridData.h"
+#include "GridExpr.h"
+#include "Half.h"
+#include "GridInterp.h"
+#include <type_traits>
 
-namespace Glb {
+// ģʵλ GridData3d.cpp float / double / Half / uint8_t ʽʵ
 
-	using namespace boost::numeric;
+namespace Glb {
 
 	// 3Dݻ,ڴ洢ʹMACϵı
-	class GridData3d
+	// T ΪóĴ洢ͣfloat / double / uint8_t
+	template <typename T = double>
+	class GridData3d : public GridExpr<GridData3d<T> >
 	{
 	public:
+		static const bool kGridExprTerminal = true;
+		typedef T value_type;
+
 		GridData3d();
 		GridData3d(const GridData3d& orig);
 		virtual ~GridData3d();
@@ -23,13 +31,69 @@ namespace Glb {
 		// Ĭֵʼ
 		virtual void initialize(double dfltValue = 0.0);
 
-		// (i,j,k)λϵĿɸı
-		virtual double& operator()(int i, int j, int k);
+		// һͬೡݣO(1)ǰ󻺳ֻ
+		void swap(GridData3d& other);
+
+		// ÿ ghost  initialize ֮ǰ
+		void setGhostLayers(int ghost);
+
+		// άĬȡã initialize ֮ǰãز·ֱ
+		void setDim(const int* newDim);
+
+		// ѡ洢֣Ĭ Linear initialize ֮ǰãֻıڴеУıȡֵ
+		void setLayout(GridLayout layout);
+
+		// ֻ߽ʣڷȵ룩Խλ÷Ĭֵֵأڶ߳ʹ
+		T operator()(int i, int j, int k) const { return get(i, j, k); }
+		T get(int i, int j, int k) const;
+
+		// ߽д룬Խд뱻
+		void set(int i, int j, int k, T value);
+
+		// ߽ĿٷʣҪ -ghost <= i, j, k < dim + ghost
+		// ߽ȡֵ ghost У fillGhost() ά
+		T& at(int i, int j, int k) { return mData.at(i, j, k); }
+		const T& at(int i, int j, int k) const { return mData.at(i, j, k); }
+
+		// ߽ ghost 㣬д֮ʹ at() ȡ֮ǰ
+		void fillGhost();
 
 		// ꣬زֵõֵ
 		virtual double interpolate(const glm::vec3& pt);
 
-		ublas::vector<double>& data();
+		// ֵxs / ys / zs Ϊ n ꣬д out
+		//  interpolate(pt) ͬ AVX2 ʱÿ 8 һ飬 gather ָȡֵ
+		virtual void interpolate(const float* xs, const float* ys, const float* zs, double* out, std::size_t n);
+		void interpolate(const float* xs, const float* ys, const float* zs, float* out, std::size_t n);
+
+		// ʵײ洢
+		GridData<T, 3>& data();
+		const GridData<T, 3>& data() const { return mData; }
+
+		// ʽֵ u = 2.0 * u - u_backչΪһԪѭ ghost 㣩
+		template <typename E>
+		GridData3d& operator=(const GridExpr<E>& e)
+		{
+			evalGridExpr(mData.data(), mData.size(), e);
+			return *this;
+		}
+
+		GridData3d& operator*=(double s)
+		{
+			evalGridExpr(mData.data(), mData.size(), *this * s);
+			return *this;
+		}
+
+		// ֻ mask λøֵmask 뱾״ͬ u.masked(faceMask) = ...
+		GridMaskedRef<T> masked(const GridData3d<std::uint8_t>& mask)
+		{
+			assert(mask.data().size() == mData.size());
+			return GridMaskedRef<T>(mData.data(), mData.size(), mask.data().data());
+		}
+
+		// ʽֵʱ洢±Ԫضȡ
+		double operator[](std::size_t idx) const { return mData[idx]; }
+		std::size_t size() const { return mData.size(); }
 
 		// ꣬ظõڵԪ
 		virtual void getCell(const glm::vec3& pt, int& i, int& j, int& k);
@@ -38,60 +102,106 @@ namespace Glb {
 
 	protected:
 		virtual glm::vec3 worldToSelf(const glm::vec3& pt) const;
-		double mDfltValue;				// Ĭֵڳʼ
-		ublas::vector<double> mData;	    // 洢ݵһά
+
+		//  (i,j,k) ӳ䵽洢еλã false ʾλȡĬֵ
+		virtual bool clampIndex(int& i, int& j, int& k) const;
+
+		// worldToSelf мȥƫֵ˼
+		virtual glm::dvec3 sampleOffset() const;
+
+		// µԲֵ
+		double interpolateSelf(const glm::vec3& pos) const;
+
+		T mDfltValue;					// Ĭֵڳʼ
+		GridData<T, 3> mData;			// 洢ݵһά飨64ֽڶ룬 ghost 㣩
 		float cellSize;                  // ԪС
 		int dim[3];                      // ά
+		int mGhost;						// ÿ ghost 
 	};
 
 	// Xٶȷ
-	class GridData3dX : public GridData3d
+	template <typename T = double>
+	class GridData3dX : public GridData3d<T>
 	{
 	public:
+		using GridData3d<T>::operator=;
+
 		GridData3dX();
 		virtual ~GridData3dX();
 		virtual void initialize(double dfltValue = 0.0);
-		virtual double& operator()(int i, int j, int k);
 		virtual glm::vec3 worldToSelf(const glm::vec3& pt) const;
+
+	protected:
+		virtual bool clampIndex(int& i, int& j, int& k) const;
+		virtual glm::dvec3 sampleOffset() const;
 	};
 
 	// Yٶȷ
-	class GridData3dY : public GridData3d
+	template <typename T = double>
+	class GridData3dY : public GridData3d<T>
 	{
 	public:
+		using GridData3d<T>::operator=;
+
 		GridData3dY();
 		virtual ~GridData3dY();
 		virtual void initialize(double dfltValue = 0.0);
-		virtual double& operator()(int i, int j, int k);
 		virtual glm::vec3 worldToSelf(const glm::vec3& pt) const;
+
+	protected:
+		virtual bool clampIndex(int& i, int& j, int& k) const;
+		virtual glm::dvec3 sampleOffset() const;
 	};
 
 	// Zٶȷ
-	class GridData3dZ : public GridData3d
+	template <typename T = double>
+	class GridData3dZ : public GridData3d<T>
 	{
 	public:
+		using GridData3d<T>::operator=;
+
 		GridData3dZ();
 		virtual ~GridData3dZ();
 		virtual void initialize(double dfltValue = 0.0);
-		virtual double& operator()(int i, int j, int k);
 		virtual glm::vec3 worldToSelf(const glm::vec3& pt) const;
+
+	protected:
+		virtual bool clampIndex(int& i, int& j, int& k) const;
+		virtual glm::dvec3 sampleOffset() const;
 	};
 
-	// ʹβֵ
-	class CubicGridData3d : public GridData3d
+	// ֵ Policy ĳBase Ϊ GridData3d 
+	// ֵڱȷֵڲѭû麯
+	template <typename Base, typename Policy>
+	class InterpGridData3d : public Base
 	{
 	public:
-		CubicGridData3d();
-		CubicGridData3d(const CubicGridData3d& orig);
-		virtual ~CubicGridData3d();
+		typedef Policy InterpPolicy;
+		typedef typename Base::value_type T;
+
+		using Base::operator=;
+		using Base::interpolate;
+
+		InterpGridData3d();
+		InterpGridData3d(const InterpGridData3d& orig);
+		InterpGridData3d& operator=(const InterpGridData3d& orig);
+		virtual ~InterpGridData3d();
 		virtual double interpolate(const glm::vec3& pt);
 
-	protected:
-		// βֵ
-		double cubic(double q1, double q2, double q3, double q4, double t);
-		double interpX(int i, int j, int k, double fracty, double fractx);
-		double interpY(int i, int j, int k, double fracty);
+		// ֵ interpolate(pt) ͬԲû AVX2 ʵ
+		virtual void interpolate(const float* xs, const float* ys, const float* zs, double* out, std::size_t n);
+
+		// ° Policy ֵģ尴һζ룬άԼ
+		double sample(const glm::vec3& pos) const;
+
+	private:
+		void interpolateBatch(const float* xs, const float* ys, const float* zs, double* out, std::size_t n, std::true_type);
+		void interpolateBatch(const float* xs, const float* ys, const float* zs, double* out, std::size_t n, std::false_type);
 	};
+
+	// ʹõβֵ࣬4x4x4 ģҪ 3  ghost
+	template <typename T = double>
+	using CubicGridData3d = InterpGridData3d<GridData3d<T>, InterpMonotoneCubic>;
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,169 @@
+﻿#pragma once
+#ifndef __GRID_EXPR_H__
+#define __GRID_EXPR_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <cassert>
+#include <type_traits>
+
+namespace Glb {
+
+	// 场的整体算术表达式（表达式模板）
+	// 形如 u = 2.0 * u - u_back 的表达式在赋值时展开为一个逐元素循环，不产生临时场
+	// 参与运算的场必须形状相同（同一类场，含 ghost 层），按存储下标逐元素计算
+	template <typename E>
+	class GridExpr
+	{
+	public:
+		const E& self() const { return static_cast<const E&>(*this); }
+	};
+
+	// 场本身（kGridExprTerminal 为 true 的类型）在表达式中按引用保存，中间节点按值保存
+	template <typename E>
+	struct GridExprStore
+	{
+		typedef typename std::conditional<E::kGridExprTerminal, const E&, const E>::type type;
+	};
+
+	struct GridExprAdd { static double apply(double a, double b) { return a + b; } };
+	struct GridExprSub { static double apply(double a, double b) { return a - b; } };
+	struct GridExprMul { static double apply(double a, double b) { return a * b; } };
+	struct GridExprDiv { static double apply(double a, double b) { return a / b; } };
+
+	template <typename L, typename R, typename Op>
+	class GridBinaryExpr : public GridExpr<GridBinaryExpr<L, R, Op> >
+	{
+	public:
+		static const bool kGridExprTerminal = false;
+
+		GridBinaryExpr(const L& l, const R& r) : mL(l), mR(r)
+		{
+			assert(l.size() == r.size());
+		}
+
+		double operator[](std::size_t idx) const { return Op::apply(mL[idx], mR[idx]); }
+		std::size_t size() const { return mL.size(); }
+
+	private:
+		typename GridExprStore<L>::type mL;
+		typename GridExprStore<R>::type mR;
+	};
+
+	// 表达式与标量的运算，ScalarLeft 表示标量位于运算符左侧
+	template <typename E, typename Op, bool ScalarLeft>
+	class GridScalarExpr : public GridExpr<GridScalarExpr<E, Op, ScalarLeft> >
+	{
+	public:
+		static const bool kGridExprTerminal = false;
+
+		GridScalarExpr(const E& e, double s) : mE(e), mS(s) {}
+
+		double operator[](std::size_t idx) const
+		{
+			return ScalarLeft ? Op::apply(mS, mE[idx]) : Op::apply(mE[idx], mS);
+		}
+		std::size_t size() const { return mE.size(); }
+
+	private:
+		typename GridExprStore<E>::type mE;
+		double mS;
+	};
+
+	template <typename L, typename R>
+	GridBinaryExpr<L, R, GridExprAdd> operator+(const GridExpr<L>& l, const GridExpr<R>& r)
+	{
+		return GridBinaryExpr<L, R, GridExprAdd>(l.self(), r.self());
+	}
+
+	template <typename L, typename R>
+	GridBinaryExpr<L, R, GridExprSub> operator-(const GridExpr<L>& l, const GridExpr<R>& r)
+	{
+		return GridBinaryExpr<L, R, GridExprSub>(l.self(), r.self());
+	}
+
+	template <typename L, typename R>
+	GridBinaryExpr<L, R, GridExprMul> operator*(const GridExpr<L>& l, const GridExpr<R>& r)
+	{
+		return GridBinaryExpr<L, R, GridExprMul>(l.self(), r.self());
+	}
+
+	template <typename E>
+	GridScalarExpr<E, GridExprMul, true> operator*(double s, const GridExpr<E>& e)
+	{
+		return GridScalarExpr<E, GridExprMul, true>(e.self(), s);
+	}
+
+	template <typename E>
+	GridScalarExpr<E, GridExprMul, false> operator*(const GridExpr<E>& e, double s)
+	{
+		return GridScalarExpr<E, GridExprMul, false>(e.self(), s);
+	}
+
+	template <typename E>
+	GridScalarExpr<E, GridExprDiv, false> operator/(const GridExpr<E>& e, double s)
+	{
+		return GridScalarExpr<E, GridExprDiv, false>(e.self(), s);
+	}
+
+	template <typename E>
+	GridScalarExpr<E, GridExprAdd, false> operator+(const GridExpr<E>& e, double s)
+	{
+		return GridScalarExpr<E, GridExprAdd, false>(e.self(), s);
+	}
+
+	template <typename E>
+	GridScalarExpr<E, GridExprSub, false> operator-(const GridExpr<E>& e, double s)
+	{
+		return GridScalarExpr<E, GridExprSub, false>(e.self(), s);
+	}
+
+	// 逐元素求值写入 dst，dst 可以同时出现在表达式中（同一下标先读后写）
+	template <typename T, typename E>
+	void evalGridExpr(T* dst, std::size_t n, const GridExpr<E>& e)
+	{
+		const E& expr = e.self();
+		assert(expr.size() == n);
+		for (std::size_t idx = 0; idx < n; idx++)
+			dst[idx] = (T)expr[idx];
+	}
+
+	// 只写入 mask 非零的位置，其余位置保持原值；写成选择形式以便编译器向量化
+	template <typename T, typename E>
+	void evalGridExpr(T* dst, std::size_t n, const GridExpr<E>& e, const std::uint8_t* mask)
+	{
+		const E& expr = e.self();
+		assert(expr.size() == n);
+		for (std::size_t idx = 0; idx < n; idx++)
+			dst[idx] = mask[idx] ? (T)expr[idx] : dst[idx];
+	}
+
+	// 带掩码的赋值目标，由 GridData2d / GridData3d::masked() 返回
+	template <typename T>
+	class GridMaskedRef
+	{
+	public:
+		GridMaskedRef(T* dst, std::size_t n, const std::uint8_t* mask) : mDst(dst), mSize(n), mMask(mask) {}
+
+		template <typename E>
+		GridMaskedRef& operator=(const GridExpr<E>& e)
+		{
+			evalGridExpr(mDst, mSize, e, mMask);
+			return *this;
+		}
+
+		GridMaskedRef& operator*=(double s)
+		{
+			for (std::size_t idx = 0; idx < mSize; idx++)
+				mDst[idx] = mMask[idx] ? (T)(mDst[idx] * s) : mDst[idx];
+			return *this;
+		}
+
+	private:
+		T* mDst;
+		std::size_t mSize;
+		const std::uint8_t* mMask;
+	};
+}
+
+#endif
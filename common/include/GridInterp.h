@@ -0,0 +1,134 @@
+﻿#pragma once
+#ifndef __GRID_INTERP_H__
+#define __GRID_INTERP_H__
+
+namespace Glb {
+
+	// 插值策略：在编译期为每个场选择插值方法，内层循环没有虚函数调用
+	// 多维插值按 y、x、z 的顺序逐维归约，每一维调用一次 reduce：
+	//   kWidth            每一维模板的采样个数
+	//   kGhost            模板需要的 ghost 层数
+	//   stencil(i, idx)   单元 i 的模板下标，写入 idx[0..kWidth)
+	//   reduce(q, t)      由 kWidth 个采样值求单元内比例 t 处的值
+
+	// 线性插值，结果与 GridData2d / GridData3d 的默认插值相同
+	struct InterpLinear
+	{
+		static const int kWidth = 2;
+		static const int kGhost = 2;
+
+		static void stencil(int i, int* idx)
+		{
+			idx[0] = i;
+			idx[1] = i + 1;
+		}
+
+		static double reduce(const double* q, double t)
+		{
+			return (1 - t) * q[0] + t * q[1];
+		}
+	};
+
+	// Catmull-Rom 三次插值，C1 连续，可能产生过冲
+	struct InterpCatmullRom
+	{
+		static const int kWidth = 4;
+		static const int kGhost = 3;
+
+		static void stencil(int i, int* idx)
+		{
+			idx[0] = i - 1;
+			idx[1] = i;
+			idx[2] = i + 1;
+			idx[3] = i + 2;
+		}
+
+		static double reduce(const double* q, double t)
+		{
+			return 0.5 * (2 * q[1] + (q[2] - q[0]) * t +
+				(2 * q[0] - 5 * q[1] + 4 * q[2] - q[3]) * t * t +
+				(3 * (q[1] - q[2]) + q[3] - q[0]) * t * t * t);
+		}
+	};
+
+	// 单调三次插值（CubicGridData 使用的方法）
+	// 端点斜率与区间差分符号相反时置零，避免过冲；下边界处模板第一个点退化为自身
+	struct InterpMonotoneCubic
+	{
+		static const int kWidth = 4;
+		static const int kGhost = 3;
+
+		static void stencil(int i, int* idx)
+		{
+			idx[0] = i - 1 < 0 ? i : i - 1;
+			idx[1] = i;
+			idx[2] = i + 1;
+			idx[3] = i + 2;
+		}
+
+		static double reduce(const double* q, double t)
+		{
+			double deltaq = q[2] - q[1];
+			double d1 = (q[2] - q[0]) * 0.5;
+			double d2 = (q[3] - q[1]) * 0.5;
+
+			if (deltaq > 0.0001)
+			{
+				d1 = d1 > 0 ? d1 : 0.0;
+				d2 = d2 > 0 ? d2 : 0.0;
+			}
+			else if (deltaq < 0.0001)
+			{
+				d1 = d1 < 0 ? d1 : 0.0;
+				d2 = d2 < 0 ? d2 : 0.0;
+			}
+
+			return q[1] + d1 * t + (3 * deltaq - 2 * d1 - d2) * t * t + (-2 * deltaq + d1 + d2) * t * t * t;
+		}
+	};
+
+	// 二次 B 样条，只用离采样点最近的 3 个值，不经过采样点但比三次插值便宜且无过冲
+	struct InterpQuadraticBSpline
+	{
+		static const int kWidth = 4;
+		static const int kGhost = 3;
+
+		static void stencil(int i, int* idx)
+		{
+			idx[0] = i - 1;
+			idx[1] = i;
+			idx[2] = i + 1;
+			idx[3] = i + 2;
+		}
+
+		static double reduce(const double* q, double t)
+		{
+			// 以最近的采样点为中心，d 为到中心的偏移，取值 [-0.5, 0.5)
+			bool upper = t >= 0.5;
+			const double* c = upper ? q + 1 : q;
+			double d = upper ? t - 1.0 : t;
+			double a = 0.5 - d;
+			double b = 0.5 + d;
+			return 0.5 * a * a * c[0] + (0.75 - d * d) * c[1] + 0.5 * b * b * c[2];
+		}
+	};
+
+	// 一组场使用的插值策略
+	template <typename VelocityPolicy, typename ScalarPolicy>
+	struct InterpPolicySet
+	{
+		typedef VelocityPolicy Velocity;	// 速度分量
+		typedef ScalarPolicy Scalar;		// 密度、温度
+	};
+
+	// 默认策略集合，可在编译时通过 FLUID_VELOCITY_INTERP / FLUID_SCALAR_INTERP 替换
+#ifndef FLUID_VELOCITY_INTERP
+#define FLUID_VELOCITY_INTERP InterpLinear
+#endif
+#ifndef FLUID_SCALAR_INTERP
+#define FLUID_SCALAR_INTERP InterpMonotoneCubic
+#endif
+	typedef InterpPolicySet<FLUID_VELOCITY_INTERP, FLUID_SCALAR_INTERP> DefaultInterpPolicies;
+}
+
+#endif
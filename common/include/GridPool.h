@@ -0,0 +1,55 @@
+﻿#pragma once
+#ifndef __GRID_POOL_H__
+#define __GRID_POOL_H__
+
+#include <cstddef>
+#include <map>
+#include <mutex>
+
+namespace Glb {
+
+	// 场存储的内存池
+	// 释放的大块内存按字节数缓存，重新初始化同样尺寸的网格（Rerun、切换方法后再切回）时直接复用，不再向系统申请
+	// Linux 下达到 2MB 的块按 2MB 对齐并申请透明大页（THP），减少大场遍历时的 TLB 缺失；其他平台按普通方式申请
+	class GridMemoryPool
+	{
+	public:
+		// 小于该字节数的块不经过内存池
+		static const std::size_t kMinPooledBytes = 64 * 1024;
+		// 透明大页的尺寸
+		static const std::size_t kHugePageBytes = 2 * 1024 * 1024;
+		// 缓存的空闲块总量上限，超出时直接归还系统
+		static const std::size_t kMaxCachedBytes = (std::size_t)512 * 1024 * 1024;
+
+		// 单例模式获取实例；实例不析构，静态对象在程序退出时仍可归还内存
+		static GridMemoryPool& getInstance()
+		{
+			static GridMemoryPool* instance = new GridMemoryPool();
+			return *instance;
+		}
+
+		// 申请 bytes 字节、至少 64 字节对齐的内存，失败时抛出 std::bad_alloc
+		void* acquire(std::size_t bytes);
+		// 归还 acquire 得到的内存，bytes 必须与申请时一致
+		void release(void* p, std::size_t bytes);
+		// 把缓存的空闲块全部归还系统
+		void trim();
+
+		// 当前缓存的空闲块字节数
+		std::size_t cachedBytes() const;
+
+	private:
+		GridMemoryPool() : mCachedBytes(0) {}
+		GridMemoryPool(const GridMemoryPool&);
+		GridMemoryPool& operator=(const GridMemoryPool&);
+
+		static void* systemAlloc(std::size_t bytes);
+		static void systemFree(void* p);
+
+		std::multimap<std::size_t, void*> mFree;	// 字节数 -> 空闲块
+		std::size_t mCachedBytes;					// mFree 中所有块的字节数之和
+		mutable std::mutex mMutex;
+	};
+}
+
+#endif
@@ -0,0 +1,100 @@
+﻿#pragma once
+#ifndef __GRID_SIMD_H__
+#define __GRID_SIMD_H__
+
+#include <cstddef>
+#include <cstdint>
+
+// 批量插值使用的 AVX2 辅助函数，编译时开启 AVX2（MSVC /arch:AVX2，GCC/Clang -mavx2）才会启用
+// 未开启时只保留标量路径
+#if defined(__AVX2__)
+#define GRID_SIMD_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace Glb {
+
+#if defined(GRID_SIMD_AVX2)
+
+	// 8 个 float 拆成低、高两组 double
+	inline void simdWiden(__m256 v, __m256d& lo, __m256d& hi)
+	{
+		lo = _mm256_cvtps_pd(_mm256_castps256_ps128(v));
+		hi = _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1));
+	}
+
+	// 两组 double 合并为 8 个 float
+	inline __m256 simdNarrow(__m256d lo, __m256d hi)
+	{
+		return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm256_cvtpd_ps(lo)), _mm256_cvtpd_ps(hi), 1);
+	}
+
+	// 与 worldToSelf 相同的运算顺序：在 double 中平移、钳制到 [0, maxv]，再存为 float
+	inline __m256 simdToSelf(__m256 x, double offset, double maxv)
+	{
+		__m256d lo, hi;
+		simdWiden(x, lo, hi);
+		const __m256d off = _mm256_set1_pd(offset);
+		const __m256d zero = _mm256_setzero_pd();
+		const __m256d mx = _mm256_set1_pd(maxv);
+		lo = _mm256_min_pd(_mm256_max_pd(_mm256_sub_pd(lo, off), zero), mx);
+		hi = _mm256_min_pd(_mm256_max_pd(_mm256_sub_pd(hi, off), zero), mx);
+		return simdNarrow(lo, hi);
+	}
+
+	// 单元下标 (int)(pos / cellSize) 与单元内比例 scale * (pos - i * cellSize)
+	inline __m256i simdCell(__m256 pos, float cellSize, double scale, __m256d& fracLo, __m256d& fracHi)
+	{
+		const __m256 h = _mm256_set1_ps(cellSize);
+		__m256i i = _mm256_cvttps_epi32(_mm256_div_ps(pos, h));
+		__m256 rest = _mm256_sub_ps(pos, _mm256_mul_ps(_mm256_cvtepi32_ps(i), h));
+		simdWiden(rest, fracLo, fracHi);
+		const __m256d s = _mm256_set1_pd(scale);
+		fracLo = _mm256_mul_pd(s, fracLo);
+		fracHi = _mm256_mul_pd(s, fracHi);
+		return i;
+	}
+
+	// LERP(a, b, t) = (1 - t) * a + t * b，与标量宏的运算顺序一致
+	inline __m256d simdLerp(__m256d a, __m256d b, __m256d t)
+	{
+		const __m256d one = _mm256_set1_pd(1.0);
+		return _mm256_add_pd(_mm256_mul_pd(_mm256_sub_pd(one, t), a), _mm256_mul_pd(t, b));
+	}
+
+	// 按 8 个下标读取场值并转换为 double；float / double 使用 gather 指令，其余类型逐个读取
+	template <typename T>
+	struct SimdGather
+	{
+		static void load(const T* base, __m256i idx, __m256d& lo, __m256d& hi)
+		{
+			alignas(32) std::int32_t ii[8];
+			_mm256_store_si256((__m256i*)ii, idx);
+			lo = _mm256_set_pd((double)base[ii[3]], (double)base[ii[2]], (double)base[ii[1]], (double)base[ii[0]]);
+			hi = _mm256_set_pd((double)base[ii[7]], (double)base[ii[6]], (double)base[ii[5]], (double)base[ii[4]]);
+		}
+	};
+
+	template <>
+	struct SimdGather<float>
+	{
+		static void load(const float* base, __m256i idx, __m256d& lo, __m256d& hi)
+		{
+			simdWiden(_mm256_i32gather_ps(base, idx, 4), lo, hi);
+		}
+	};
+
+	template <>
+	struct SimdGather<double>
+	{
+		static void load(const double* base, __m256i idx, __m256d& lo, __m256d& hi)
+		{
+			lo = _mm256_i32gather_pd(base, _mm256_castsi256_si128(idx), 8);
+			hi = _mm256_i32gather_pd(base, _mm256_extracti128_si256(idx, 1), 8);
+		}
+	};
+
+#endif
+}
+
+#endif
@@ -0,0 +1,98 @@
+﻿#pragma once
+#ifndef __HALF_H__
+#define __HALF_H__
+
+#include <cstdint>
+#include <cstring>
+
+namespace Glb {
+
+	// IEEE 754 半精度浮点数（binary16）的存储类型
+	// 只用于存储：读取时转换为 float 参与计算，写入时按最近偶数舍入
+	// 11 位有效数字足够表示密度、温度等被动标量，内存与带宽减半
+	class Half
+	{
+	public:
+		Half() : mBits(0) {}
+		Half(float v) : mBits(fromFloat(v)) {}
+		Half(double v) : mBits(fromFloat((float)v)) {}
+		Half(int v) : mBits(fromFloat((float)v)) {}
+
+		operator float() const { return toFloat(mBits); }
+
+		std::uint16_t bits() const { return mBits; }
+
+		static std::uint16_t fromFloat(float v)
+		{
+			std::uint32_t x;
+			std::memcpy(&x, &v, sizeof(x));
+			std::uint32_t sign = (x >> 16) & 0x8000u;
+			std::uint32_t absx = x & 0x7fffffffu;
+
+			if (absx >= 0x7f800000u)	// Inf / NaN
+				return (std::uint16_t)(sign | 0x7c00u | (absx > 0x7f800000u ? 0x200u : 0u));
+			if (absx >= 0x477ff000u)	// 超出半精度范围，溢出为 Inf
+				return (std::uint16_t)(sign | 0x7c00u);
+			if (absx < 0x38800000u) {	// 非规格化数或 0
+				if (absx < 0x33000000u)
+					return (std::uint16_t)sign;
+				std::uint32_t mant = (absx & 0x007fffffu) | 0x00800000u;
+				int shift = 126 - (int)(absx >> 23);
+				std::uint32_t half = mant >> shift;
+				std::uint32_t rest = mant & ((1u << shift) - 1u);
+				std::uint32_t mid = 1u << (shift - 1);
+				if (rest > mid || (rest == mid && (half & 1u)))
+					half++;
+				return (std::uint16_t)(sign | half);
+			}
+			// 规格化数：重新偏置指数，尾数按最近偶数舍入（进位可自然进入指数位）
+			std::uint32_t half = ((absx - 0x38000000u) >> 13);
+			std::uint32_t rest = absx & 0x1fffu;
+			if (rest > 0x1000u || (rest == 0x1000u && (half & 1u)))
+				half++;
+			return (std::uint16_t)(sign | half);
+		}
+
+		static float toFloat(std::uint16_t h)
+		{
+			std::uint32_t sign = (std::uint32_t)(h & 0x8000u) << 16;
+			std::uint32_t exp = (h >> 10) & 0x1fu;
+			std::uint32_t mant = h & 0x3ffu;
+			std::uint32_t x;
+			if (exp == 0) {
+				if (mant == 0) {
+					x = sign;
+				}
+				else {	// 非规格化数，规格化后转换
+					exp = 113;
+					while ((mant & 0x400u) == 0) {
+						mant <<= 1;
+						exp--;
+					}
+					x = sign | (exp << 23) | ((mant & 0x3ffu) << 13);
+				}
+			}
+			else if (exp == 0x1f) {
+				x = sign | 0x7f800000u | (mant << 13);
+			}
+			else {
+				x = sign | ((exp + 112) << 23) | (mant << 13);
+			}
+			float v;
+			std::memcpy(&v, &x, sizeof(v));
+			return v;
+		}
+
+	private:
+		std::uint16_t mBits;
+	};
+
+	// 被动标量（密度、温度）的 CPU 端存储类型，由 CMake 选项 FLUID_HALF_SCALARS 选择
+#ifdef FLUID_HALF_SCALARS
+	typedef Half ScalarStorage;
+#else
+	typedef float ScalarStorage;
+#endif
+}
+
+#endif
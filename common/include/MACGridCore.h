@@ -0,0 +1,350 @@
+﻿#pragma once
+#ifndef __MAC_GRID_CORE_H__
+#define __MAC_GRID_CORE_H__
+
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+#include <glm/glm.hpp>
+#include "Logger.h"
+#include "GridData.h"
+
+namespace Glb {
+
+	// CPU 端对流的格式，与 Eulerian2dPara::advectionScheme、Eulerian3dPara::advectionScheme 的取值对应
+	enum AdvectionScheme
+	{
+		kAdvectSemiLagrangian = 0,	// 一次回溯插值
+		kAdvectMacCormack = 1,		// 正反两次对流估计误差后修正，多两次插值
+		kAdvectBFECC = 2			// 修正初值后再对流一次，多三次插值
+	};
+
+	// 2D / 3D MAC 网格共用的几何与离散算子，N 为维数
+	// Derived 为具体网格类（CRTP），需要提供：
+	//   int solidAt(const int* c)                     固体标记（c 在容器内）
+	//   double faceAt(int axis, const int* c)         axis 方向速度分量在面 c 上的值（不做边界检查）
+	//   Vec getVelocity(const Vec& pt)                任意位置的速度
+	//   void cellOf(const Vec& pt, int* c)            位置所在的单元
+	// 单元下标 c 为长度 N 的数组，第 d 个分量对应第 d 维
+	template <int N, typename Derived>
+	class MACGridCore
+	{
+	public:
+		typedef glm::vec<N, float, glm::defaultp> Vec;
+
+		// 单元标记位，见 mCellFlags
+		enum CellFlag
+		{
+			kCellSolid = 1 << 0,		// 固体或容器外
+			kCellFluid = 1 << 1,		// 流体
+			kCellBoundary = 1 << 2,		// 紧贴容器壁的单元
+			kCellNeighborShift = 3,		// 自第 3 位起，第 2 * axis + (side > 0) 位表示该方向的邻居为固体
+			kCellCountShift = 12		// 高 4 位为固体邻居（含容器外）的个数
+		};
+
+		float cellSize;             // 网格单元大小
+		int dim[N];                 // 网格维度
+
+		static std::uint16_t neighborBit(int axis, int side)
+		{
+			return (std::uint16_t)(1u << (kCellNeighborShift + 2 * axis + (side > 0 ? 1 : 0)));
+		}
+
+		static int solidNeighborCount(std::uint16_t flags) { return flags >> kCellCountShift; }
+
+		// 单元 c 的标记，要求 0 <= c < dim；ghost 层（容器外）为 kCellSolid
+		std::uint16_t cellFlags(const int* c) const
+		{
+			return N == 2 ? mCellFlags.at(c[0], c[1]) : mCellFlags.at(c[0], c[1], c[N - 1]);
+		}
+
+		// 按固体标记重建所有单元的标记，在 createSolids 之后调用
+		void buildCellFlags()
+		{
+			mCellFlags.resize(dim, 1);
+			mCellFlags.fill((std::uint16_t)kCellSolid);
+			int c[N];
+			for (int d = 0; d < N; d++) c[d] = 0;
+			while (true) {
+				setCellFlags(c, computeCellFlags(c));
+				int d = 0;
+				while (d < N && ++c[d] >= dim[d]) {
+					c[d] = 0;
+					d++;
+				}
+				if (d == N)
+					break;
+			}
+		}
+
+		// 单元 c 的固体标记改变后，增量更新它和相邻单元的标记
+		void updateCellFlags(const int* c)
+		{
+			if (!inside(c))
+				return;
+			setCellFlags(c, computeCellFlags(c));
+			for (int axis = 0; axis < N; axis++)
+				for (int side = -1; side <= 1; side += 2) {
+					int nb[N];
+					neighbor(c, axis, side, nb);
+					if (inside(nb))
+						setCellFlags(nb, computeCellFlags(nb));
+				}
+		}
+
+		// 单元中心
+		Vec getCenter(const int* c) const
+		{
+			double start = cellSize / 2.0;
+			Vec p;
+			for (int d = 0; d < N; d++)
+				p[d] = start + c[d] * cellSize;
+			return p;
+		}
+
+		// 单元在 axis 方向上的面中心，side 为 -1（下侧）或 +1（上侧）
+		Vec getFace(const int* c, int axis, int side) const
+		{
+			Vec p = getCenter(c);
+			float half = cellSize * 0.5;
+			p[axis] = side < 0 ? p[axis] - half : p[axis] + half;
+			return p;
+		}
+
+		// 单元的线性编号，容器外返回 -1
+		// 编号顺序与 GridData 的 Linear 布局一致：第 0 维最内层，其后依次为第 N-1, ..., 1 维
+		int getIndex(const int* c) const
+		{
+			for (int d = 0; d < N; d++)
+				if (c[d] < 0 || c[d] > dim[d] - 1)
+					return -1;
+			int index = 0;
+			for (int n = N - 1; n >= 0; n--) {
+				int d = order(n);
+				index = index * dim[d] + c[d];
+			}
+			return index;
+		}
+
+		void getCell(int index, int* c) const
+		{
+			for (int n = 0; n < N; n++) {
+				int d = order(n);
+				c[d] = index % dim[d];
+				index /= dim[d];
+			}
+		}
+
+		// 只有一维相差 1 的两个单元互为邻居
+		bool isNeighbor(const int* a, const int* b) const
+		{
+			int diff = 0, same = 0;
+			for (int d = 0; d < N; d++) {
+				int delta = std::abs(a[d] - b[d]);
+				diff += delta == 1;
+				same += delta == 0;
+			}
+			return diff == 1 && same == N - 1;
+		}
+
+		// axis 方向的面 c 是否在范围内
+		bool isValid(const int* c, int axis) const
+		{
+			for (int d = 0; d < N; d++)
+				if (c[d] < 0 || c[d] >= dim[d] + (d == axis ? 1 : 0))
+					return false;
+			return true;
+		}
+
+		// 容器外或固体单元返回 1
+		int isSolidCell(const int* c)
+		{
+			for (int d = 0; d < N; d++)
+				if (c[d] < 0 || c[d] > dim[d] - 1)
+					return 1;
+			return self().solidAt(c) == 1 ? 1 : 0;
+		}
+
+		// 容器边界上的面，或与固体单元相邻的面返回 1
+		int isSolidFace(const int* c, int axis)
+		{
+			if (c[axis] == 0 || c[axis] == dim[axis])
+				return 1;
+			int lower[N];
+			neighbor(c, axis, -1, lower);
+			return (self().solidAt(c) || self().solidAt(lower)) ? 1 : 0;
+		}
+
+		// 单元的散度，与固体相邻的面按零速度计算；邻居是否为固体取自预先建立的标记
+		double getDivergence(const int* c)
+		{
+			assert(inside(c));
+			std::uint16_t flags = cellFlags(c);
+			double sum = 0.0;
+			for (int axis = 0; axis < N; axis++) {
+				int upper[N];
+				neighbor(c, axis, 1, upper);
+				double v1 = (flags & neighborBit(axis, 1)) ? 0.0 : self().faceAt(axis, upper);
+				double v0 = (flags & neighborBit(axis, -1)) ? 0.0 : self().faceAt(axis, c);
+				sum += v1 - v0;
+			}
+			return sum / cellSize;
+		}
+
+		// 压力方程的系数：对角项为非固体邻居数，非固体邻居为 -1，其余为 0
+		double getPressureCoeffBetweenCells(const int* c, const int* p)
+		{
+			bool isSelf = true;
+			for (int d = 0; d < N; d++)
+				isSelf = isSelf && c[d] == p[d];
+			if (isSelf)
+				return 2.0 * N - solidNeighborCount(cellFlags(c));
+			if (isNeighbor(c, p) && !isSolidCell(p))
+				return -1.0;
+			return 0.0;
+		}
+
+		// 半拉格朗日回溯：终点钳制到单元中心的范围内，起点在固体中时沿速度方向退出该单元
+		Vec semiLagrangian(const Vec& pt, double dt)
+		{
+			Vec vel = self().getVelocity(pt);
+			return exitSolid(pt, vel, clampToCenters(pt - vel * (float)dt));
+		}
+
+		// 按 order 阶的 Runge-Kutta 回溯：1 为前向 Euler（同 semiLagrangian），2 为中点法，3 为 Ralston 三阶法
+		// 中间各阶段的位置同样钳制到单元中心的范围内；dt 为负时沿速度正向追踪
+		Vec backtrace(const Vec& pt, double dt, int order)
+		{
+			if (order <= 1)
+				return semiLagrangian(pt, dt);
+			Vec k1 = self().getVelocity(pt);
+			Vec k2 = self().getVelocity(clampToCenters(pt - k1 * (float)(0.5 * dt)));
+			Vec vel = k2;
+			if (order >= 3) {
+				Vec k3 = self().getVelocity(clampToCenters(pt - k2 * (float)(0.75 * dt)));
+				vel = k1 * (2.0f / 9.0f) + k2 * (3.0f / 9.0f) + k3 * (4.0f / 9.0f);
+			}
+			return exitSolid(pt, k1, clampToCenters(pt - vel * (float)dt));
+		}
+
+		// 位置钳制到单元中心的范围内
+		Vec clampToCenters(Vec pos) const
+		{
+			for (int d = 0; d < N; d++)
+				pos[d] = (std::max)(0.0, (double)(std::min)((dim[d] - 1) * cellSize, pos[d]));
+			return pos;
+		}
+
+		// 起点 pt 在固体单元中时，改为沿速度 vel 退出该单元的位置，否则返回 pos
+		Vec exitSolid(const Vec& pt, const Vec& vel, Vec pos)
+		{
+			int c[N];
+			self().cellOf(pt, c);
+			if (isSolidCell(c) == 1)
+			{
+				double t = 0;
+				if (intersects(pt, vel, c, t))
+				{
+					pos = pt - vel * (float)t;
+				}
+				else
+				{
+					Logger::getInstance().addLog("Error: something goes wrong during advection");
+				}
+			}
+			return pos;
+		}
+
+		// 射线与单元 c 的包围盒求交（slab 方法），time 为交点参数
+		bool intersects(const Vec& wPos, const Vec& wDir, const int* c, double& time) const
+		{
+			Vec rayStart = wPos - getCenter(c);
+
+			double tmin = -9999999999.0;
+			double tmax = 9999999999.0;
+
+			double lo = -0.5 * cellSize;
+			double hi = 0.5 * cellSize;
+
+			for (int d = 0; d < N; d++)
+			{
+				double e = rayStart[d];
+				double f = wDir[d];
+				if (std::fabs(f) > 0.000000001)
+				{
+					double t1 = (lo - e) / f;
+					double t2 = (hi - e) / f;
+					if (t1 > t2)
+						std::swap(t1, t2);
+					if (t1 > tmin)
+						tmin = t1;
+					if (t2 < tmax)
+						tmax = t2;
+					if (tmin > tmax)
+						return false;
+					if (tmax < 0)
+						return false;
+				}
+				else if (e < lo || e > hi)
+					return false;
+			}
+			time = tmin >= 0 ? tmin : tmax;
+			return true;
+		}
+
+	protected:
+		Derived& self() { return static_cast<Derived&>(*this); }
+
+		bool inside(const int* c) const
+		{
+			for (int d = 0; d < N; d++)
+				if (c[d] < 0 || c[d] > dim[d] - 1)
+					return false;
+			return true;
+		}
+
+		std::uint16_t computeCellFlags(const int* c)
+		{
+			unsigned flags = isSolidCell(c) ? kCellSolid : kCellFluid;
+			unsigned count = 0;
+			for (int axis = 0; axis < N; axis++)
+				for (int side = -1; side <= 1; side += 2) {
+					int nb[N];
+					neighbor(c, axis, side, nb);
+					if (!inside(nb))
+						flags |= kCellBoundary;
+					if (isSolidCell(nb)) {
+						flags |= neighborBit(axis, side);
+						count++;
+					}
+				}
+			return (std::uint16_t)(flags | (count << kCellCountShift));
+		}
+
+		void setCellFlags(const int* c, std::uint16_t flags)
+		{
+			if (N == 2)
+				mCellFlags.at(c[0], c[1]) = flags;
+			else
+				mCellFlags.at(c[0], c[1], c[N - 1]) = flags;
+		}
+
+		// 每个单元一个 16 位标记：固体 / 流体 / 靠壁位、各方向固体邻居位与固体邻居个数
+		// 含 1 层 ghost，压力迭代与散度计算直接读取，不再逐个判断邻居
+		GridData<std::uint16_t, N> mCellFlags;
+
+		static void neighbor(const int* c, int axis, int offset, int* out)
+		{
+			for (int d = 0; d < N; d++)
+				out[d] = c[d];
+			out[axis] += offset;
+		}
+
+		// 线性编号中由内到外的第 n 维：0, N-1, ..., 1
+		static int order(int n) { return n == 0 ? 0 : N - n; }
+	};
+}
+
+#endif
@@ -0,0 +1,53 @@
+﻿#pragma once
+#ifndef __MAPPED_FILE_H__
+#define __MAPPED_FILE_H__
+
+#include <cstddef>
+#include <string>
+
+namespace Glb {
+
+	// 以读写方式映射到内存的文件
+	// 数据由操作系统按页换入换出，可以超过物理内存；prefetch / evict 只是给内核的建议，不影响正确性
+	class MappedFile
+	{
+	public:
+		MappedFile();
+		~MappedFile();
+
+		// 创建（已存在则截断）大小为 bytes 的文件并映射，失败返回 false
+		bool open(const std::string& path, std::size_t bytes);
+		void close();
+
+		bool isOpen() const { return mData != NULL; }
+		void* data() { return mData; }
+		const void* data() const { return mData; }
+		std::size_t size() const { return mSize; }
+
+		// 提前读入 [offset, offset + bytes)（Linux: MADV_WILLNEED）
+		void prefetch(std::size_t offset, std::size_t bytes);
+		// 写回并释放 [offset, offset + bytes) 中的整页，之后再访问会重新从文件读入
+		void evict(std::size_t offset, std::size_t bytes);
+		// 把全部修改写回文件
+		void flush();
+		// 交换两个映射，不复制数据
+		void swap(MappedFile& other);
+
+		static std::size_t pageSize();
+
+	private:
+		MappedFile(const MappedFile&);
+		MappedFile& operator=(const MappedFile&);
+
+		void* mData;
+		std::size_t mSize;
+#if defined(_WIN32)
+		void* mFile;		// HANDLE
+		void* mMapping;		// HANDLE
+#else
+		int mFd;
+#endif
+	};
+}
+
+#endif
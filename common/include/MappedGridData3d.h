@@ -0,0 +1,203 @@
+﻿#pragma once
+#ifndef __MAPPED_GRID_DATA_3D_H__
+#define __MAPPED_GRID_DATA_3D_H__
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "MappedFile.h"
+#include "GridData.h"
+
+namespace Glb {
+
+	// 按 z 层（slab）管理驻留的映射存储，与值类型无关，便于对多个场统一预取、释放
+	class MappedSlabStorage
+	{
+	public:
+		MappedSlabStorage() : mElementBytes(0)
+		{
+			mExtent[0] = mExtent[1] = mExtent[2] = 0;
+		}
+
+		int extent(int d) const { return mExtent[d]; }
+		std::size_t size() const { return (std::size_t)mExtent[0] * mExtent[1] * mExtent[2]; }
+		std::size_t slabBytes() const { return (std::size_t)mExtent[0] * mExtent[1] * mElementBytes; }
+
+		// 提示内核读入 [k0, k1) 层，超出范围的部分被忽略
+		void prefetchSlabs(int k0, int k1)
+		{
+			k0 = (std::max)(k0, 0);
+			k1 = (std::min)(k1, mExtent[2]);
+			if (k0 < k1)
+				mFile.prefetch(k0 * slabBytes(), (k1 - k0) * slabBytes());
+		}
+
+		// 写回并释放 [k0, k1) 层
+		void evictSlabs(int k0, int k1)
+		{
+			k0 = (std::max)(k0, 0);
+			k1 = (std::min)(k1, mExtent[2]);
+			if (k0 < k1)
+				mFile.evict(k0 * slabBytes(), (k1 - k0) * slabBytes());
+		}
+
+		void flush() { mFile.flush(); }
+
+	protected:
+		bool openStorage(const std::string& path, int n0, int n1, int n2, std::size_t elementBytes)
+		{
+			mExtent[0] = n0;
+			mExtent[1] = n1;
+			mExtent[2] = n2;
+			mElementBytes = elementBytes;
+			return mFile.open(path, size() * elementBytes);
+		}
+
+		MappedFile mFile;
+		int mExtent[3];
+		std::size_t mElementBytes;
+
+	private:
+		MappedSlabStorage(const MappedSlabStorage&);
+		MappedSlabStorage& operator=(const MappedSlabStorage&);
+	};
+
+	// 存放在内存映射文件中的 3D 场，用于超过物理内存的离线网格
+	// 下标顺序与 GPU 端缓冲一致：i + j * n0 + k * n0 * n1，同一 z 层在文件中连续
+	// 按 z 层窗口遍历时用 prefetchSlabs / evictSlabs 控制驻留的层，窗口之外的读写仍然正确，只是会缺页
+	template <typename T>
+	class MappedGridData3d : public MappedSlabStorage
+	{
+	public:
+		typedef T value_type;
+
+		MappedGridData3d() : mData(NULL) {}
+
+		// 在 path 创建 n0 x n1 x n2 的场并映射，初值为 0（稀疏文件），失败返回 false
+		bool open(const std::string& path, int n0, int n1, int n2)
+		{
+			mData = openStorage(path, n0, n1, n2, sizeof(T)) ? static_cast<T*>(mFile.data()) : NULL;
+			return mData != NULL;
+		}
+
+		std::size_t index(int i, int j, int k) const
+		{
+			return (std::size_t)i + (std::size_t)mExtent[0] * ((std::size_t)j + (std::size_t)mExtent[1] * k);
+		}
+
+		T& at(int i, int j, int k) { return mData[index(i, j, k)]; }
+		const T& at(int i, int j, int k) const { return mData[index(i, j, k)]; }
+
+		// 下标钳制到有效范围后读取
+		T clamped(int i, int j, int k) const
+		{
+			i = (std::min)((std::max)(i, 0), mExtent[0] - 1);
+			j = (std::min)((std::max)(j, 0), mExtent[1] - 1);
+			k = (std::min)((std::max)(k, 0), mExtent[2] - 1);
+			return mData[index(i, j, k)];
+		}
+
+		// 下标空间中的三线性插值，样本 (i, j, k) 位于坐标 (i, j, k)，坐标先钳制到有效范围
+		double trilinear(double x, double y, double z) const
+		{
+			double p[3] = { x, y, z };
+			int c[3], n[3];
+			double t[3];
+			for (int d = 0; d < 3; d++) {
+				double v = (std::min)((std::max)(p[d], 0.0), (double)(mExtent[d] - 1));
+				c[d] = (int)v;
+				n[d] = (std::min)(c[d] + 1, mExtent[d] - 1);
+				t[d] = v - c[d];
+			}
+			double c00 = (1 - t[0]) * at(c[0], c[1], c[2]) + t[0] * at(n[0], c[1], c[2]);
+			double c10 = (1 - t[0]) * at(c[0], n[1], c[2]) + t[0] * at(n[0], n[1], c[2]);
+			double c01 = (1 - t[0]) * at(c[0], c[1], n[2]) + t[0] * at(n[0], c[1], n[2]);
+			double c11 = (1 - t[0]) * at(c[0], n[1], n[2]) + t[0] * at(n[0], n[1], n[2]);
+			double c0 = (1 - t[1]) * c00 + t[1] * c10;
+			double c1 = (1 - t[1]) * c01 + t[1] * c11;
+			return (1 - t[2]) * c0 + t[2] * c1;
+		}
+
+		// trilinear(x, y, z) 所用的 8 个样本的最小值与最大值，用于限制修正对流的结果
+		void trilinearRange(double x, double y, double z, double& lo, double& hi) const
+		{
+			double p[3] = { x, y, z };
+			int c[3], n[3];
+			for (int d = 0; d < 3; d++) {
+				double v = (std::min)((std::max)(p[d], 0.0), (double)(mExtent[d] - 1));
+				c[d] = (int)v;
+				n[d] = (std::min)(c[d] + 1, mExtent[d] - 1);
+			}
+			lo = hi = at(c[0], c[1], c[2]);
+			for (int dk = 0; dk < 2; dk++)
+				for (int dj = 0; dj < 2; dj++)
+					for (int di = 0; di < 2; di++) {
+						double v = at(di ? n[0] : c[0], dj ? n[1] : c[1], dk ? n[2] : c[2]);
+						lo = (std::min)(lo, v);
+						hi = (std::max)(hi, v);
+					}
+		}
+
+		void fill(T value)
+		{
+			parallelFill(mData, size(), value);
+		}
+
+		// 交换两个同尺寸场的文件，用于前后缓冲
+		void swap(MappedGridData3d& other)
+		{
+			std::swap(mData, other.mData);
+			mFile.swap(other.mFile);
+		}
+
+	private:
+		T* mData;
+	};
+
+	// 按 z 层暂存对 MappedGridData3d 的写入，commit(k) 时把 k 层以下暂存的结果写入目标场
+	// 用于目标场在流式遍历中还要被之后的窗口（含 halo）读取的情况：
+	// 层 k 存放在环形缓冲的第 k % capacity 层，未提交的层数不能超过 capacity（窗口深度加 halo）
+	template <typename T>
+	class DeferredSlabWriter
+	{
+	public:
+		DeferredSlabWriter() : mTarget(NULL), mCapacity(0), mCommitted(0) {}
+
+		// 开始新的一遍遍历，缓冲区只在容量变大时重新分配
+		void begin(MappedGridData3d<T>& target, int capacity)
+		{
+			mTarget = &target;
+			mCapacity = (std::max)((std::min)(capacity, target.extent(2)), 1);
+			mCommitted = 0;
+			std::size_t needed = (std::size_t)mCapacity * slabSize();
+			if (mSlabs.size() < needed)
+				mSlabs.resize(needed);
+		}
+
+		T& at(int i, int j, int k)
+		{
+			return mSlabs[(std::size_t)i + (std::size_t)mTarget->extent(0) * ((std::size_t)j + (std::size_t)mTarget->extent(1) * (k % mCapacity))];
+		}
+
+		// 写入 [已提交的层, k1) 层
+		void commit(int k1)
+		{
+			k1 = (std::min)(k1, mTarget->extent(2));
+			for (; mCommitted < k1; mCommitted++) {
+				const T* slab = &mSlabs[slabSize() * (mCommitted % mCapacity)];
+				std::copy(slab, slab + slabSize(), &mTarget->at(0, 0, mCommitted));
+			}
+		}
+
+	private:
+		std::size_t slabSize() const { return (std::size_t)mTarget->extent(0) * mTarget->extent(1); }
+
+		MappedGridData3d<T>* mTarget;
+		std::vector<T> mSlabs;
+		int mCapacity;
+		int mCommitted;
+	};
+}
+
+#endif
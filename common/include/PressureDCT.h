@@ -0,0 +1,258 @@
+﻿#pragma once
+#ifndef __PRESSURE_DCT_H__
+#define __PRESSURE_DCT_H__
+
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+#include "FFT.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace Glb {
+
+	// 长方体区域上压力泊松方程的直接解法
+	// 容器壁为 Neumann 边界时，系数与 PressurePCG 相同的矩阵（忽略固体）被各维的 DCT-II 对角化，
+	// 特征值为 sum(2 - 2 cos(pi * k_d / dim_d))：逐维做 DCT、除以特征值、再逐维做逆变换即得精确解，代价 O(n log n)
+	// 长度为 n 的 DCT 由一次长度为 n 的复数 FFT 计算（Makhoul 重排），两行实数据共用一次 FFT
+	// 没有固体时 solve() 给出精确解；有固体时 precondition() 以忽略固体的解作为 PCG 的预条件子（对称半正定）
+	// 各行变换互不依赖，按行并行，结果与线程数无关
+	template <int N>
+	class PressureDCT
+	{
+	public:
+		typedef std::complex<double> Complex;
+
+		PressureDCT() : mCells(0), mThreads(1), mSolidCells(0)
+		{
+			for (int d = 0; d < N; d++) {
+				mDim[d] = 0;
+				mStride[d] = 0;
+			}
+		}
+
+		// 按网格尺寸建立各维的变换，并统计固体单元；Grid 为 MACGridCore<N, ...> 的派生类
+		// threads 为 0 时使用 OpenMP 默认线程数
+		template <typename Grid>
+		void build(Grid& grid, int threads = 0)
+		{
+			mThreads = threads;
+#ifdef _OPENMP
+			if (mThreads <= 0)
+				mThreads = omp_get_max_threads();
+#else
+			mThreads = 1;
+#endif
+			const double pi = 3.14159265358979323846;
+			bool resized = false;
+			mCells = 1;
+			for (int d = 0; d < N; d++) {
+				resized = resized || mDim[d] != grid.dim[d];
+				mDim[d] = grid.dim[d];
+				mStride[d] = mCells;
+				mCells *= mDim[d];
+			}
+			// 变换表只与尺寸有关
+			if (resized) {
+				for (int d = 0; d < N; d++) {
+					const int n = mDim[d];
+					mFFT[d].init(n);
+					mShift[d].resize(n);
+					mEigen[d].resize(n);
+					for (int k = 0; k < n; k++) {
+						mShift[d][k] = Complex(std::cos(-pi * k / (2.0 * n)), std::sin(-pi * k / (2.0 * n)));
+						mEigen[d][k] = 2.0 - 2.0 * std::cos(pi * k / n);
+					}
+				}
+			}
+			// 每个线程一组行缓冲：两行实数据，FFT 的输入、输出与临时缓冲区
+			int lineMax = 0;
+			for (int d = 0; d < N; d++)
+				lineMax = (std::max)(lineMax, mDim[d]);
+			mLineReal.resize((std::size_t)mThreads * 2 * lineMax);
+			mLineComplex.resize((std::size_t)mThreads * 3 * lineMax);
+			mSolid.assign(mCells, 0);
+			mP.resize(mCells);
+			mRhs.resize(mCells);
+			mSolidCells = 0;
+			int c[N];
+			for (int n = 0; n < mCells; n++) {
+				int q = n;
+				for (int d = 0; d < N; d++) {
+					c[d] = q % mDim[d];
+					q /= mDim[d];
+				}
+				if (grid.cellFlags(c) & Grid::kCellSolid) {
+					mSolid[n] = 1;
+					mSolidCells++;
+				}
+			}
+		}
+
+		// 单元 c 在 rhs() / pressure() 中的线性编号，与 PressurePCG::index 相同
+		int index(const int* c) const
+		{
+			int n = 0;
+			for (int d = N - 1; d >= 0; d--)
+				n = n * mDim[d] + c[d];
+			return n;
+		}
+
+		std::vector<double>& rhs() { return mRhs; }
+		std::vector<double>& pressure() { return mP; }
+
+		int solidCells() const { return mSolidCells; }
+		double solidFraction() const { return mCells > 0 ? (double)mSolidCells / mCells : 0.0; }
+
+		// pressure() = A^+ rhs()，解的均值为 0；只在没有固体时是原方程的解
+		void solve() { precondition(mRhs, mP); }
+
+		// z = L^+ r，L 为忽略固体的长方体 Neumann 拉普拉斯矩阵；r 的常数分量被丢弃，固体单元的 z 为 0
+		void precondition(const std::vector<double>& r, std::vector<double>& z)
+		{
+			z = r;
+			for (int d = 0; d < N; d++)
+				transformLines(z, d, false);
+			parallelFor([&](int n) {
+				double lambda = 0.0;
+				for (int d = 0; d < N; d++)
+					lambda += mEigen[d][(n / mStride[d]) % mDim[d]];
+				z[n] = lambda > 0.0 ? z[n] / lambda : 0.0;
+			});
+			for (int d = N - 1; d >= 0; d--)
+				transformLines(z, d, true);
+			if (mSolidCells > 0)
+				parallelFor([&](int n) {
+					if (mSolid[n])
+						z[n] = 0.0;
+				});
+		}
+
+	private:
+		template <typename F>
+		void parallelFor(F fn) const
+		{
+			const int cells = mCells;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(mThreads)
+#endif
+			for (int n = 0; n < cells; n++)
+				fn(n);
+		}
+
+		// 沿 axis 对所有行原地做 DCT-II（inverse 为 true 时做其逆变换）
+		// 两行实数据合成一个复数序列（实部、虚部各一行），一次 FFT 变换两行
+		void transformLines(std::vector<double>& a, int axis, bool inverse) const
+		{
+			const int n = mDim[axis];
+			const int stride = mStride[axis];
+			const int lines = mCells / n;
+			const int pairs = (lines + 1) / 2;
+			if (n <= 1)
+				return;
+#ifdef _OPENMP
+#pragma omp parallel num_threads(mThreads)
+#endif
+			{
+#ifdef _OPENMP
+				const std::size_t t = (std::size_t)omp_get_thread_num();
+#else
+				const std::size_t t = 0;
+#endif
+				const std::size_t lineMax = mLineReal.size() / (2 * (std::size_t)mThreads);
+				double* x0 = mLineReal.data() + t * 2 * lineMax;
+				double* x1 = x0 + lineMax;
+				Complex* v = mLineComplex.data() + t * 3 * lineMax;
+				Complex* V = v + lineMax;
+				Complex* scratch = V + lineMax;
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+				for (int q = 0; q < pairs; q++) {
+					// 第 l 行的起点：axis 以下各维为 l % stride，以上各维为 l / stride
+					const int l0 = 2 * q, l1 = (std::min)(2 * q + 1, lines - 1);
+					const int base0 = l0 % stride + (l0 / stride) * stride * n;
+					const int base1 = l1 % stride + (l1 / stride) * stride * n;
+					for (int m = 0; m < n; m++) {
+						x0[m] = a[base0 + m * stride];
+						x1[m] = a[base1 + m * stride];
+					}
+					if (inverse)
+						inverseDCT(axis, x0, x1, v, V, scratch);
+					else
+						forwardDCT(axis, x0, x1, v, V, scratch);
+					// 行数为奇数时最后一对的两行相同，写回同样的值
+					for (int m = 0; m < n; m++) {
+						a[base0 + m * stride] = x0[m];
+						a[base1 + m * stride] = x1[m];
+					}
+				}
+			}
+		}
+
+		static Complex mul(const Complex& a, const Complex& b)
+		{
+			return Complex(a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real());
+		}
+
+		// X[k] = sum(x[m] * cos(pi * k * (2m + 1) / 2n))：偶数项正序、奇数项逆序排成 v，X[k] = Re(exp(-i pi k / 2n) * FFT(v)[k])
+		// x0、x1 分别放在 v 的实部和虚部，由 FFT(v) 的共轭对称性分离出两者的频谱
+		void forwardDCT(int axis, double* x0, double* x1, Complex* v, Complex* V, Complex* scratch) const
+		{
+			const int n = mDim[axis];
+			for (int m = 0; 2 * m < n; m++)
+				v[m] = Complex(x0[2 * m], x1[2 * m]);
+			for (int m = 0; 2 * m + 1 < n; m++)
+				v[n - 1 - m] = Complex(x0[2 * m + 1], x1[2 * m + 1]);
+			mFFT[axis].forward(v, V, scratch);
+			for (int k = 0; k < n; k++) {
+				const Complex a = V[k], b = std::conj(V[k > 0 ? n - k : 0]);
+				const Complex s0 = 0.5 * (a + b);
+				const Complex s1 = Complex(0.0, -0.5) * (a - b);
+				x0[k] = mul(s0, mShift[axis][k]).real();
+				x1[k] = mul(s1, mShift[axis][k]).real();
+			}
+		}
+
+		// forwardDCT 的逆：V[k] = exp(i pi k / 2n) * (X[k] - i X[n - k])，v = IFFT(V)，再按相反的顺序取回
+		// 两行的 v 都是实数，V 合成为 V0 + i V1 后一次逆变换
+		void inverseDCT(int axis, double* x0, double* x1, Complex* v, Complex* V, Complex* scratch) const
+		{
+			const int n = mDim[axis];
+			for (int k = 0; k < n; k++) {
+				const Complex shift = std::conj(mShift[axis][k]);
+				const Complex V0 = mul(shift, Complex(x0[k], k > 0 ? -x0[n - k] : 0.0));
+				const Complex V1 = mul(shift, Complex(x1[k], k > 0 ? -x1[n - k] : 0.0));
+				V[k] = Complex(V0.real() - V1.imag(), V0.imag() + V1.real());
+			}
+			mFFT[axis].inverse(V, v, scratch);
+			const double scale = 1.0 / n;
+			for (int m = 0; 2 * m < n; m++) {
+				x0[2 * m] = v[m].real() * scale;
+				x1[2 * m] = v[m].imag() * scale;
+			}
+			for (int m = 0; 2 * m + 1 < n; m++) {
+				x0[2 * m + 1] = v[n - 1 - m].real() * scale;
+				x1[2 * m + 1] = v[n - 1 - m].imag() * scale;
+			}
+		}
+
+		int mDim[N];
+		int mStride[N];
+		int mCells;
+		int mThreads;
+		FFT mFFT[N];
+		std::vector<Complex> mShift[N];		// exp(-i pi k / 2n)
+		std::vector<double> mEigen[N];		// 一维 Neumann 拉普拉斯的特征值 2 - 2 cos(pi k / n)
+		std::vector<std::uint8_t> mSolid;
+		int mSolidCells;
+		std::vector<double> mP, mRhs;		// 解与右端项
+		mutable std::vector<double> mLineReal;		// transformLines 的行缓冲，每个线程 2 * 最大边长个实数、3 * 最大边长个复数
+		mutable std::vector<Complex> mLineComplex;
+	};
+}
+
+#endif
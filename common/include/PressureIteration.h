@@ -0,0 +1,67 @@
+﻿#pragma once
+#ifndef __PRESSURE_ITERATION_H__
+#define __PRESSURE_ITERATION_H__
+
+#include <cmath>
+
+namespace Glb {
+
+	// 压力泊松方程的定常迭代解法，与 Eulerian2dPara / Eulerian3dPara::pressureSolver 的取值对应
+	enum PressureSolverType
+	{
+		kPressureGaussSeidel = 0,		// 按字典序原地更新的 Gauss-Seidel，只能串行
+		kPressureRedBlackSOR = 1,		// 红黑排序的逐次超松弛，同色单元互不依赖，可并行
+		kPressureChebyshevJacobi = 2,	// Chebyshev 加速的 Jacobi，每个单元独立更新，可并行
+		kPressurePCG = 3,				// MIC(0) 预条件的共轭梯度，按相对残差停止，见 PressurePCG.h
+		kPressureMultigrid = 4,			// 几何多重网格 V / F 循环，见 PressureMultigrid.h
+		kPressureMGPCG = 5				// 以一次多重网格 V 循环为预条件子的共轭梯度
+	};
+
+	// Jacobi 迭代矩阵除常数模态外最大特征值的估计
+	// 容器壁按固体处理（纯 Neumann 边界），特征值为 sum(cos(pi * k_d / dim_d)) / n，
+	// 最大的非常数模态只沿最长的一维变化：(n - 1 + cos(pi / maxDim)) / n
+	// 估计偏小时 Chebyshev 会发散，偏大只会变慢
+	inline double jacobiSpectralRadius(const int* dim, int n)
+	{
+		const double pi = 3.14159265358979323846;
+		int maxDim = 2;
+		for (int d = 0; d < n; d++)
+			maxDim = dim[d] > maxDim ? dim[d] : maxDim;
+		return (n - 1 + std::cos(pi / maxDim)) / n;
+	}
+
+	// 红黑 SOR 的松弛因子：omega 在 (0, 2) 内时直接使用，否则取由谱半径得到的最优值
+	inline double sorRelaxation(double omega, double rho)
+	{
+		if (omega > 0.0 && omega < 2.0)
+			return omega;
+		return 2.0 / (1.0 + std::sqrt(1.0 - rho * rho));
+	}
+
+	// Chebyshev 半迭代的外推系数
+	// x(k+1) = omega(k+1) * (J x(k) - x(k-1)) + x(k-1)，其中 J x 为一次 Jacobi 更新
+	// 与 Jacobi 相比只多保存上一次的解，收敛速度与最优 SOR 相当
+	class ChebyshevSchedule
+	{
+	public:
+		explicit ChebyshevSchedule(double rho) : mRho2(rho * rho), mOmega(1.0), mIteration(0) {}
+
+		// 下一次迭代使用的系数：1, 2 / (2 - rho^2), 1 / (1 - rho^2 * omega / 4), ...
+		double next()
+		{
+			if (mIteration == 1)
+				mOmega = 2.0 / (2.0 - mRho2);
+			else if (mIteration > 1)
+				mOmega = 1.0 / (1.0 - 0.25 * mRho2 * mOmega);
+			mIteration++;
+			return mOmega;
+		}
+
+	private:
+		double mRho2;
+		double mOmega;
+		int mIteration;
+	};
+}
+
+#endif
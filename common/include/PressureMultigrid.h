@@ -0,0 +1,471 @@
+﻿#pragma once
+#ifndef __PRESSURE_MULTIGRID_H__
+#define __PRESSURE_MULTIGRID_H__
+
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <algorithm>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace Glb {
+
+	// 压力泊松方程的几何多重网格求解器，系数与 PressurePCG 相同（单元流体邻居掩码即时计算）
+	// 每层网格各维减半，粗单元只要有一个子单元参与求解就视为流体，粗层系数按粗网格重新离散
+	// 插值为双/三线性，只取粗层的流体单元并按实际权重和归一化，固体和容器壁一侧退化为常数外推
+	// 限制为插值的转置，乘 4 / 2^N 与粗网格系数（间距加倍）匹配
+	// 光滑器为红黑 Gauss-Seidel，后光滑按相反颜色顺序，V 循环是对称算子，可作为 PCG 的预条件子
+	// 所有循环按单元或行并行，每个值只由一个线程写入，结果与线程数无关
+	template <int N>
+	class PressureMultigrid
+	{
+	public:
+		// 前后光滑次数
+		static const int kPreSweeps = 2;
+		static const int kPostSweeps = 2;
+		// 最粗层每维不超过该单元数，在最粗层做 kCoarseSweeps 次正向和反向的红黑迭代
+		static const int kCoarsestDim = 8;
+		static const int kCoarseSweeps = 32;
+
+		PressureMultigrid() : mThreads(1), mCycles(0), mResidual(0.0) {}
+
+		// 按网格的单元标记建立各层，固体分布或网格尺寸改变后需重新调用
+		// Grid 为 MACGridCore<N, ...> 的派生类；threads 为 0 时使用 OpenMP 默认线程数
+		template <typename Grid>
+		void build(Grid& grid, int threads = 0)
+		{
+			mThreads = threads;
+#ifdef _OPENMP
+			if (mThreads <= 0)
+				mThreads = omp_get_max_threads();
+#else
+			mThreads = 1;
+#endif
+			mLevels.clear();
+			mLevels.resize(1);
+			int dim[N];
+			for (int d = 0; d < N; d++)
+				dim[d] = grid.dim[d];
+			setDim(mLevels[0], dim);
+
+			// 最细层的掩码与 PressurePCG 相同：第 2 * axis + (side > 0) 位表示该方向的邻居也是流体
+			int c[N];
+			Level& fine = mLevels[0];
+			for (int n = 0; n < fine.cells; n++) {
+				coord(fine, n, c);
+				std::uint16_t flags = grid.cellFlags(c);
+				if (flags & Grid::kCellSolid)
+					continue;
+				std::uint8_t mask = 0;
+				for (int axis = 0; axis < N; axis++)
+					for (int side = -1; side <= 1; side += 2)
+						if (!(flags & Grid::neighborBit(axis, side)))
+							mask |= (std::uint8_t)(1u << (2 * axis + (side > 0 ? 1 : 0)));
+				fine.mask[n] = mask;
+				for (int axis = 0; axis < N; axis++)
+					fine.coef[n * N + axis] = (mask & upperBit(axis)) ? 1.0 : 0.0;
+			}
+			setDiagonal(fine);
+
+			while (maxDim(mLevels.back()) > kCoarsestDim) {
+				Level coarse;
+				const Level& prev = mLevels.back();
+				for (int d = 0; d < N; d++)
+					dim[d] = (prev.dim[d] + 1) / 2;
+				setDim(coarse, dim);
+				// 粗网格面的系数为其覆盖的细网格面系数的平均：细网格上的薄壁在粗一层仍能挡住两侧的耦合
+				for (int n = 0; n < prev.cells; n++) {
+					coord(prev, n, c);
+					int C[N];
+					for (int d = 0; d < N; d++)
+						C[d] = c[d] / 2;
+					const int m = index(coarse, C);
+					for (int axis = 0; axis < N; axis++)
+						if (c[axis] & 1)
+							coarse.coef[m * N + axis] += prev.coef[n * N + axis] / (1 << (N - 1));
+				}
+				for (int n = 0; n < coarse.cells; n++) {
+					coord(coarse, n, c);
+					std::uint8_t mask = 0;
+					for (int axis = 0; axis < N; axis++) {
+						if (c[axis] > 0 && coarse.coef[(n - coarse.stride[axis]) * N + axis] > 0.0)
+							mask |= lowerBit(axis);
+						if (coarse.coef[n * N + axis] > 0.0)
+							mask |= upperBit(axis);
+					}
+					coarse.mask[n] = mask;
+				}
+				setDiagonal(coarse);
+				mLevels.push_back(std::move(coarse));
+			}
+
+			// 各层（最粗层除外）插值权重和的倒数
+			for (int l = 0; l + 1 < (int)mLevels.size(); l++) {
+				Level& f = mLevels[l];
+				const Level& g = mLevels[l + 1];
+				f.norm.assign(f.cells, 0.0);
+				for (int n = 0; n < f.cells; n++) {
+					if (!f.mask[n])
+						continue;
+					coord(f, n, c);
+					double sum = 0.0;
+					for (int k = 0; k < (1 << N); k++) {
+						int parent[N];
+						const double w = parentWeight(g, c, f.mask[n], k, parent);
+						if (w > 0.0 && g.mask[index(g, parent)])
+							sum += w;
+					}
+					f.norm[n] = sum > 0.0 ? 1.0 / sum : 0.0;
+				}
+			}
+		}
+
+		// 单元 c 在 rhs() / pressure() 中的线性编号，与 PressurePCG::index 相同
+		int index(const int* c) const { return index(mLevels[0], c); }
+
+		std::vector<double>& rhs() { return mLevels[0].b; }
+		std::vector<double>& pressure() { return mLevels[0].x; }
+		int levels() const { return (int)mLevels.size(); }
+
+		// 以 pressure() 为初值迭代多重网格循环求解 A p = rhs，fCycle 为 true 时用 F 循环
+		// 停止条件与 PressurePCG::solve 相同，返回循环次数
+		int solve(double tolerance, int maxCycles, bool fCycle = false)
+		{
+			Level& L = mLevels[0];
+			removeMean(L, L.b);
+			for (int n = 0; n < L.cells; n++)
+				if (!L.mask[n])
+					L.x[n] = 0.0;
+			residual(L);
+			const double bNorm = maxNorm(L, L.b);
+			mCycles = 0;
+			mFactors.clear();
+			mResidual = bNorm > 0.0 ? maxNorm(L, L.r) / bNorm : 0.0;
+			if (bNorm == 0.0 || mResidual <= tolerance)
+				return 0;
+			while (mCycles < maxCycles) {
+				cycle(0, fCycle);
+				mCycles++;
+				residual(L);
+				const double res = maxNorm(L, L.r) / bNorm;
+				mFactors.push_back(res / mResidual);
+				mResidual = res;
+				if (mResidual <= tolerance)
+					break;
+			}
+			return mCycles;
+		}
+
+		// 作为预条件子：z 为从零初值对 r 做一次 V 循环的结果，会覆盖 rhs() 与 pressure()
+		void precondition(const std::vector<double>& r, std::vector<double>& z)
+		{
+			Level& L = mLevels[0];
+			L.b = r;
+			std::fill(L.x.begin(), L.x.end(), 0.0);
+			cycle(0, false);
+			z = L.x;
+		}
+
+		int cycles() const { return mCycles; }
+		// 最终的相对残差（最大范数）
+		double residual() const { return mResidual; }
+		// 每次循环前后相对残差之比
+		const std::vector<double>& cycleFactors() const { return mFactors; }
+		// 各次循环收敛因子的几何平均
+		double convergenceFactor() const
+		{
+			if (mFactors.empty())
+				return 0.0;
+			double logSum = 0.0;
+			for (size_t k = 0; k < mFactors.size(); k++) {
+				if (mFactors[k] <= 0.0)
+					return 0.0;
+				logSum += std::log(mFactors[k]);
+			}
+			return std::exp(logSum / mFactors.size());
+		}
+
+	private:
+		struct Level
+		{
+			int dim[N];
+			int stride[N];
+			int cells;
+			std::vector<std::uint8_t> mask;		// 流体邻居掩码，0 表示不参与求解
+			std::vector<double> coef;			// 各维上侧面的系数，第 n * N + axis 项
+			std::vector<double> diag;			// 对角项，为各面系数之和
+			std::vector<double> x, b, r;		// 解、右端项、残差
+			std::vector<double> norm;			// 从下一粗层插值时权重和的倒数
+		};
+
+		static std::uint8_t lowerBit(int axis) { return (std::uint8_t)(1u << (2 * axis)); }
+		static std::uint8_t upperBit(int axis) { return (std::uint8_t)(1u << (2 * axis + 1)); }
+
+		static void setDiagonal(Level& L)
+		{
+			for (int n = 0; n < L.cells; n++) {
+				double sum = 0.0;
+				for (int axis = 0; axis < N; axis++) {
+					if (L.mask[n] & lowerBit(axis))
+						sum += L.coef[(n - L.stride[axis]) * N + axis];
+					if (L.mask[n] & upperBit(axis))
+						sum += L.coef[n * N + axis];
+				}
+				L.diag[n] = sum;
+			}
+		}
+
+		// 单元 n 的邻居项之和 sum(coef * x_nb)
+		static double neighborSum(const Level& L, int n, std::uint8_t mask)
+		{
+			double sum = 0.0;
+			for (int axis = 0; axis < N; axis++) {
+				if (mask & lowerBit(axis))
+					sum += L.coef[(n - L.stride[axis]) * N + axis] * L.x[n - L.stride[axis]];
+				if (mask & upperBit(axis))
+					sum += L.coef[n * N + axis] * L.x[n + L.stride[axis]];
+			}
+			return sum;
+		}
+
+		static void setDim(Level& L, const int* dim)
+		{
+			L.cells = 1;
+			for (int d = 0; d < N; d++) {
+				L.dim[d] = dim[d];
+				L.stride[d] = L.cells;
+				L.cells *= dim[d];
+			}
+			L.mask.assign(L.cells, 0);
+			L.x.assign(L.cells, 0.0);
+			L.b.assign(L.cells, 0.0);
+			L.r.assign(L.cells, 0.0);
+			L.coef.assign(L.cells * N, 0.0);
+			L.diag.assign(L.cells, 0.0);
+		}
+
+		static int maxDim(const Level& L)
+		{
+			int m = 0;
+			for (int d = 0; d < N; d++)
+				m = (std::max)(m, L.dim[d]);
+			return m;
+		}
+
+		static int index(const Level& L, const int* c)
+		{
+			int n = 0;
+			for (int d = N - 1; d >= 0; d--)
+				n = n * L.dim[d] + c[d];
+			return n;
+		}
+
+		static void coord(const Level& L, int n, int* c)
+		{
+			for (int d = 0; d < N; d++) {
+				c[d] = n % L.dim[d];
+				n /= L.dim[d];
+			}
+		}
+
+		// 细单元 c 的第 k 个插值来源：第 d 位为 0 取所在的粗单元（权重 3/4），为 1 取靠近 c 一侧的相邻粗单元（1/4）
+		// 来源越界或细单元朝该侧的面是固体（不跨过薄壁插值）时返回 0
+		static double parentWeight(const Level& coarse, const int* c, std::uint8_t mask, int k, int* parent)
+		{
+			double w = 1.0;
+			for (int d = 0; d < N; d++) {
+				const int p = c[d] >> 1;
+				if (k & (1 << d)) {
+					if (!(mask & ((c[d] & 1) ? upperBit(d) : lowerBit(d))))
+						return 0.0;
+					parent[d] = (c[d] & 1) ? p + 1 : p - 1;
+					w *= 0.25;
+				}
+				else {
+					parent[d] = p;
+					w *= 0.75;
+				}
+				if (parent[d] < 0 || parent[d] >= coarse.dim[d])
+					return 0.0;
+			}
+			return w;
+		}
+
+		template <typename F>
+		void parallelFor(int count, F fn) const
+		{
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(mThreads)
+#endif
+			for (int n = 0; n < count; n++)
+				fn(n);
+		}
+
+		// 一次红黑 Gauss-Seidel：reverse 为 false 时先红后黑，否则先黑后红
+		// 按第 0 维的行并行，红色单元的坐标和为偶数
+		void sweep(Level& L, bool reverse)
+		{
+			const int rows = L.cells / L.dim[0];
+			for (int half = 0; half < 2; half++) {
+				const int color = reverse ? 1 - half : half;
+				parallelFor(rows, [&](int row) {
+					int parity = color;
+					for (int d = 1, q = row; d < N; d++) {
+						parity += q % L.dim[d];
+						q /= L.dim[d];
+					}
+					const int base = row * L.dim[0];
+					for (int i = parity & 1; i < L.dim[0]; i += 2) {
+						const int n = base + i;
+						const std::uint8_t mask = L.mask[n];
+						if (!mask)
+							continue;
+						L.x[n] = (L.b[n] + neighborSum(L, n, mask)) / L.diag[n];
+					}
+				});
+			}
+		}
+
+		void residual(Level& L)
+		{
+			parallelFor(L.cells, [&](int n) {
+				const std::uint8_t mask = L.mask[n];
+				if (!mask) {
+					L.r[n] = 0.0;
+					return;
+				}
+				L.r[n] = L.b[n] - L.diag[n] * L.x[n] + neighborSum(L, n, mask);
+			});
+		}
+
+		// 第 l 层的残差限制到第 l + 1 层的右端项：每个粗单元收集每维 4 个细单元
+		void restrictResidual(int l)
+		{
+			const Level& f = mLevels[l];
+			Level& g = mLevels[l + 1];
+			const double scale = 4.0 / (1 << N);
+			parallelFor(g.cells, [&](int n) {
+				if (!g.mask[n]) {
+					g.b[n] = 0.0;
+					return;
+				}
+				int C[N], c[N];
+				coord(g, n, C);
+				double sum = 0.0;
+				for (int o = 0; o < (1 << (2 * N)); o++) {
+					double w = 1.0;
+					bool inside = true;
+					for (int d = 0; d < N; d++) {
+						const int od = (o >> (2 * d)) & 3;
+						c[d] = 2 * C[d] - 1 + od;
+						if (c[d] < 0 || c[d] >= f.dim[d]) {
+							inside = false;
+							break;
+						}
+						w *= (od == 0 || od == 3) ? 0.25 : 0.75;
+					}
+					if (!inside)
+						continue;
+					const int m = index(f, c);
+					if (!f.mask[m])
+						continue;
+					// 与 parentWeight 相同：细单元朝本粗单元一侧的面须为流体
+					bool open = true;
+					for (int d = 0; d < N; d++) {
+						const int od = (o >> (2 * d)) & 3;
+						if ((od == 0 && !(f.mask[m] & upperBit(d))) || (od == 3 && !(f.mask[m] & lowerBit(d))))
+							open = false;
+					}
+					if (open)
+						sum += w * f.norm[m] * f.r[m];
+				}
+				g.b[n] = scale * sum;
+			});
+		}
+
+		// 第 l + 1 层的解插值后加到第 l 层
+		void prolongate(int l)
+		{
+			Level& f = mLevels[l];
+			const Level& g = mLevels[l + 1];
+			parallelFor(f.cells, [&](int n) {
+				if (!f.mask[n])
+					return;
+				int c[N], parent[N];
+				coord(f, n, c);
+				double sum = 0.0;
+				for (int k = 0; k < (1 << N); k++) {
+					const double w = parentWeight(g, c, f.mask[n], k, parent);
+					if (w > 0.0) {
+						const int m = index(g, parent);
+						if (g.mask[m])
+							sum += w * g.x[m];
+					}
+				}
+				f.x[n] += sum * f.norm[n];
+			});
+		}
+
+		// 以第 l 层的 x 为初值，对其右端项做一次循环
+		void cycle(int l, bool fCycle)
+		{
+			Level& L = mLevels[l];
+			if (l + 1 == (int)mLevels.size()) {
+				// 最粗层：去掉右端项的常数分量后做对称的红黑迭代
+				removeMean(L, L.b);
+				for (int s = 0; s < kCoarseSweeps; s++)
+					sweep(L, false);
+				for (int s = 0; s < kCoarseSweeps; s++)
+					sweep(L, true);
+				return;
+			}
+			for (int s = 0; s < kPreSweeps; s++)
+				sweep(L, false);
+			residual(L);
+			restrictResidual(l);
+			Level& coarse = mLevels[l + 1];
+			std::fill(coarse.x.begin(), coarse.x.end(), 0.0);
+			// F 循环在粗层先做 F 循环再做 V 循环
+			if (fCycle)
+				cycle(l + 1, true);
+			cycle(l + 1, false);
+			prolongate(l);
+			for (int s = 0; s < kPostSweeps; s++)
+				sweep(L, true);
+		}
+
+		static void removeMean(const Level& L, std::vector<double>& b)
+		{
+			int active = 0;
+			double sum = 0.0;
+			for (int n = 0; n < L.cells; n++)
+				if (L.mask[n]) {
+					sum += b[n];
+					active++;
+				}
+			const double mean = active > 0 ? sum / active : 0.0;
+			for (int n = 0; n < L.cells; n++)
+				b[n] = L.mask[n] ? b[n] - mean : 0.0;
+		}
+
+		static double maxNorm(const Level& L, const std::vector<double>& a)
+		{
+			double m = 0.0;
+			for (int n = 0; n < L.cells; n++)
+				if (L.mask[n])
+					m = (std::max)(m, std::fabs(a[n]));
+			return m;
+		}
+
+		int mThreads;
+		std::vector<Level> mLevels;			// 第 0 层为原网格
+		int mCycles;
+		double mResidual;
+		std::vector<double> mFactors;
+	};
+}
+
+#endif
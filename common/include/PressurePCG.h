@@ -0,0 +1,371 @@
+﻿#pragma once
+#ifndef __PRESSURE_PCG_H__
+#define __PRESSURE_PCG_H__
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include <algorithm>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace Glb {
+
+	// 压力泊松方程的矩阵无关 PCG 求解器，预条件子为 MIC(0)
+	// 系数与 MACGridCore::getPressureCoeffBetweenCells 相同：对角项为非固体邻居数，非固体邻居为 -1，固体单元不参与
+	// 只保存每个单元的流体邻居掩码，矩阵乘与三角求解都由掩码即时计算
+	// 三角求解按超平面 c[0] + ... + c[N-1] = l 分层：同层单元互不依赖，层内并行
+	// 内积按固定大小的分段求和后再按顺序累加，结果与线程数无关
+	template <int N>
+	class PressurePCG
+	{
+	public:
+		// MIC(0) 的修正系数与安全系数
+		static constexpr double kTau = 0.97;
+		static constexpr double kSigma = 0.25;
+		// 内积分段求和的段长
+		static const int kChunk = 4096;
+
+		PressurePCG() : mCells(0), mThreads(1), mIterations(0), mResidual(0.0)
+		{
+			for (int d = 0; d < N; d++) {
+				mDim[d] = 0;
+				mStride[d] = 0;
+			}
+		}
+
+		// 按网格的单元标记建立系数和预条件子，固体分布或网格尺寸改变后需重新调用
+		// Grid 为 MACGridCore<N, ...> 的派生类；threads 为 0 时使用 OpenMP 默认线程数
+		template <typename Grid>
+		void build(Grid& grid, int threads = 0)
+		{
+			mThreads = threads;
+#ifdef _OPENMP
+			if (mThreads <= 0)
+				mThreads = omp_get_max_threads();
+#else
+			mThreads = 1;
+#endif
+			mCells = 1;
+			for (int d = 0; d < N; d++) {
+				mDim[d] = grid.dim[d];
+				mStride[d] = mCells;
+				mCells *= mDim[d];
+			}
+			mMask.assign(mCells, 0);
+			mPrecon.assign(mCells, 0.0);
+			mP.resize(mCells);
+			mRhs.resize(mCells);
+			mR.resize(mCells);
+			mZ.resize(mCells);
+			mS.resize(mCells);
+			mQ.resize(mCells);
+			mPartial.resize((mCells + kChunk - 1) / kChunk);
+
+			// 流体单元的掩码：第 2 * axis + (side > 0) 位表示该方向的邻居也是流体
+			int levels = 1;
+			for (int d = 0; d < N; d++)
+				levels += mDim[d] - 1;
+			std::vector<int>& levelCount = mLevelCount;
+			levelCount.assign(levels + 1, 0);
+			int c[N];
+			for (int n = 0; n < mCells; n++) {
+				coord(n, c);
+				std::uint16_t flags = grid.cellFlags(c);
+				if (flags & Grid::kCellSolid)
+					continue;
+				std::uint8_t mask = 0;
+				for (int axis = 0; axis < N; axis++)
+					for (int side = -1; side <= 1; side += 2)
+						if (!(flags & Grid::neighborBit(axis, side)))
+							mask |= (std::uint8_t)(1u << (2 * axis + (side > 0 ? 1 : 0)));
+				// 没有流体邻居的孤立单元方程为 0 = b，不参与求解
+				if (mask == 0)
+					continue;
+				mMask[n] = mask;
+				levelCount[level(c) + 1]++;
+			}
+
+			// 按层排列参与求解的单元，层内按线性编号递增
+			mLevelStart.assign(levels + 1, 0);
+			for (int l = 0; l < levels; l++)
+				mLevelStart[l + 1] = mLevelStart[l] + levelCount[l + 1];
+			mLevelCells.resize(mLevelStart[levels]);
+			std::vector<int>& fill = mLevelCount;
+			fill.assign(mLevelStart.begin(), mLevelStart.end() - 1);
+			for (int n = 0; n < mCells; n++) {
+				if (!mMask[n])
+					continue;
+				coord(n, c);
+				mLevelCells[fill[level(c)]++] = n;
+			}
+
+			// MIC(0)：按层计算，每个单元只依赖各方向下侧邻居
+			for (int l = 0; l < levels; l++) {
+				const int begin = mLevelStart[l], end = mLevelStart[l + 1];
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(mThreads)
+#endif
+				for (int m = begin; m < end; m++) {
+					const int n = mLevelCells[m];
+					const std::uint8_t mask = mMask[n];
+					const double diag = diagonal(mask);
+					double e = diag;
+					for (int axis = 0; axis < N; axis++) {
+						if (!(mask & lowerBit(axis)))
+							continue;
+						const int nb = n - mStride[axis];
+						const double pn = mPrecon[nb];
+						// 下侧邻居在其余方向上侧的流体邻居数
+						int others = 0;
+						for (int d = 0; d < N; d++)
+							if (d != axis && (mMask[nb] & upperBit(d)))
+								others++;
+						e -= pn * pn * (1.0 + kTau * others);
+					}
+					if (e < kSigma * diag)
+						e = diag;
+					mPrecon[n] = 1.0 / std::sqrt(e);
+				}
+			}
+		}
+
+		// 单元 c 在 rhs() / pressure() 中的线性编号：第 0 维最内层，依次向外
+		int index(const int* c) const
+		{
+			int n = 0;
+			for (int d = N - 1; d >= 0; d--)
+				n = n * mDim[d] + c[d];
+			return n;
+		}
+
+		std::vector<double>& rhs() { return mRhs; }
+		std::vector<double>& pressure() { return mP; }
+
+		// 用 z = M^-1 r 代替 MIC(0)，M 须对称正定（如 PressureMultigrid::precondition 的 V 循环）；传空函数恢复 MIC(0)
+		typedef std::function<void(const std::vector<double>&, std::vector<double>&)> Preconditioner;
+		void setPreconditioner(const Preconditioner& precon) { mPreconditioner = precon; }
+
+		// 以 pressure() 为初值求解 A p = rhs
+		// 容器壁和固体都是 Neumann 边界，方程组奇异：先去掉右端项在常数模态上的分量
+		// 残差的最大范数降到右端项最大范数的 tolerance 倍以下，或迭代 maxIterations 次后停止，返回迭代次数
+		int solve(double tolerance, int maxIterations)
+		{
+			removeMean(mRhs);
+			for (int n = 0; n < mCells; n++)
+				if (!mMask[n])
+					mP[n] = 0.0;
+
+			applyA(mP, mR);
+			parallelFor([&](int n) { mR[n] = mMask[n] ? mRhs[n] - mR[n] : 0.0; });
+
+			const double bNorm = maxNorm(mRhs);
+			mIterations = 0;
+			mResidual = bNorm > 0.0 ? maxNorm(mR) / bNorm : 0.0;
+			if (bNorm == 0.0 || mResidual <= tolerance)
+				return 0;
+
+			precondition(mR, mZ);
+			mS = mZ;
+			double sigma = dot(mR, mZ);
+			while (mIterations < maxIterations) {
+				mIterations++;
+				applyA(mS, mQ);
+				const double sq = dot(mS, mQ);
+				if (sq == 0.0)
+					break;
+				const double alpha = sigma / sq;
+				parallelFor([&](int n) {
+					mP[n] += alpha * mS[n];
+					mR[n] -= alpha * mQ[n];
+				});
+				mResidual = maxNorm(mR) / bNorm;
+				if (mResidual <= tolerance)
+					break;
+				precondition(mR, mZ);
+				const double sigmaNew = dot(mR, mZ);
+				const double beta = sigmaNew / sigma;
+				parallelFor([&](int n) { mS[n] = mZ[n] + beta * mS[n]; });
+				sigma = sigmaNew;
+			}
+			return mIterations;
+		}
+
+		int iterations() const { return mIterations; }
+		// 最终的相对残差（最大范数）
+		double residual() const { return mResidual; }
+
+		// y = A x，固体单元为 0
+		void applyA(const std::vector<double>& x, std::vector<double>& y) const
+		{
+			parallelFor([&](int n) {
+				const std::uint8_t mask = mMask[n];
+				if (!mask) {
+					y[n] = 0.0;
+					return;
+				}
+				double sum = diagonal(mask) * x[n];
+				for (int axis = 0; axis < N; axis++) {
+					if (mask & lowerBit(axis))
+						sum -= x[n - mStride[axis]];
+					if (mask & upperBit(axis))
+						sum -= x[n + mStride[axis]];
+				}
+				y[n] = sum;
+			});
+		}
+
+		// z = (L L^T)^-1 r，前代与回代都按层并行
+		void applyPrecon(const std::vector<double>& r, std::vector<double>& z)
+		{
+			const int levels = (int)mLevelStart.size() - 1;
+			std::vector<double>& q = mQ;
+			for (int l = 0; l < levels; l++) {
+				const int begin = mLevelStart[l], end = mLevelStart[l + 1];
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(mThreads)
+#endif
+				for (int m = begin; m < end; m++) {
+					const int n = mLevelCells[m];
+					double t = r[n];
+					for (int axis = 0; axis < N; axis++)
+						if (mMask[n] & lowerBit(axis)) {
+							const int nb = n - mStride[axis];
+							t += mPrecon[nb] * q[nb];
+						}
+					q[n] = t * mPrecon[n];
+				}
+			}
+			for (int l = levels - 1; l >= 0; l--) {
+				const int begin = mLevelStart[l], end = mLevelStart[l + 1];
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(mThreads)
+#endif
+				for (int m = begin; m < end; m++) {
+					const int n = mLevelCells[m];
+					double t = 0.0;
+					for (int axis = 0; axis < N; axis++)
+						if (mMask[n] & upperBit(axis))
+							t += z[n + mStride[axis]];
+					z[n] = (q[n] + mPrecon[n] * t) * mPrecon[n];
+				}
+			}
+			for (int n = 0; n < mCells; n++)
+				if (!mMask[n])
+					z[n] = 0.0;
+		}
+
+		// 参与求解的单元上的内积
+		double dot(const std::vector<double>& a, const std::vector<double>& b) const
+		{
+			const int chunks = (mCells + kChunk - 1) / kChunk;
+			std::vector<double>& partial = mPartial;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(mThreads)
+#endif
+			for (int k = 0; k < chunks; k++) {
+				const int end = (std::min)(mCells, (k + 1) * kChunk);
+				double sum = 0.0;
+				for (int n = k * kChunk; n < end; n++)
+					if (mMask[n])
+						sum += a[n] * b[n];
+				partial[k] = sum;
+			}
+			double sum = 0.0;
+			for (int k = 0; k < chunks; k++)
+				sum += partial[k];
+			return sum;
+		}
+
+		double maxNorm(const std::vector<double>& a) const
+		{
+			double m = 0.0;
+			for (int n = 0; n < mCells; n++)
+				if (mMask[n])
+					m = (std::max)(m, std::fabs(a[n]));
+			return m;
+		}
+
+	private:
+		void precondition(const std::vector<double>& r, std::vector<double>& z)
+		{
+			if (mPreconditioner)
+				mPreconditioner(r, z);
+			else
+				applyPrecon(r, z);
+		}
+
+		static std::uint8_t lowerBit(int axis) { return (std::uint8_t)(1u << (2 * axis)); }
+		static std::uint8_t upperBit(int axis) { return (std::uint8_t)(1u << (2 * axis + 1)); }
+
+		static double diagonal(std::uint8_t mask)
+		{
+			int count = 0;
+			for (; mask; mask &= mask - 1)
+				count++;
+			return count;
+		}
+
+		void coord(int n, int* c) const
+		{
+			for (int d = 0; d < N; d++) {
+				c[d] = n % mDim[d];
+				n /= mDim[d];
+			}
+		}
+
+		static int level(const int* c)
+		{
+			int l = 0;
+			for (int d = 0; d < N; d++)
+				l += c[d];
+			return l;
+		}
+
+		template <typename F>
+		void parallelFor(F fn) const
+		{
+			const int cells = mCells;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(mThreads)
+#endif
+			for (int n = 0; n < cells; n++)
+				fn(n);
+		}
+
+		void removeMean(std::vector<double>& b) const
+		{
+			int active = 0;
+			double sum = 0.0;
+			for (int n = 0; n < mCells; n++)
+				if (mMask[n]) {
+					sum += b[n];
+					active++;
+				}
+			const double mean = active > 0 ? sum / active : 0.0;
+			for (int n = 0; n < mCells; n++)
+				b[n] = mMask[n] ? b[n] - mean : 0.0;
+		}
+
+		int mDim[N];
+		int mStride[N];
+		int mCells;
+		int mThreads;
+		std::vector<std::uint8_t> mMask;		// 流体单元的流体邻居掩码，0 表示不参与求解
+		std::vector<double> mPrecon;			// MIC(0) 因子对角元的倒数
+		std::vector<int> mLevelStart;			// 每层单元在 mLevelCells 中的起点
+		std::vector<int> mLevelCells;			// 按层排列的参与求解的单元
+		std::vector<double> mP, mRhs;			// 解与右端项
+		std::vector<double> mR, mZ, mS, mQ;		// 残差、预条件残差、搜索方向、A s（前代时兼作中间量）
+		std::vector<int> mLevelCount;			// build 中各层的单元数，随后用作按层排列时的写入位置
+		mutable std::vector<double> mPartial;	// dot 中各段的部分和，按 build 时的单元数分配
+		Preconditioner mPreconditioner;		// 为空时使用 MIC(0)
+		int mIterations;
+		double mResidual;
+	};
+}
+
+#endif
@@ -0,0 +1,327 @@
+﻿#pragma once
+#ifndef __SPARSE_GRID_DATA_H__
+#define __SPARSE_GRID_DATA_H__
+
+#include <cstddef>
+#include <vector>
+#include "GridData.h"
+
+namespace Glb {
+
+	// N 维稀疏场存储（类似 VDB 的单层分块结构）
+	// 网格按 8^N 分块，只为取值不等于背景值的块分配内存，其余位置读出背景值
+	// 适合烟雾密度、温度等大部分区域为环境值的单元中心标量
+	// 块编号与块内下标顺序与 GridData 的 Linear 布局一致：
+	//   2D: i + j * n0
+	//   3D: i + k * n0 + j * n0 * n2
+	template <typename T, int N>
+	class SparseGridData
+	{
+	public:
+		static const int kBrickLog2 = 3;
+		static const int kBrickSize = 1 << kBrickLog2;
+		static const int kBrickVolume = 1 << (kBrickLog2 * N);
+
+		SparseGridData() : mBackground(0)
+		{
+			for (int d = 0; d < N; d++) {
+				mExtent[d] = 0;
+				mBricks[d] = 0;
+				mBrickStride[d] = 0;
+				mVoxelStride[d] = 0;
+			}
+		}
+
+		// 按各维长度分配块表并释放所有块
+		void resize(const int* extent, T background)
+		{
+			mBackground = background;
+			int n = 1;
+			for (int d = 0; d < N; d++) {
+				mExtent[d] = extent[d];
+				mBricks[d] = (extent[d] + kBrickSize - 1) >> kBrickLog2;
+				n *= mBricks[d];
+			}
+			// 2D 按 j 行优先；3D 按 j 层、k 行、i 列排列
+			mBrickStride[0] = 1;
+			mVoxelStride[0] = 1;
+			if (N == 2) {
+				mBrickStride[1] = mBricks[0];
+				mVoxelStride[1] = kBrickSize;
+			}
+			else {
+				mBrickStride[N - 1] = mBricks[0];
+				mBrickStride[1] = mBricks[0] * mBricks[N - 1];
+				mVoxelStride[N - 1] = kBrickSize;
+				mVoxelStride[1] = kBrickSize * kBrickSize;
+			}
+			mTable.assign(n, -1);
+			mPool.clear();
+			mFree.clear();
+			mActive.clear();
+		}
+
+		// 释放所有块，保留已申请的内存供之后复用
+		void clear()
+		{
+			for (std::size_t a = 0; a < mActive.size(); a++) {
+				mFree.push_back(mTable[mActive[a]]);
+				mTable[mActive[a]] = -1;
+			}
+			mActive.clear();
+		}
+
+		// 与另一个稀疏场交换块表与内存池，O(1)，用于前后缓冲区轮换
+		void swap(SparseGridData& other)
+		{
+			std::swap(mBackground, other.mBackground);
+			for (int d = 0; d < N; d++) {
+				std::swap(mExtent[d], other.mExtent[d]);
+				std::swap(mBricks[d], other.mBricks[d]);
+				std::swap(mBrickStride[d], other.mBrickStride[d]);
+				std::swap(mVoxelStride[d], other.mVoxelStride[d]);
+			}
+			mTable.swap(other.mTable);
+			mPool.swap(other.mPool);
+			mFree.swap(other.mFree);
+			mActive.swap(other.mActive);
+			mSeeds.swap(other.mSeeds);
+		}
+
+		T background() const { return mBackground; }
+		int extent(int d) const { return mExtent[d]; }
+		int bricks(int d) const { return mBricks[d]; }
+		int brickCount() const { return (int)mTable.size(); }
+		int activeBrickCount() const { return (int)mActive.size(); }
+		const std::vector<int>& activeBricks() const { return mActive; }
+		bool isActiveBrick(int b) const { return mTable[b] >= 0; }
+
+		// 块表与块内存池占用的字节数
+		std::size_t memoryBytes() const
+		{
+			return mPool.capacity() * sizeof(T) + mTable.capacity() * sizeof(int) +
+				(mFree.capacity() + mActive.capacity()) * sizeof(int);
+		}
+
+		int brickOf(int i, int j) const
+		{
+			return (i >> kBrickLog2) * mBrickStride[0] + (j >> kBrickLog2) * mBrickStride[1];
+		}
+
+		int brickOf(int i, int j, int k) const
+		{
+			return (i >> kBrickLog2) * mBrickStride[0] + (j >> kBrickLog2) * mBrickStride[1] +
+				(k >> kBrickLog2) * mBrickStride[2];
+		}
+
+		// 块 b 的第一个体素的坐标
+		void brickOrigin(int b, int* origin) const
+		{
+			if (N == 2) {
+				origin[1] = (b / mBrickStride[1]) << kBrickLog2;
+				origin[0] = (b % mBrickStride[1]) << kBrickLog2;
+			}
+			else {
+				origin[1] = (b / mBrickStride[1]) << kBrickLog2;
+				b %= mBrickStride[1];
+				origin[N - 1] = (b / mBrickStride[N - 1]) << kBrickLog2;
+				origin[0] = (b % mBrickStride[N - 1]) << kBrickLog2;
+			}
+		}
+
+		// 越界或未分配的位置返回背景值
+		T get(int i, int j) const
+		{
+			if (i < 0 || j < 0 || i >= mExtent[0] || j >= mExtent[1])
+				return mBackground;
+			int slot = mTable[brickOf(i, j)];
+			if (slot < 0)
+				return mBackground;
+			return mPool[(std::size_t)slot * kBrickVolume + voxelOffset(i, j)];
+		}
+
+		T get(int i, int j, int k) const
+		{
+			if (i < 0 || j < 0 || k < 0 || i >= mExtent[0] || j >= mExtent[1] || k >= mExtent[N - 1])
+				return mBackground;
+			int slot = mTable[brickOf(i, j, k)];
+			if (slot < 0)
+				return mBackground;
+			return mPool[(std::size_t)slot * kBrickVolume + voxelOffset(i, j, k)];
+		}
+
+		// 不做检查的快速访问，要求 (i, j) 在网格范围内且所在块已分配；可在多线程中写入不同的位置
+		T& at(int i, int j)
+		{
+			assert(mTable[brickOf(i, j)] >= 0);
+			return mPool[(std::size_t)mTable[brickOf(i, j)] * kBrickVolume + voxelOffset(i, j)];
+		}
+
+		T& at(int i, int j, int k)
+		{
+			assert(mTable[brickOf(i, j, k)] >= 0);
+			return mPool[(std::size_t)mTable[brickOf(i, j, k)] * kBrickVolume + voxelOffset(i, j, k)];
+		}
+
+		// 写入背景值不会分配新块；越界写入被忽略
+		void set(int i, int j, T value)
+		{
+			if (i < 0 || j < 0 || i >= mExtent[0] || j >= mExtent[1])
+				return;
+			int b = brickOf(i, j);
+			if (mTable[b] < 0 && value == mBackground)
+				return;
+			mPool[(std::size_t)activateBrick(b) * kBrickVolume + voxelOffset(i, j)] = value;
+		}
+
+		void set(int i, int j, int k, T value)
+		{
+			if (i < 0 || j < 0 || k < 0 || i >= mExtent[0] || j >= mExtent[1] || k >= mExtent[N - 1])
+				return;
+			int b = brickOf(i, j, k);
+			if (mTable[b] < 0 && value == mBackground)
+				return;
+			mPool[(std::size_t)activateBrick(b) * kBrickVolume + voxelOffset(i, j, k)] = value;
+		}
+
+		// 分配块 b（已分配则直接返回），新块填充背景值，返回其在内存池中的槽位
+		int activateBrick(int b)
+		{
+			if (mTable[b] >= 0)
+				return mTable[b];
+			int slot;
+			if (!mFree.empty()) {
+				slot = mFree.back();
+				mFree.pop_back();
+			}
+			else {
+				slot = (int)(mPool.size() / kBrickVolume);
+				mPool.resize(mPool.size() + kBrickVolume);
+			}
+			std::fill(mPool.begin() + (std::size_t)slot * kBrickVolume,
+				mPool.begin() + (std::size_t)(slot + 1) * kBrickVolume, mBackground);
+			mTable[b] = slot;
+			mActive.push_back(b);
+			return slot;
+		}
+
+		// 将已分配块向外扩展 radius 个块（含对角方向），用于覆盖下一步可能到达的区域
+		void dilate(int radius = 1)
+		{
+			if (radius <= 0)
+				return;
+			mSeeds.assign(mActive.begin(), mActive.end());
+			for (std::size_t a = 0; a < mSeeds.size(); a++) {
+				int c[N];
+				brickCoord(mSeeds[a], c);
+				int lo[N], hi[N], n[N];
+				for (int d = 0; d < N; d++) {
+					lo[d] = (std::max)(0, c[d] - radius);
+					hi[d] = (std::min)(mBricks[d] - 1, c[d] + radius);
+					n[d] = lo[d];
+				}
+				// 逐维进位遍历 [lo, hi] 盒子
+				while (true) {
+					int b = 0;
+					for (int d = 0; d < N; d++) b += n[d] * mBrickStride[d];
+					activateBrick(b);
+					int d = 0;
+					while (d < N && ++n[d] > hi[d]) {
+						n[d] = lo[d];
+						d++;
+					}
+					if (d == N)
+						break;
+				}
+			}
+		}
+
+		// 释放所有取值都在背景值 tolerance 范围内的块
+		void prune(T tolerance = T(0))
+		{
+			std::size_t kept = 0;
+			for (std::size_t a = 0; a < mActive.size(); a++) {
+				int b = mActive[a];
+				const T* v = &mPool[(std::size_t)mTable[b] * kBrickVolume];
+				bool uniform = true;
+				for (int x = 0; x < kBrickVolume && uniform; x++) {
+					T diff = v[x] > mBackground ? v[x] - mBackground : mBackground - v[x];
+					uniform = !(diff > tolerance);
+				}
+				if (uniform) {
+					mFree.push_back(mTable[b]);
+					mTable[b] = -1;
+				}
+				else {
+					mActive[kept++] = b;
+				}
+			}
+			mActive.resize(kept);
+		}
+
+		// 遍历已分配块中位于网格范围内的体素，fn(const int* coord, T& value)
+		template <typename F>
+		void forEachActive(F fn)
+		{
+			for (std::size_t a = 0; a < mActive.size(); a++)
+				forEachInBrick(mActive[a], fn);
+		}
+
+		// 遍历块 b 中位于网格范围内的体素，块必须已分配
+		template <typename F>
+		void forEachInBrick(int b, F fn)
+		{
+			int origin[N], end[N], c[N];
+			brickOrigin(b, origin);
+			for (int d = 0; d < N; d++) {
+				end[d] = (std::min)(origin[d] + kBrickSize, mExtent[d]);
+				c[d] = origin[d];
+			}
+			T* v = &mPool[(std::size_t)mTable[b] * kBrickVolume];
+			while (true) {
+				int offset = 0;
+				for (int d = 0; d < N; d++) offset += (c[d] - origin[d]) * mVoxelStride[d];
+				fn((const int*)c, v[offset]);
+				int d = 0;
+				while (d < N && ++c[d] >= end[d]) {
+					c[d] = origin[d];
+					d++;
+				}
+				if (d == N)
+					break;
+			}
+		}
+
+	private:
+		int voxelOffset(int i, int j) const
+		{
+			const int mask = kBrickSize - 1;
+			return (i & mask) + (j & mask) * mVoxelStride[1];
+		}
+
+		int voxelOffset(int i, int j, int k) const
+		{
+			const int mask = kBrickSize - 1;
+			return (i & mask) + (j & mask) * mVoxelStride[1] + (k & mask) * mVoxelStride[2];
+		}
+
+		void brickCoord(int b, int* c) const
+		{
+			brickOrigin(b, c);
+			for (int d = 0; d < N; d++) c[d] >>= kBrickLog2;
+		}
+
+		T mBackground;								// 背景值（未分配块的取值）
+		int mExtent[N];								// 各维长度
+		int mBricks[N];								// 各维块数
+		int mBrickStride[N];						// 块编号的各维步长
+		int mVoxelStride[N];						// 块内下标的各维步长
+		std::vector<int> mTable;					// 块编号 -> 内存池槽位，-1 表示未分配
+		std::vector<T, AlignedAllocator<T> > mPool;	// 块内存池，每个槽位 kBrickVolume 个值
+		std::vector<int> mFree;						// 空闲槽位
+		std::vector<int> mActive;					// 已分配的块编号
+		std::vector<int> mSeeds;					// dilate 使用的临时块列表，复用以避免每步分配
+	};
+}
+
+#endif
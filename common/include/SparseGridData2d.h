@@ -0,0 +1,73 @@
+﻿#pragma once
+#ifndef __SPARSE_GRID_DATA_2D_H__
+#define __SPARSE_GRID_DATA_2D_H__
+
+#include <glm/glm.hpp>
+#include "SparseGridData.h"
+#include "GridInterp.h"
+#include "Half.h"
+
+// 模板实现位于 SparseGridData2d.cpp，并对 float / Half 与各插值策略显式实例化
+
+namespace Glb {
+
+	// 2D 单元中心的稀疏标量场，数据只保存在 SparseGridData 的块中
+	// 未分配的块、网格之外的位置都读出背景值（即 initialize 的默认值），与稠密场填充 ghost 层后的取值相同
+	// 接口与 InterpGridData2d<GridData2d<T>, Policy> 中标量场用到的部分一致，插值结果逐点相同
+	template <typename T, typename Policy>
+	class SparseGridData2d
+	{
+	public:
+		typedef T value_type;
+		typedef Policy InterpPolicy;
+
+		SparseGridData2d();
+
+		// 按 dim、cellSize 重建块表并释放所有块，所有位置取 dfltValue
+		void initialize(double dfltValue = 0.0);
+
+		// 与另一个同类场交换数据，O(1)，用于前后缓冲区轮换
+		void swap(SparseGridData2d& other);
+
+		// 带边界检查的只读访问，越界或未分配的位置返回背景值
+		T operator()(int i, int j) const { return mData.get(i, j); }
+		T get(int i, int j) const { return mData.get(i, j); }
+
+		// 带边界检查的写入，可能分配新块，不能在多线程中调用；越界的写入被丢弃
+		void set(int i, int j, T value) { mData.set(i, j, value); }
+
+		// 快速写入，要求 (i, j) 所在的块已分配（如 forEachInBrick 遍历到的位置）
+		// 只读访问与 get 相同，未分配的位置返回背景值
+		T& at(int i, int j) { return mData.at(i, j); }
+		T at(int i, int j) const { return mData.get(i, j); }
+
+		// 读取时已按背景值处理边界，没有 ghost 层需要维护
+		void fillGhost() {}
+
+		// 给定世界坐标，按 Policy 插值
+		double interpolate(const glm::vec2& pt) const;
+
+		// 批量插值：xs / ys 为 n 个点的世界坐标，结果写入 out
+		void interpolate(const float* xs, const float* ys, double* out, std::size_t n) const;
+		void interpolate(const float* xs, const float* ys, float* out, std::size_t n) const;
+
+		// 网格坐标下按 Policy 插值
+		double sample(const glm::vec2& pos) const;
+
+		glm::vec2 worldToSelf(const glm::vec2& pt) const;
+
+		// 访问底层的块结构，用于按已分配的块遍历、分配和释放块
+		SparseGridData<T, 2>& sparse() { return mData; }
+		const SparseGridData<T, 2>& sparse() const { return mData; }
+
+		T mDfltValue;					// 默认值（背景值）
+		glm::vec2 mMax;					// 二维空间中的最大坐标，表示网格的尺寸
+		float cellSize;					// 网格单元大小
+		int dim[2];						// 网格维度
+
+	private:
+		SparseGridData<T, 2> mData;
+	};
+}
+
+#endif
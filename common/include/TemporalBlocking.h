@@ -0,0 +1,89 @@
+﻿#pragma once
+#ifndef __TEMPORAL_BLOCKING_H__
+#define __TEMPORAL_BLOCKING_H__
+
+#include <algorithm>
+#include <cstddef>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace Glb {
+
+	// 迭代模板计算的时间分块：沿最外一维（2D 的行、3D 的层，下面统称为行）把网格切成行块，
+	// 在行块还留在缓存中时连续做多次遍历，大网格上每次遍历不再都从内存读写整个数组
+	// 约定第 s 次遍历更新第 j 行时只读取第 j - 1、j、j + 1 行；fn(s, j0, j1) 按行号递增更新第 s 次遍历的 [j0, j1) 行
+	// 调度只改变 (行, 遍历) 的执行顺序，每个值的计算表达式和输入不变，结果与逐次遍历整个网格逐位相同
+	class TemporalBlocking
+	{
+	public:
+		// 每个行块的缓存预算，行块的行数取预算除以每行涉及的字节数
+		static const std::size_t kBlockBytes = 256 * 1024;
+
+		static int blockRows(std::size_t rowBytes)
+		{
+			return (std::max)(4, (int)(kBlockBytes / (std::max)(rowBytes, (std::size_t)1)));
+		}
+
+		// 单线程的斜向波前，每次最多连续做 depth 次遍历
+		// 第 j 行的第 s 次遍历总在第 j + 1 行的第 s - 1 次之后、第 j - 1 行的第 s + 1 次之前执行，
+		// 所以也适用于按字典序原地更新、读取第 j - 1 行本次新值的 Gauss-Seidel
+		template <typename F>
+		static void skewed(int rows, int sweeps, int depth, int band, F fn)
+		{
+			depth = (std::max)(depth, 1);
+			for (int s0 = 0; s0 < sweeps; s0 += depth) {
+				const int count = (std::min)(depth, sweeps - s0);
+				trapezoid(0, rows, false, false, count, band, [&](int s, int j0, int j1) { fn(s0 + s, j0, j1); });
+			}
+		}
+
+		// 多线程的分段时间分块，每次最多连续做 depth 次遍历
+		// 要求相邻两次遍历读写不同的数据（红黑的两种颜色、Chebyshev 的两个缓冲区），即第 s 次遍历不改写第 s - 1 次读取的值
+		// 第一阶段每个线程负责一段，第 s 次遍历在两端各收缩 s 行（梯形），段内用斜向波前；
+		// 第二阶段补齐相邻两段交界处的倒三角，第 s 次遍历更新 [J - s, J + s)
+		template <typename F>
+		static void tiled(int rows, int sweeps, int depth, int band, int threads, F fn)
+		{
+			// 倒三角最宽 2 * (depth - 1) 行，每段至少 2 * depth 行，相邻两个倒三角互不读写
+			const int regions = (std::max)(1, (std::min)((std::max)(threads, 1), rows / 2));
+			depth = (std::max)(1, (std::min)(depth, rows / regions / 2));
+			for (int s0 = 0; s0 < sweeps; s0 += depth) {
+				const int count = (std::min)(depth, sweeps - s0);
+				auto sweep = [&](int s, int j0, int j1) { fn(s0 + s, j0, j1); };
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(regions)
+#endif
+				for (int r = 0; r < regions; r++)
+					trapezoid(rows * r / regions, rows * (r + 1) / regions, r > 0, r + 1 < regions, count, band, sweep);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(regions)
+#endif
+				for (int r = 1; r < regions; r++) {
+					const int J = rows * r / regions;
+					for (int s = 1; s < count; s++)
+						sweep(s, J - s, J + s);
+				}
+			}
+		}
+
+	private:
+		// [lo, hi) 内的梯形：第 s 次遍历的下界（shrinkLo）、上界（shrinkHi）各收缩 s 行
+		// 按斜向的行块依次执行，第 b 块在第 s 次遍历更新 [lo + b * band - s, lo + (b + 1) * band - s) 与梯形的交
+		template <typename F>
+		static void trapezoid(int lo, int hi, bool shrinkLo, bool shrinkHi, int sweeps, int band, const F& fn)
+		{
+			band = (std::max)(band, 1);
+			const int blocks = (hi - lo + sweeps - 1 + band - 1) / band;
+			for (int b = 0; b < blocks; b++)
+				for (int s = 0; s < sweeps; s++) {
+					const int j0 = (std::max)(lo + b * band - s, shrinkLo ? lo + s : lo);
+					const int j1 = (std::min)(lo + (b + 1) * band - s, shrinkHi ? hi - s : hi);
+					if (j0 < j1)
+						fn(s, j0, j1);
+				}
+		}
+	};
+}
+
+#endif
@@ -33,11 +33,28 @@ namespace Eulerian2dPara
     int gridNum = theDim2d[0];      // 用于显示的网格数量
 
     // 物理参数
-    float dt = 0.01;                // 时间步长
+    float dt = 0.01;                // 时间步长；开启自适应步长时为每帧推进的时间
+    bool adaptiveTimeStep = false;  // 按 CFL 数把每帧分成若干子步
+    float cflNumber = 2.0f;         // 每个子步内速度分量最多移动的单元数
+    int maxSubsteps = 8;            // 每帧最多的子步数，达到后最后一个子步走完剩余时间
+    int backtraceOrder = 1;         // 对流回溯的 Runge-Kutta 阶数：1 前向 Euler，2 中点法，3 Ralston 三阶法
+    int advectionScheme = 0;        // 对流格式：0 半拉格朗日，1 MacCormack，2 BFECC（后两者按回溯点周围的样本做 min/max 限制）
+    int numThreads = 0;             // 求解器线程数，0 表示使用全部核心
+    int pressureSolver = 0;         // 压力求解方法：0 Gauss-Seidel，1 红黑 SOR，2 Chebyshev 加速 Jacobi，3 MIC(0)-PCG，4 多重网格，5 多重网格预条件 PCG
+    int pressureIterations = 100;   // 每次投影的压力迭代次数（多重网格为循环次数）
+    int multigridCycle = 0;         // 单独使用多重网格时的循环类型：0 V 循环，1 F 循环
+    bool fastPoisson = false;       // 没有固体时用 DCT 直接求解压力（忽略 pressureSolver）
+    float dctSolidFraction = 0.05f; // 固体单元比例不超过该值时，PCG 以 DCT 为预条件子代替 MIC(0)
+    float sorOmega = 1.7f;          // 红黑 SOR 的松弛因子，0 表示按网格尺寸取渐近最优值（迭代次数远大于网格边长时才更快）
+    float pressureTolerance = 0.0f; // 压力求解的相对残差（最大范数）阈值，pressureIterations 为迭代次数上限；0 表示总是迭代到上限
+    int residualInterval = 10;      // 定常迭代（Gauss-Seidel、SOR、Chebyshev）每隔多少次检查一次残差
+    int temporalBlocking = 1;       // 定常迭代在每个行块上连续做的迭代次数（时间分块），1 表示每次迭代遍历整个网格
+    bool warmStart = false;         // 以上一步的压力为初值（Chebyshev 迭代除外）
     float airDensity = 1.3;         // 空气密度
     float ambientTemp = 0.0;        // 环境温度
     float boussinesqAlpha = 500.0;  // Boussinesq 公式中的 alpha 系数
     float boussinesqBeta = 2500.0;  // Boussinesq 公式中的 beta 系数
+    float vorticityConst = 0.0;     // 涡量约束系数 epsilon，力为 epsilon * h * (N x omega)，0 表示关闭
 }
 
 // 3D 欧拉流体模拟参数
@@ -50,6 +67,19 @@ namespace Eulerian3dPara
         {glm::ivec3(theDim3d[0] / 2, theDim3d[1] / 2, 0), glm::vec3(0.0f, 0.0f, 1.0f), 1.0f, 1.0f}
     };
     bool addSolid = true;           // 是否添加固体边界
+    bool brickedLayout = false;     // CPU 端速度、密度、温度场是否使用 8x8x8 分块 + Morton 存储布局
+    std::string outOfCoreDir = "";  // 离线驱动 ooc_sim 未给出 --dir 时各场映射文件所在的目录，空表示当前目录
+    int slabDepth = 8;              // 离线外存求解（ooc_sim --slab）每个处理窗口包含的 z 层数
+    int pressureSolver = 1;         // 离线外存求解（ooc_sim --solver）的压力迭代方法：0 Gauss-Seidel，1 红黑 SOR，2 Chebyshev 加速 Jacobi（PCG 需要整场常驻内存，不用于外存求解）
+    int pressureIterations = 40;    // 离线外存求解（ooc_sim --iterations）每次投影的压力迭代次数
+    float sorOmega = 1.7f;          // 红黑 SOR 的松弛因子，0 表示按网格尺寸取渐近最优值（迭代次数远大于网格边长时才更快）
+    float pressureTolerance = 1e-4f; // CPU 端 MAC 场投影（重采样后）的 PCG 相对残差阈值
+    bool fastPoisson = true;        // CPU 端 MAC 场投影在没有固体时用 DCT 直接求解（GPU 端仍用 Jacobi 迭代）
+    float dctSolidFraction = 0.05f; // 固体单元比例不超过该值时，CPU 端 PCG 以 DCT 为预条件子
+    int gpuPressureIterations = 40; // GPU 端每次投影的 Jacobi 迭代次数上限
+    float gpuPressureTolerance = 1e-3f; // GPU 端 Jacobi 迭代的相对残差（最大范数）阈值，0 表示总是迭代到上限
+    int residualInterval = 10;      // GPU 端每隔多少次迭代检查一次残差（需要与 GPU 同步）
+    bool warmStart = true;          // GPU 端与离线外存求解以上一步的压力为初值（ooc_sim --cold-start 关闭）
 
     // 可视化相关
     float contrast = 1;             // 烟雾对比度
@@ -58,7 +88,12 @@ namespace Eulerian3dPara
     int gridNumY = (int)((float)theDim3d[1] / theDim3d[2] * 100);  // Y 方向网格数
     int gridNumZ = 100;             // Z 方向网格数
 
-    float dt = 0.01;
+    float dt = 0.01;                // 时间步长；开启自适应步长时为每帧推进的时间
+    bool adaptiveTimeStep = false;  // 按 CFL 数把每帧分成若干子步
+    float cflNumber = 2.0f;         // 每个子步内速度分量最多移动的单元数
+    int maxSubsteps = 8;            // 每帧最多的子步数
+    int backtraceOrder = 1;         // 离线外存求解（ooc_sim --order）对流回溯的 Runge-Kutta 阶数：1 前向 Euler，2 中点法，3 Ralston 三阶法
+    int advectionScheme = 0;        // 离线外存求解（ooc_sim --scheme）的对流格式：0 半拉格朗日，1 MacCormack，2 BFECC（后两者按回溯点周围的样本做 min/max 限制）；GPU 端用 useBFECC
     bool useBFECC = false;
     bool useReflection = false;
     
@@ -67,6 +102,7 @@ namespace Eulerian3dPara
     float ambientTemp = 0.0;        // 环境温度
     float boussinesqAlpha = 500.0;  // Boussinesq 公式中的 alpha 系数
     float boussinesqBeta = 2500.0;  // Boussinesq 公式中的 beta 系数
+    float vorticityConst = 0.0;     // 涡量约束系数 epsilon，力为 epsilon * h * (N x omega)，0 表示关闭
 }
 
 // 存储系统中可选的仿真组件
@@ -1,16 +1,19 @@
 #include "GridData2d.h"
+#include "GridSimd.h"
 #include "Configure.h"
 
 namespace Glb
 {
 
-    GridData2d::GridData2d() : mDfltValue(0.0), mMax(0.0, 0.0), cellSize(Eulerian2dPara::theCellSize2d)
+    template <typename T>
+    GridData2d<T>::GridData2d() : mDfltValue(0.0), mMax(0.0, 0.0), cellSize(Eulerian2dPara::theCellSize2d), mGhost(2)
     {
         dim[0] = Eulerian2dPara::theDim2d[0];
         dim[1] = Eulerian2dPara::theDim2d[1];
     }
 
-    GridData2d::GridData2d(const GridData2d &orig) : mDfltValue(orig.mDfltValue)
+    template <typename T>
+    GridData2d<T>::GridData2d(const GridData2d<T> &orig) : mDfltValue(orig.mDfltValue), mGhost(orig.mGhost)
     {
         mData = orig.mData;
         mMax = orig.mMax;
@@ -19,16 +22,19 @@ namespace Glb
         dim[1] = orig.dim[1];
     }
 
-    GridData2d::~GridData2d()
+    template <typename T>
+    GridData2d<T>::~GridData2d()
     {
     }
 
-    ublas::vector<double> &GridData2d::data()
+    template <typename T>
+    GridData<T, 2> &GridData2d<T>::data()
     {
         return mData;
     }
 
-    GridData2d &GridData2d::operator=(const GridData2d &orig)
+    template <typename T>
+    GridData2d<T> &GridData2d<T>::operator=(const GridData2d<T> &orig)
     {
         if (this == &orig)
         {
@@ -39,45 +45,100 @@ namespace Glb
         cellSize = orig.cellSize;
         dim[0] = orig.dim[0];
         dim[1] = orig.dim[1];
+        mGhost = orig.mGhost;
         return *this;
     }
 
-    void GridData2d::initialize(double dfltValue)
+    template <typename T>
+    void GridData2d<T>::initialize(double dfltValue)
     {
         mDfltValue = dfltValue;
         mMax[0] = cellSize * dim[0];
         mMax[1] = cellSize * dim[1];
-        mData.resize(dim[0] * dim[1], false);
-        std::fill(mData.begin(), mData.end(), mDfltValue);
+        int extent[2] = { dim[0], dim[1] };
+        mData.resize(extent, mGhost);
+        mData.fill(mDfltValue);
     }
 
-    double &GridData2d::operator()(int i, int j)
+    template <typename T>
+    void GridData2d<T>::swap(GridData2d<T> &other)
     {
-        static double dflt = 0;
-        dflt = mDfltValue; // HACK: Protect against setting the default value
+        mData.swap(other.mData);
+        std::swap(mDfltValue, other.mDfltValue);
+        std::swap(mMax, other.mMax);
+        std::swap(cellSize, other.cellSize);
+        std::swap(dim[0], other.dim[0]);
+        std::swap(dim[1], other.dim[1]);
+        std::swap(mGhost, other.mGhost);
+    }
 
+    template <typename T>
+    void GridData2d<T>::setGhostLayers(int ghost)
+    {
+        mGhost = ghost;
+    }
+
+    template <typename T>
+    bool GridData2d<T>::clampIndex(int &i, int &j) const
+    {
         if (i < 0 || j < 0 ||
             i > dim[0] - 1 ||
             j > dim[1] - 1)
-            return dflt;
+            return false;
+        return true;
+    }
 
-        int col = i;
-        int row = j * dim[0];
+    template <typename T>
+    void GridData2d<T>::set(int i, int j, T value)
+    {
+        if (clampIndex(i, j))
+            mData.at(i, j) = value;
+    }
+
+    template <typename T>
+    T GridData2d<T>::get(int i, int j) const
+    {
+        if (!clampIndex(i, j))
+            return mDfltValue;
+        return mData.at(i, j);
+    }
 
-        return mData(col + row);
+    template <typename T>
+    void GridData2d<T>::fillGhost()
+    {
+        int g = mData.ghost();
+        int n0 = mData.extent(0);
+        int n1 = mData.extent(1);
+        for (int j = -g; j < n1 + g; j++)
+        {
+            bool interiorRow = (j >= 0 && j < n1);
+            for (int i = -g; i < n0 + g; i++)
+            {
+                if (interiorRow && i == 0)
+                    i = n0; // skip interior cells
+                if (i < n0 + g)
+                    mData.at(i, j) = get(i, j);
+            }
+        }
     }
 
-    void GridData2d::getCell(const glm::vec2 &pt, int &i, int &j)
+    template <typename T>
+    void GridData2d<T>::getCell(const glm::vec2 &pt, int &i, int &j)
     {
         glm::vec2 pos = worldToSelf(pt);
         i = (int)(pos[0] / cellSize);
         j = (int)(pos[1] / cellSize);
     }
 
-    double GridData2d::interpolate(const glm::vec2 &pt)
+    template <typename T>
+    double GridData2d<T>::interpolate(const glm::vec2 &pt)
     {
-        glm::vec2 pos = worldToSelf(pt);
+        return interpolateSelf(worldToSelf(pt));
+    }
 
+    template <typename T>
+    double GridData2d<T>::interpolateSelf(const glm::vec2 &pos) const
+    {
         int i = (int)(pos[0] / cellSize);
         int j = (int)(pos[1] / cellSize);
 
@@ -87,11 +148,12 @@ namespace Glb
 
         assert(fractx < 1.0 && fractx >= 0);
         assert(fracty < 1.0 && fracty >= 0);
+        assert(mData.ghost() >= 2);
 
-        double tmp1 = (*this)(i, j);
-        double tmp2 = (*this)(i, j + 1);
-        double tmp3 = (*this)(i + 1, j);
-        double tmp4 = (*this)(i + 1, j + 1);
+        double tmp1 = mData.at(i, j);
+        double tmp2 = mData.at(i, j + 1);
+        double tmp3 = mData.at(i + 1, j);
+        double tmp4 = mData.at(i + 1, j + 1);
 
         double tmp12 = LERP(tmp1, tmp2, fracty);
         double tmp34 = LERP(tmp3, tmp4, fracty);
@@ -100,7 +162,70 @@ namespace Glb
         return tmp;
     }
 
-    glm::vec2 GridData2d::worldToSelf(const glm::vec2 &pt) const
+    template <typename T>
+    glm::dvec2 GridData2d<T>::sampleOffset() const
+    {
+        return glm::dvec2(cellSize * 0.5, cellSize * 0.5);
+    }
+
+    template <typename T>
+    void GridData2d<T>::interpolate(const float *xs, const float *ys, double *out, std::size_t n)
+    {
+        assert(mData.ghost() >= 2);
+        glm::dvec2 off = sampleOffset();
+        std::size_t p = 0;
+#if defined(GRID_SIMD_AVX2)
+        {
+            const T *base = mData.data();
+            const double scale = 1.0 / cellSize;
+            const __m256i origin = _mm256_set1_epi32((int)mData.index(0, 0));
+            const __m256i strideJ = _mm256_set1_epi32((int)mData.stride(1));
+            const __m256i one = _mm256_set1_epi32(1);
+            for (; p + 8 <= n; p += 8)
+            {
+                __m256 px = simdToSelf(_mm256_loadu_ps(xs + p), off[0], mMax[0]);
+                __m256 py = simdToSelf(_mm256_loadu_ps(ys + p), off[1], mMax[1]);
+                __m256d fxLo, fxHi, fyLo, fyHi;
+                __m256i i = simdCell(px, cellSize, scale, fxLo, fxHi);
+                __m256i j = simdCell(py, cellSize, scale, fyLo, fyHi);
+
+                __m256i idx1 = _mm256_add_epi32(origin, _mm256_add_epi32(i, _mm256_mullo_epi32(j, strideJ))); // (i, j)
+                __m256i idx2 = _mm256_add_epi32(idx1, strideJ);                                              // (i, j + 1)
+                __m256d v1Lo, v1Hi, v2Lo, v2Hi, v3Lo, v3Hi, v4Lo, v4Hi;
+                SimdGather<T>::load(base, idx1, v1Lo, v1Hi);
+                SimdGather<T>::load(base, idx2, v2Lo, v2Hi);
+                SimdGather<T>::load(base, _mm256_add_epi32(idx1, one), v3Lo, v3Hi);
+                SimdGather<T>::load(base, _mm256_add_epi32(idx2, one), v4Lo, v4Hi);
+
+                _mm256_storeu_pd(out + p, simdLerp(simdLerp(v1Lo, v2Lo, fyLo), simdLerp(v3Lo, v4Lo, fyLo), fxLo));
+                _mm256_storeu_pd(out + p + 4, simdLerp(simdLerp(v1Hi, v2Hi, fyHi), simdLerp(v3Hi, v4Hi, fyHi), fxHi));
+            }
+        }
+#endif
+        for (; p < n; p++)
+        {
+            glm::vec2 pos;
+            pos[0] = min(max(0.0, xs[p] - off[0]), mMax[0]);
+            pos[1] = min(max(0.0, ys[p] - off[1]), mMax[1]);
+            out[p] = interpolateSelf(pos);
+        }
+    }
+
+    template <typename T>
+    void GridData2d<T>::interpolate(const float *xs, const float *ys, float *out, std::size_t n)
+    {
+        double buffer[64];
+        for (std::size_t p = 0; p < n; p += 64)
+        {
+            std::size_t m = (std::min)(n - p, (std::size_t)64);
+            interpolate(xs + p, ys + p, buffer, m);
+            for (std::size_t q = 0; q < m; q++)
+                out[p + q] = (float)buffer[q];
+        }
+    }
+
+    template <typename T>
+    glm::vec2 GridData2d<T>::worldToSelf(const glm::vec2 &pt) const
     {
         glm::vec2 out;
         out[0] = min(max(0.0, pt[0] - cellSize * 0.5), mMax[0]);
@@ -108,150 +233,132 @@ namespace Glb
         return out;
     }
 
-    GridData2dX::GridData2dX() : GridData2d()
+    template <typename T>
+    GridData2dX<T>::GridData2dX() : GridData2d<T>()
     {
     }
 
-    GridData2dX::~GridData2dX()
+    template <typename T>
+    GridData2dX<T>::~GridData2dX()
     {
     }
 
-    void GridData2dX::initialize(double dfltValue)
+    template <typename T>
+    void GridData2dX<T>::initialize(double dfltValue)
     {
-        GridData2d::initialize(dfltValue);
-        mMax[0] = cellSize * (dim[0] + 1); // plus one
-        mMax[1] = cellSize * dim[1];
-        mData.resize((dim[0] + 1) * dim[1], false);
-        std::fill(mData.begin(), mData.end(), mDfltValue);
+        GridData2d<T>::initialize(dfltValue);
+        this->mMax[0] = this->cellSize * (this->dim[0] + 1); // plus one
+        this->mMax[1] = this->cellSize * this->dim[1];
+        int extent[2] = { this->dim[0] + 1, this->dim[1] };
+        this->mData.resize(extent, this->mGhost);
+        this->mData.fill(this->mDfltValue);
     }
 
-    double &GridData2dX::operator()(int i, int j)
+    template <typename T>
+    bool GridData2dX<T>::clampIndex(int &i, int &j) const
     {
-        static double dflt = 0;
-        dflt = mDfltValue;
-
-        if (i < 0 || i > dim[0])
-            return dflt;
+        if (i < 0 || i > this->dim[0])
+            return false;
 
         if (j < 0)
             j = 0;
-        if (j > dim[1] - 1)
-            j = dim[1] - 1;
-
-        int col = i;
-        int row = j * (dim[0] + 1);
+        if (j > this->dim[1] - 1)
+            j = this->dim[1] - 1;
+        return true;
+    }
 
-        return mData(row + col);
+    template <typename T>
+    glm::dvec2 GridData2dX<T>::sampleOffset() const
+    {
+        return glm::dvec2(0.0, this->cellSize * 0.5);
     }
 
-    glm::vec2 GridData2dX::worldToSelf(const glm::vec2 &pt) const
+    template <typename T>
+    glm::vec2 GridData2dX<T>::worldToSelf(const glm::vec2 &pt) const
     {
         glm::vec2 out;
-        out[0] = min(max(0.0, pt[0]), mMax[0]);
-        out[1] = min(max(0.0, pt[1] - cellSize * 0.5), mMax[1]);
+        out[0] = min(max(0.0, pt[0]), this->mMax[0]);
+        out[1] = min(max(0.0, pt[1] - this->cellSize * 0.5), this->mMax[1]);
         return out;
     }
 
-    GridData2dY::GridData2dY() : GridData2d()
+    template <typename T>
+    GridData2dY<T>::GridData2dY() : GridData2d<T>()
     {
     }
 
-    GridData2dY::~GridData2dY()
+    template <typename T>
+    GridData2dY<T>::~GridData2dY()
     {
     }
 
-    void GridData2dY::initialize(double dfltValue)
+    template <typename T>
+    void GridData2dY<T>::initialize(double dfltValue)
     {
-        GridData2d::initialize(dfltValue);
-        mMax[0] = cellSize * dim[0];
-        mMax[1] = cellSize * (dim[1] + 1);
-        mData.resize(dim[0] * (dim[1] + 1), false);
-        std::fill(mData.begin(), mData.end(), mDfltValue);
+        GridData2d<T>::initialize(dfltValue);
+        this->mMax[0] = this->cellSize * this->dim[0];
+        this->mMax[1] = this->cellSize * (this->dim[1] + 1);
+        int extent[2] = { this->dim[0], this->dim[1] + 1 };
+        this->mData.resize(extent, this->mGhost);
+        this->mData.fill(this->mDfltValue);
     }
 
-    double &GridData2dY::operator()(int i, int j)
+    template <typename T>
+    bool GridData2dY<T>::clampIndex(int &i, int &j) const
     {
-        static double dflt = 0;
-        dflt = mDfltValue; // Protect against setting the default value
-
-        if (j < 0 || j > dim[1])
-            return dflt;
+        if (j < 0 || j > this->dim[1])
+            return false;
 
         if (i < 0)
             i = 0;
-        if (i > dim[0] - 1)
-            i = dim[0] - 1;
-
-        int col = i;
-        int row = j * dim[0];
-
-        return mData(row + col);
-    }
-
-    glm::vec2 GridData2dY::worldToSelf(const glm::vec2 &pt) const
-    {
-        glm::vec2 out;
-        out[0] = min(max(0.0, pt[0] - cellSize * 0.5), mMax[0]);
-        out[1] = min(max(0.0, pt[1]), mMax[1]);
-        return out;
+        if (i > this->dim[0] - 1)
+            i = this->dim[0] - 1;
+        return true;
     }
 
-    CubicGridData2d::CubicGridData2d() : GridData2d()
+    template <typename T>
+    glm::dvec2 GridData2dY<T>::sampleOffset() const
     {
+        return glm::dvec2(this->cellSize * 0.5, 0.0);
     }
 
-    CubicGridData2d::CubicGridData2d(const CubicGridData2d &orig) : GridData2d(orig)
+    template <typename T>
+    glm::vec2 GridData2dY<T>::worldToSelf(const glm::vec2 &pt) const
     {
+        glm::vec2 out;
+        out[0] = min(max(0.0, pt[0] - this->cellSize * 0.5), this->mMax[0]);
+        out[1] = min(max(0.0, pt[1]), this->mMax[1]);
+        return out;
     }
 
-    CubicGridData2d::~CubicGridData2d()
+    template <typename Base, typename Policy>
+    InterpGridData2d<Base, Policy>::InterpGridData2d() : Base()
     {
+        this->mGhost = (std::max)(this->mGhost, Policy::kGhost);
     }
 
-    double CubicGridData2d::cubic(double q1, double q2, double q3, double q4, double t)
+    template <typename Base, typename Policy>
+    InterpGridData2d<Base, Policy>::InterpGridData2d(const InterpGridData2d<Base, Policy> &orig) : Base(orig)
     {
-        double deltaq = q3 - q2;
-        double d1 = (q3 - q1) * 0.5;
-        double d2 = (q4 - q2) * 0.5;
-
-        // Force monotonic: if d1/d2 differ in sign to deltaq, make it zero
-        if (deltaq > 0.0001)
-        {
-            d1 = d1 > 0 ? d1 : 0.0;
-            d2 = d2 > 0 ? d2 : 0.0;
-        }
-        else if (deltaq < 0.0001)
-        {
-            d1 = d1 < 0 ? d1 : 0.0;
-            d2 = d2 < 0 ? d2 : 0.0;
-        }
-
-        double tmp = q2 + d1 * t + (3 * deltaq - 2 * d1 - d2) * t * t + (-2 * deltaq + d1 + d2) * t * t * t;
-        return tmp;
     }
 
-    double CubicGridData2d::interpY(int i, int j, double fracty)
+    template <typename Base, typename Policy>
+    InterpGridData2d<Base, Policy> &InterpGridData2d<Base, Policy>::operator=(const InterpGridData2d<Base, Policy> &orig)
     {
-        double tmp1 = (*this)(i, j - 1 < 0 ? j : j - 1);
-        double tmp2 = (*this)(i, j);
-        double tmp3 = (*this)(i, j + 1);
-        double tmp4 = (*this)(i, j + 2);
-        return cubic(tmp1, tmp2, tmp3, tmp4, fracty);
+        Base::operator=(orig);
+        return *this;
     }
 
-    double CubicGridData2d::interpX(int i, int j, double fracty, double fractx)
+    template <typename Base, typename Policy>
+    InterpGridData2d<Base, Policy>::~InterpGridData2d()
     {
-        double tmp1 = interpY(i - 1 < 0 ? i : i - 1, j, fracty); // hack
-        double tmp2 = interpY(i, j, fracty);
-        double tmp3 = interpY(i + 1, j, fracty);
-        double tmp4 = interpY(i + 2, j, fracty);
-        return cubic(tmp1, tmp2, tmp3, tmp4, fractx);
     }
 
-    double CubicGridData2d::interpolate(const glm::vec2 &pt)
+    template <typename Base, typename Policy>
+    double InterpGridData2d<Base, Policy>::sample(const glm::vec2 &pos) const
     {
-        // Bicubic Interpolation
-        glm::vec2 pos = worldToSelf(pt);
+        const int W = Policy::kWidth;
+        float cellSize = this->cellSize;
 
         int i = (int)(pos[0] / cellSize);
         int j = (int)(pos[1] / cellSize);
@@ -262,24 +369,85 @@ namespace Glb
 
         assert(fractx < 1.0 && fractx >= 0);
         assert(fracty < 1.0 && fracty >= 0);
+        assert(this->mData.ghost() >= Policy::kGhost);
 
-        double tmp = interpX(i, j, fracty, fractx);
-        return tmp;
+        int xi[W], yj[W];
+        Policy::stencil(i, xi);
+        Policy::stencil(j, yj);
 
-        // Bilinear Interpolation
-        /*
-        float x = (pos[0] / theCellSize2d);
-        float y = (pos[1] / theCellSize2d);
+        // Load the stencil once, one contiguous row per y
+        double s[W][W];
+        for (int b = 0; b < W; b++)
+        {
+            const T *row = &this->mData.at(0, yj[b]);
+            for (int a = 0; a < W; a++)
+                s[b][a] = row[xi[a]];
+        }
 
-        i = (int)(x);
-        j = (int)(y);
+        // Reduce along y, then x
+        double col[W], q[W];
+        for (int a = 0; a < W; a++)
+        {
+            for (int b = 0; b < W; b++)
+                q[b] = s[b][a];
+            col[a] = Policy::reduce(q, fracty);
+        }
+        return Policy::reduce(col, fractx);
+    }
 
-        float s1 = x - i; float t1 = y - j;
-        float s0 = 1.0 - s1; float t0 = 1.0 - t1;
+    template <typename Base, typename Policy>
+    double InterpGridData2d<Base, Policy>::interpolate(const glm::vec2 &pt)
+    {
+        return sample(this->worldToSelf(pt));
+    }
 
-        double tmp = s0 * t0 * (*this)(i, j) + s0 * t1 * (*this)(i, j + 1) + s1 * t0 * (*this)(i + 1, j) + s1 * t1 * (*this)(i + 1, j + 1);
+    template <typename Base, typename Policy>
+    void InterpGridData2d<Base, Policy>::interpolate(const float *xs, const float *ys, double *out, std::size_t n)
+    {
+        interpolateBatch(xs, ys, out, n, typename std::is_same<Policy, InterpLinear>::type());
+    }
 
-        return tmp;
-        */
+    template <typename Base, typename Policy>
+    void InterpGridData2d<Base, Policy>::interpolateBatch(const float *xs, const float *ys, double *out, std::size_t n, std::true_type)
+    {
+        Base::interpolate(xs, ys, out, n);
     }
-}
+
+    template <typename Base, typename Policy>
+    void InterpGridData2d<Base, Policy>::interpolateBatch(const float *xs, const float *ys, double *out, std::size_t n, std::false_type)
+    {
+        glm::dvec2 off = this->sampleOffset();
+        const glm::vec2 &maxPos = this->mMax;
+        for (std::size_t p = 0; p < n; p++)
+        {
+            glm::vec2 pos;
+            pos[0] = min(max(0.0, xs[p] - off[0]), maxPos[0]);
+            pos[1] = min(max(0.0, ys[p] - off[1]), maxPos[1]);
+            out[p] = sample(pos);
+        }
+    }
+
+#define INSTANTIATE_INTERP_GRID_DATA_2D(Policy)                 \
+    template class InterpGridData2d<GridData2d<float>, Policy>;  \
+    template class InterpGridData2d<GridData2d<double>, Policy>; \
+    template class InterpGridData2d<GridData2d<Half>, Policy>;   \
+    template class InterpGridData2d<GridData2dX<float>, Policy>; \
+    template class InterpGridData2d<GridData2dX<double>, Policy>; \
+    template class InterpGridData2d<GridData2dY<float>, Policy>; \
+    template class InterpGridData2d<GridData2dY<double>, Policy>;
+
+    template class GridData2d<float>;
+    template class GridData2d<double>;
+    template class GridData2d<Half>;
+    template class GridData2d<std::uint8_t>;
+    template class GridData2dX<float>;
+    template class GridData2dX<double>;
+    template class GridData2dX<std::uint8_t>;
+    template class GridData2dY<float>;
+    template class GridData2dY<double>;
+    template class GridData2dY<std::uint8_t>;
+    INSTANTIATE_INTERP_GRID_DATA_2D(InterpLinear)
+    INSTANTIATE_INTERP_GRID_DATA_2D(InterpCatmullRom)
+    INSTANTIATE_INTERP_GRID_DATA_2D(InterpMonotoneCubic)
+    INSTANTIATE_INTERP_GRID_DATA_2D(InterpQuadraticBSpline)
+}
\ No newline at end of file
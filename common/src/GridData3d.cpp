@@ -1,17 +1,20 @@
 #include "GridData3d.h"
+#include "GridSimd.h"
 #include "Configure.h"
 
 namespace Glb
 {
 
-    GridData3d::GridData3d() : mDfltValue(0.0), mMax(0.0, 0.0, 0.0), cellSize(Eulerian3dPara::theCellSize3d)
+    template <typename T>
+    GridData3d<T>::GridData3d() : mMax(0.0, 0.0, 0.0), mDfltValue(0.0), cellSize(Eulerian3dPara::theCellSize3d), mGhost(2)
     {
         dim[0] = Eulerian3dPara::theDim3d[0];
         dim[1] = Eulerian3dPara::theDim3d[1];
         dim[2] = Eulerian3dPara::theDim3d[2];
     }
 
-    GridData3d::GridData3d(const GridData3d &orig) : mDfltValue(orig.mDfltValue)
+    template <typename T>
+    GridData3d<T>::GridData3d(const GridData3d<T> &orig) : mDfltValue(orig.mDfltValue), mGhost(orig.mGhost)
     {
         mData = orig.mData;
         mMax = orig.mMax;
@@ -21,16 +24,19 @@ namespace Glb
         dim[2] = orig.dim[2];
     }
 
-    GridData3d::~GridData3d()
+    template <typename T>
+    GridData3d<T>::~GridData3d()
     {
     }
 
-    ublas::vector<double> &GridData3d::data()
+    template <typename T>
+    GridData<T, 3> &GridData3d<T>::data()
     {
         return mData;
     }
 
-    GridData3d &GridData3d::operator=(const GridData3d &orig)
+    template <typename T>
+    GridData3d<T> &GridData3d<T>::operator=(const GridData3d<T> &orig)
     {
         if (this == &orig)
         {
@@ -42,38 +48,106 @@ namespace Glb
         dim[0] = orig.dim[0];
         dim[1] = orig.dim[1];
         dim[2] = orig.dim[2];
+        mGhost = orig.mGhost;
         return *this;
     }
 
-    void GridData3d::initialize(double dfltValue)
+    template <typename T>
+    void GridData3d<T>::initialize(double dfltValue)
     {
         mDfltValue = dfltValue;
         mMax[0] = cellSize * dim[0];
         mMax[1] = cellSize * dim[1];
         mMax[2] = cellSize * dim[2];
-        mData.resize(dim[0] * dim[1] * dim[2], false);
-        std::fill(mData.begin(), mData.end(), mDfltValue);
+        int extent[3] = { dim[0], dim[1], dim[2] };
+        mData.resize(extent, mGhost);
+        mData.fill(mDfltValue);
     }
 
-    double &GridData3d::operator()(int i, int j, int k)
+    template <typename T>
+    void GridData3d<T>::swap(GridData3d<T> &other)
     {
-        static double dflt = 0;
-        dflt = mDfltValue;
+        mData.swap(other.mData);
+        std::swap(mDfltValue, other.mDfltValue);
+        std::swap(mMax, other.mMax);
+        std::swap(cellSize, other.cellSize);
+        std::swap(dim[0], other.dim[0]);
+        std::swap(dim[1], other.dim[1]);
+        std::swap(dim[2], other.dim[2]);
+        std::swap(mGhost, other.mGhost);
+    }
+
+    template <typename T>
+    void GridData3d<T>::setGhostLayers(int ghost)
+    {
+        mGhost = ghost;
+    }
+
+    template <typename T>
+    void GridData3d<T>::setDim(const int *newDim)
+    {
+        dim[0] = newDim[0];
+        dim[1] = newDim[1];
+        dim[2] = newDim[2];
+    }
 
+    template <typename T>
+    void GridData3d<T>::setLayout(GridLayout layout)
+    {
+        mData.setLayout(layout);
+    }
+
+    template <typename T>
+    bool GridData3d<T>::clampIndex(int &i, int &j, int &k) const
+    {
         if (i < 0 || j < 0 || k < 0 ||
             i > dim[0] - 1 ||
             j > dim[1] - 1 ||
             k > dim[2] - 1)
-            return dflt;
+            return false;
+        return true;
+    }
 
-        int col = i;
-        int row = k * dim[0];
-        int stack = j * dim[0] * dim[2];
+    template <typename T>
+    void GridData3d<T>::set(int i, int j, int k, T value)
+    {
+        if (clampIndex(i, j, k))
+            mData.at(i, j, k) = value;
+    }
+
+    template <typename T>
+    T GridData3d<T>::get(int i, int j, int k) const
+    {
+        if (!clampIndex(i, j, k))
+            return mDfltValue;
+        return mData.at(i, j, k);
+    }
 
-        return mData(col + row + stack);
+    template <typename T>
+    void GridData3d<T>::fillGhost()
+    {
+        int g = mData.ghost();
+        int n0 = mData.extent(0);
+        int n1 = mData.extent(1);
+        int n2 = mData.extent(2);
+        for (int j = -g; j < n1 + g; j++)
+        {
+            for (int k = -g; k < n2 + g; k++)
+            {
+                bool interiorRow = (j >= 0 && j < n1 && k >= 0 && k < n2);
+                for (int i = -g; i < n0 + g; i++)
+                {
+                    if (interiorRow && i == 0)
+                        i = n0; // skip interior cells
+                    if (i < n0 + g)
+                        mData.at(i, j, k) = get(i, j, k);
+                }
+            }
+        }
     }
 
-    void GridData3d::getCell(const glm::vec3 &pt, int &i, int &j, int &k)
+    template <typename T>
+    void GridData3d<T>::getCell(const glm::vec3 &pt, int &i, int &j, int &k)
     {
         glm::vec3 pos = worldToSelf(pt);
         i = (int)(pos[0] / cellSize);
@@ -81,10 +155,15 @@ namespace Glb
         k = (int)(pos[2] / cellSize);
     }
 
-    double GridData3d::interpolate(const glm::vec3 &pt)
+    template <typename T>
+    double GridData3d<T>::interpolate(const glm::vec3 &pt)
     {
-        glm::vec3 pos = worldToSelf(pt);
+        return interpolateSelf(worldToSelf(pt));
+    }
 
+    template <typename T>
+    double GridData3d<T>::interpolateSelf(const glm::vec3 &pos) const
+    {
         int i = (int)(pos[0] / cellSize);
         int j = (int)(pos[1] / cellSize);
         int k = (int)(pos[2] / cellSize);
@@ -97,16 +176,17 @@ namespace Glb
         assert(fractx < 1.0 && fractx >= 0);
         assert(fracty < 1.0 && fracty >= 0);
         assert(fractz < 1.0 && fractz >= 0);
+        assert(mData.ghost() >= 2);
 
-        double tmp1 = (*this)(i, j, k);
-        double tmp2 = (*this)(i, j + 1, k);
-        double tmp3 = (*this)(i + 1, j, k);
-        double tmp4 = (*this)(i + 1, j + 1, k);
+        double tmp1 = mData.at(i, j, k);
+        double tmp2 = mData.at(i, j + 1, k);
+        double tmp3 = mData.at(i + 1, j, k);
+        double tmp4 = mData.at(i + 1, j + 1, k);
 
-        double tmp5 = (*this)(i, j, k + 1);
-        double tmp6 = (*this)(i, j + 1, k + 1);
-        double tmp7 = (*this)(i + 1, j, k + 1);
-        double tmp8 = (*this)(i + 1, j + 1, k + 1);
+        double tmp5 = mData.at(i, j, k + 1);
+        double tmp6 = mData.at(i, j + 1, k + 1);
+        double tmp7 = mData.at(i + 1, j, k + 1);
+        double tmp8 = mData.at(i + 1, j + 1, k + 1);
 
         double tmp12 = LERP(tmp1, tmp2, fracty);
         double tmp34 = LERP(tmp3, tmp4, fracty);
@@ -121,7 +201,90 @@ namespace Glb
         return tmp;
     }
 
-    glm::vec3 GridData3d::worldToSelf(const glm::vec3 &pt) const
+    template <typename T>
+    glm::dvec3 GridData3d<T>::sampleOffset() const
+    {
+        return glm::dvec3(cellSize * 0.5, cellSize * 0.5, cellSize * 0.5);
+    }
+
+    template <typename T>
+    void GridData3d<T>::interpolate(const float *xs, const float *ys, const float *zs, double *out, std::size_t n)
+    {
+        assert(mData.ghost() >= 2);
+        glm::dvec3 off = sampleOffset();
+        std::size_t p = 0;
+#if defined(GRID_SIMD_AVX2)
+        // Bricked indices are not a linear combination of i, j, k; use the scalar path
+        if (mData.layout() == GridLayout::Linear)
+        {
+            const T *base = mData.data();
+            const double scale = 1.0 / cellSize;
+            const __m256i origin = _mm256_set1_epi32((int)mData.index(0, 0, 0));
+            const __m256i strideJ = _mm256_set1_epi32((int)mData.stride(1));
+            const __m256i strideK = _mm256_set1_epi32((int)mData.stride(2));
+            const __m256i one = _mm256_set1_epi32(1);
+            for (; p + 8 <= n; p += 8)
+            {
+                __m256 px = simdToSelf(_mm256_loadu_ps(xs + p), off[0], mMax[0]);
+                __m256 py = simdToSelf(_mm256_loadu_ps(ys + p), off[1], mMax[1]);
+                __m256 pz = simdToSelf(_mm256_loadu_ps(zs + p), off[2], mMax[2]);
+                __m256d fxLo, fxHi, fyLo, fyHi, fzLo, fzHi;
+                __m256i i = simdCell(px, cellSize, scale, fxLo, fxHi);
+                __m256i j = simdCell(py, cellSize, scale, fyLo, fyHi);
+                __m256i k = simdCell(pz, cellSize, scale, fzLo, fzHi);
+
+                __m256i idx1 = _mm256_add_epi32(origin, _mm256_add_epi32(i,
+                    _mm256_add_epi32(_mm256_mullo_epi32(j, strideJ), _mm256_mullo_epi32(k, strideK)))); // (i, j, k)
+                __m256i idx2 = _mm256_add_epi32(idx1, strideJ);                                         // (i, j + 1, k)
+                __m256i idx5 = _mm256_add_epi32(idx1, strideK);                                         // (i, j, k + 1)
+                __m256i idx6 = _mm256_add_epi32(idx2, strideK);                                         // (i, j + 1, k + 1)
+                __m256d v[8][2];
+                SimdGather<T>::load(base, idx1, v[0][0], v[0][1]);
+                SimdGather<T>::load(base, idx2, v[1][0], v[1][1]);
+                SimdGather<T>::load(base, _mm256_add_epi32(idx1, one), v[2][0], v[2][1]);
+                SimdGather<T>::load(base, _mm256_add_epi32(idx2, one), v[3][0], v[3][1]);
+                SimdGather<T>::load(base, idx5, v[4][0], v[4][1]);
+                SimdGather<T>::load(base, idx6, v[5][0], v[5][1]);
+                SimdGather<T>::load(base, _mm256_add_epi32(idx5, one), v[6][0], v[6][1]);
+                SimdGather<T>::load(base, _mm256_add_epi32(idx6, one), v[7][0], v[7][1]);
+
+                __m256d fx[2] = { fxLo, fxHi };
+                __m256d fy[2] = { fyLo, fyHi };
+                __m256d fz[2] = { fzLo, fzHi };
+                for (int h = 0; h < 2; h++)
+                {
+                    __m256d tmp1234 = simdLerp(simdLerp(v[0][h], v[1][h], fy[h]), simdLerp(v[2][h], v[3][h], fy[h]), fx[h]);
+                    __m256d tmp5678 = simdLerp(simdLerp(v[4][h], v[5][h], fy[h]), simdLerp(v[6][h], v[7][h], fy[h]), fx[h]);
+                    _mm256_storeu_pd(out + p + 4 * h, simdLerp(tmp1234, tmp5678, fz[h]));
+                }
+            }
+        }
+#endif
+        for (; p < n; p++)
+        {
+            glm::vec3 pos;
+            pos[0] = min(max(0.0, xs[p] - off[0]), mMax[0]);
+            pos[1] = min(max(0.0, ys[p] - off[1]), mMax[1]);
+            pos[2] = min(max(0.0, zs[p] - off[2]), mMax[2]);
+            out[p] = interpolateSelf(pos);
+        }
+    }
+
+    template <typename T>
+    void GridData3d<T>::interpolate(const float *xs, const float *ys, const float *zs, float *out, std::size_t n)
+    {
+        double buffer[64];
+        for (std::size_t p = 0; p < n; p += 64)
+        {
+            std::size_t m = (std::min)(n - p, (std::size_t)64);
+            interpolate(xs + p, ys + p, zs + p, buffer, m);
+            for (std::size_t q = 0; q < m; q++)
+                out[p + q] = (float)buffer[q];
+        }
+    }
+
+    template <typename T>
+    glm::vec3 GridData3d<T>::worldToSelf(const glm::vec3 &pt) const
     {
         glm::vec3 out;
         out[0] = min(max(0.0, pt[0] - cellSize * 0.5), mMax[0]);
@@ -130,211 +293,199 @@ namespace Glb
         return out;
     }
 
-    GridData3dX::GridData3dX() : GridData3d()
+    template <typename T>
+    GridData3dX<T>::GridData3dX() : GridData3d<T>()
     {
     }
 
-    GridData3dX::~GridData3dX()
+    template <typename T>
+    GridData3dX<T>::~GridData3dX()
     {
     }
 
-    void GridData3dX::initialize(double dfltValue)
+    template <typename T>
+    void GridData3dX<T>::initialize(double dfltValue)
     {
-        GridData3d::initialize(dfltValue);
-        mMax[0] = cellSize * (dim[0] + 1);
-        mMax[1] = cellSize * dim[1];
-        mMax[2] = cellSize * dim[2];
-        mData.resize((dim[0] + 1) * dim[1] * dim[2], false);
-        std::fill(mData.begin(), mData.end(), mDfltValue);
+        GridData3d<T>::initialize(dfltValue);
+        this->mMax[0] = this->cellSize * (this->dim[0] + 1);
+        this->mMax[1] = this->cellSize * this->dim[1];
+        this->mMax[2] = this->cellSize * this->dim[2];
+        int extent[3] = { this->dim[0] + 1, this->dim[1], this->dim[2] };
+        this->mData.resize(extent, this->mGhost);
+        this->mData.fill(this->mDfltValue);
     }
 
-    double &GridData3dX::operator()(int i, int j, int k)
+    template <typename T>
+    bool GridData3dX<T>::clampIndex(int &i, int &j, int &k) const
     {
-        static double dflt = 0;
-        dflt = mDfltValue; // Protect against setting the default value
-
-        if (i < 0 || i > dim[0])
-            return dflt;
+        if (i < 0 || i > this->dim[0])
+            return false;
 
         if (j < 0)
             j = 0;
-        if (j > dim[1] - 1)
-            j = dim[1] - 1;
+        if (j > this->dim[1] - 1)
+            j = this->dim[1] - 1;
         if (k < 0)
             k = 0;
-        if (k > dim[2] - 1)
-            k = dim[2] - 1;
+        if (k > this->dim[2] - 1)
+            k = this->dim[2] - 1;
+        return true;
+    }
 
-        int col = i;
-        int row = k * (dim[0] + 1);
-        int stack = j * (dim[0] + 1) * dim[2];
-        return mData(stack + row + col);
+    template <typename T>
+    glm::dvec3 GridData3dX<T>::sampleOffset() const
+    {
+        return glm::dvec3(0.0, this->cellSize * 0.5, this->cellSize * 0.5);
     }
 
-    glm::vec3 GridData3dX::worldToSelf(const glm::vec3 &pt) const
+    template <typename T>
+    glm::vec3 GridData3dX<T>::worldToSelf(const glm::vec3 &pt) const
     {
         glm::vec3 out;
-        out[0] = min(max(0.0, pt[0]), mMax[0]);
-        out[1] = min(max(0.0, pt[1] - cellSize * 0.5), mMax[1]);
-        out[2] = min(max(0.0, pt[2] - cellSize * 0.5), mMax[2]);
+        out[0] = min(max(0.0, pt[0]), this->mMax[0]);
+        out[1] = min(max(0.0, pt[1] - this->cellSize * 0.5), this->mMax[1]);
+        out[2] = min(max(0.0, pt[2] - this->cellSize * 0.5), this->mMax[2]);
         return out;
     }
 
-    GridData3dY::GridData3dY() : GridData3d()
+    template <typename T>
+    GridData3dY<T>::GridData3dY() : GridData3d<T>()
     {
     }
 
-    GridData3dY::~GridData3dY()
+    template <typename T>
+    GridData3dY<T>::~GridData3dY()
     {
     }
 
-    void GridData3dY::initialize(double dfltValue)
+    template <typename T>
+    void GridData3dY<T>::initialize(double dfltValue)
     {
-        GridData3d::initialize(dfltValue);
-        mMax[0] = cellSize * dim[0];
-        mMax[1] = cellSize * (dim[1] + 1);
-        mMax[2] = cellSize * dim[2];
-        mData.resize(dim[0] * (dim[1] + 1) * dim[2], false);
-        std::fill(mData.begin(), mData.end(), mDfltValue);
+        GridData3d<T>::initialize(dfltValue);
+        this->mMax[0] = this->cellSize * this->dim[0];
+        this->mMax[1] = this->cellSize * (this->dim[1] + 1);
+        this->mMax[2] = this->cellSize * this->dim[2];
+        int extent[3] = { this->dim[0], this->dim[1] + 1, this->dim[2] };
+        this->mData.resize(extent, this->mGhost);
+        this->mData.fill(this->mDfltValue);
     }
 
-    double &GridData3dY::operator()(int i, int j, int k)
+    template <typename T>
+    bool GridData3dY<T>::clampIndex(int &i, int &j, int &k) const
     {
-        static double dflt = 0;
-        dflt = mDfltValue;
-
-        if (j < 0 || j > dim[1])
-            return dflt;
+        if (j < 0 || j > this->dim[1])
+            return false;
 
         if (i < 0)
             i = 0;
-        if (i > dim[0] - 1)
-            i = dim[0] - 1;
+        if (i > this->dim[0] - 1)
+            i = this->dim[0] - 1;
         if (k < 0)
             k = 0;
-        if (k > dim[2] - 1)
-            k = dim[2] - 1;
+        if (k > this->dim[2] - 1)
+            k = this->dim[2] - 1;
+        return true;
+    }
 
-        int col = i;
-        int row = k * dim[0];
-        int stack = j * dim[0] * dim[2];
-        return mData(stack + row + col);
+    template <typename T>
+    glm::dvec3 GridData3dY<T>::sampleOffset() const
+    {
+        return glm::dvec3(this->cellSize * 0.5, 0.0, this->cellSize * 0.5);
     }
 
-    glm::vec3 GridData3dY::worldToSelf(const glm::vec3 &pt) const
+    template <typename T>
+    glm::vec3 GridData3dY<T>::worldToSelf(const glm::vec3 &pt) const
     {
         glm::vec3 out;
-        out[0] = min(max(0.0, pt[0] - cellSize * 0.5), mMax[0]);
-        out[1] = min(max(0.0, pt[1]), mMax[1]);
-        out[2] = min(max(0.0, pt[2] - cellSize * 0.5), mMax[2]);
+        out[0] = min(max(0.0, pt[0] - this->cellSize * 0.5), this->mMax[0]);
+        out[1] = min(max(0.0, pt[1]), this->mMax[1]);
+        out[2] = min(max(0.0, pt[2] - this->cellSize * 0.5), this->mMax[2]);
         return out;
     }
 
-    GridData3dZ::GridData3dZ() : GridData3d()
+    template <typename T>
+    GridData3dZ<T>::GridData3dZ() : GridData3d<T>()
     {
     }
 
-    GridData3dZ::~GridData3dZ()
+    template <typename T>
+    GridData3dZ<T>::~GridData3dZ()
     {
     }
 
-    void GridData3dZ::initialize(double dfltValue)
+    template <typename T>
+    void GridData3dZ<T>::initialize(double dfltValue)
     {
-        GridData3d::initialize(dfltValue);
-        mMax[0] = cellSize * dim[0];
-        mMax[1] = cellSize * dim[1];
-        mMax[2] = cellSize * (dim[2] + 1);
-        mData.resize(dim[0] * dim[1] * (dim[2] + 1), false);
-        std::fill(mData.begin(), mData.end(), mDfltValue);
+        GridData3d<T>::initialize(dfltValue);
+        this->mMax[0] = this->cellSize * this->dim[0];
+        this->mMax[1] = this->cellSize * this->dim[1];
+        this->mMax[2] = this->cellSize * (this->dim[2] + 1);
+        int extent[3] = { this->dim[0], this->dim[1], this->dim[2] + 1 };
+        this->mData.resize(extent, this->mGhost);
+        this->mData.fill(this->mDfltValue);
     }
 
-    double &GridData3dZ::operator()(int i, int j, int k)
+    template <typename T>
+    bool GridData3dZ<T>::clampIndex(int &i, int &j, int &k) const
     {
-        static double dflt = 0;
-        dflt = mDfltValue;
-
-        if (k < 0 || k > dim[2])
-            return dflt;
+        if (k < 0 || k > this->dim[2])
+            return false;
 
         if (i < 0)
             i = 0;
-        if (i > dim[0] - 1)
-            i = dim[0] - 1;
+        if (i > this->dim[0] - 1)
+            i = this->dim[0] - 1;
         if (j < 0)
             j = 0;
-        if (j > dim[1] - 1)
-            j = dim[1] - 1;
-
-        int col = i;
-        int row = k * dim[0];
-        int stack = j * dim[0] * (dim[2] + 1);
-
-        return mData(stack + row + col);
+        if (j > this->dim[1] - 1)
+            j = this->dim[1] - 1;
+        return true;
     }
 
-    glm::vec3 GridData3dZ::worldToSelf(const glm::vec3 &pt) const
+    template <typename T>
+    glm::dvec3 GridData3dZ<T>::sampleOffset() const
     {
-        glm::vec3 out;
-        out[0] = min(max(0.0, pt[0] - cellSize * 0.5), mMax[0]);
-        out[1] = min(max(0.0, pt[1] - cellSize * 0.5), mMax[1]);
-        out[2] = min(max(0.0, pt[2]), mMax[2]);
-        return out;
+        return glm::dvec3(this->cellSize * 0.5, this->cellSize * 0.5, 0.0);
     }
 
-    CubicGridData3d::CubicGridData3d() : GridData3d()
+    template <typename T>
+    glm::vec3 GridData3dZ<T>::worldToSelf(const glm::vec3 &pt) const
     {
+        glm::vec3 out;
+        out[0] = min(max(0.0, pt[0] - this->cellSize * 0.5), this->mMax[0]);
+        out[1] = min(max(0.0, pt[1] - this->cellSize * 0.5), this->mMax[1]);
+        out[2] = min(max(0.0, pt[2]), this->mMax[2]);
+        return out;
     }
 
-    CubicGridData3d::CubicGridData3d(const CubicGridData3d &orig) : GridData3d(orig)
+    template <typename Base, typename Policy>
+    InterpGridData3d<Base, Policy>::InterpGridData3d() : Base()
     {
+        this->mGhost = (std::max)(this->mGhost, Policy::kGhost);
     }
 
-    CubicGridData3d::~CubicGridData3d()
+    template <typename Base, typename Policy>
+    InterpGridData3d<Base, Policy>::InterpGridData3d(const InterpGridData3d<Base, Policy> &orig) : Base(orig)
     {
     }
 
-    double CubicGridData3d::cubic(double q1, double q2, double q3, double q4, double t)
+    template <typename Base, typename Policy>
+    InterpGridData3d<Base, Policy> &InterpGridData3d<Base, Policy>::operator=(const InterpGridData3d<Base, Policy> &orig)
     {
-        double deltaq = q3 - q2;
-        double d1 = (q3 - q1) * 0.5;
-        double d2 = (q4 - q2) * 0.5;
-
-        if (deltaq > 0.0001)
-        {
-            d1 = d1 > 0 ? d1 : 0.0;
-            d2 = d2 > 0 ? d2 : 0.0;
-        }
-        else if (deltaq < 0.0001)
-        {
-            d1 = d1 < 0 ? d1 : 0.0;
-            d2 = d2 < 0 ? d2 : 0.0;
-        }
-
-        double tmp = q2 + d1 * t + (3 * deltaq - 2 * d1 - d2) * t * t + (-2 * deltaq + d1 + d2) * t * t * t;
-        return tmp;
+        Base::operator=(orig);
+        return *this;
     }
 
-    double CubicGridData3d::interpY(int i, int j, int k, double fracty)
+    template <typename Base, typename Policy>
+    InterpGridData3d<Base, Policy>::~InterpGridData3d()
     {
-        double tmp1 = (*this)(i, j - 1 < 0 ? j : j - 1, k);
-        double tmp2 = (*this)(i, j, k);
-        double tmp3 = (*this)(i, j + 1, k);
-        double tmp4 = (*this)(i, j + 2, k);
-        return cubic(tmp1, tmp2, tmp3, tmp4, fracty);
     }
 
-    double CubicGridData3d::interpX(int i, int j, int k, double fracty, double fractx)
+    template <typename Base, typename Policy>
+    double InterpGridData3d<Base, Policy>::sample(const glm::vec3 &pos) const
     {
-        double tmp1 = interpY(i - 1 < 0 ? i : i - 1, j, k, fracty);
-        double tmp2 = interpY(i, j, k, fracty);
-        double tmp3 = interpY(i + 1, j, k, fracty);
-        double tmp4 = interpY(i + 2, j, k, fracty);
-        return cubic(tmp1, tmp2, tmp3, tmp4, fractx);
-    }
-
-    double CubicGridData3d::interpolate(const glm::vec3 &pt)
-    {
-        glm::vec3 pos = worldToSelf(pt);
+        const int W = Policy::kWidth;
+        float cellSize = this->cellSize;
 
         int i = (int)(pos[0] / cellSize);
         int j = (int)(pos[1] / cellSize);
@@ -348,13 +499,113 @@ namespace Glb
         assert(fractx < 1.0 && fractx >= 0);
         assert(fracty < 1.0 && fracty >= 0);
         assert(fractz < 1.0 && fractz >= 0);
+        assert(this->mData.ghost() >= Policy::kGhost);
 
-        double tmp1 = interpX(i, j, k - 1 < 0 ? k : k - 1, fracty, fractx);
-        double tmp2 = interpX(i, j, k, fracty, fractx);
-        double tmp3 = interpX(i, j, k + 1, fracty, fractx);
-        double tmp4 = interpX(i, j, k + 2, fracty, fractx);
+        int xi[W], yj[W], zk[W];
+        Policy::stencil(i, xi);
+        Policy::stencil(j, yj);
+        Policy::stencil(k, zk);
 
-        double tmp = cubic(tmp1, tmp2, tmp3, tmp4, fractz);
-        return tmp;
+        // Load the stencil once; rows are contiguous in x for the linear layout
+        double s[W][W][W];
+        if (this->mData.layout() == GridLayout::Linear)
+        {
+            for (int c = 0; c < W; c++)
+                for (int b = 0; b < W; b++)
+                {
+                    const T *row = &this->mData.at(0, yj[b], zk[c]);
+                    for (int a = 0; a < W; a++)
+                        s[c][b][a] = row[xi[a]];
+                }
+        }
+        else
+        {
+            // Bricked indices are separable per axis: compute 3 * W offsets instead of W^3 full indices
+            std::size_t ox[W], oy[W], oz[W];
+            for (int a = 0; a < W; a++)
+            {
+                ox[a] = this->mData.brickedAxis(0, xi[a]);
+                oy[a] = this->mData.brickedAxis(1, yj[a]);
+                oz[a] = this->mData.brickedAxis(2, zk[a]);
+            }
+            const T *base = this->mData.data();
+            for (int c = 0; c < W; c++)
+                for (int b = 0; b < W; b++)
+                    for (int a = 0; a < W; a++)
+                        s[c][b][a] = base[ox[a] + oy[b] + oz[c]];
+        }
+
+        // Reduce along y, then x, then z
+        double slice[W], col[W], q[W];
+        for (int c = 0; c < W; c++)
+        {
+            for (int a = 0; a < W; a++)
+            {
+                for (int b = 0; b < W; b++)
+                    q[b] = s[c][b][a];
+                col[a] = Policy::reduce(q, fracty);
+            }
+            slice[c] = Policy::reduce(col, fractx);
+        }
+        return Policy::reduce(slice, fractz);
+    }
+
+    template <typename Base, typename Policy>
+    double InterpGridData3d<Base, Policy>::interpolate(const glm::vec3 &pt)
+    {
+        return sample(this->worldToSelf(pt));
     }
+
+    template <typename Base, typename Policy>
+    void InterpGridData3d<Base, Policy>::interpolate(const float *xs, const float *ys, const float *zs, double *out, std::size_t n)
+    {
+        interpolateBatch(xs, ys, zs, out, n, typename std::is_same<Policy, InterpLinear>::type());
+    }
+
+    template <typename Base, typename Policy>
+    void InterpGridData3d<Base, Policy>::interpolateBatch(const float *xs, const float *ys, const float *zs, double *out, std::size_t n, std::true_type)
+    {
+        Base::interpolate(xs, ys, zs, out, n);
+    }
+
+    template <typename Base, typename Policy>
+    void InterpGridData3d<Base, Policy>::interpolateBatch(const float *xs, const float *ys, const float *zs, double *out, std::size_t n, std::false_type)
+    {
+        glm::dvec3 off = this->sampleOffset();
+        const glm::vec3 &maxPos = this->mMax;
+        for (std::size_t p = 0; p < n; p++)
+        {
+            glm::vec3 pos;
+            pos[0] = min(max(0.0, xs[p] - off[0]), maxPos[0]);
+            pos[1] = min(max(0.0, ys[p] - off[1]), maxPos[1]);
+            pos[2] = min(max(0.0, zs[p] - off[2]), maxPos[2]);
+            out[p] = sample(pos);
+        }
+    }
+
+#define INSTANTIATE_INTERP_GRID_DATA_3D(Policy)                 \
+    template class InterpGridData3d<GridData3d<float>, Policy>;  \
+    template class InterpGridData3d<GridData3d<double>, Policy>; \
+    template class InterpGridData3d<GridData3d<Half>, Policy>;   \
+    template class InterpGridData3d<GridData3dX<float>, Policy>; \
+    template class InterpGridData3d<GridData3dX<double>, Policy>; \
+    template class InterpGridData3d<GridData3dY<float>, Policy>; \
+    template class InterpGridData3d<GridData3dY<double>, Policy>; \
+    template class InterpGridData3d<GridData3dZ<float>, Policy>; \
+    template class InterpGridData3d<GridData3dZ<double>, Policy>;
+
+    template class GridData3d<float>;
+    template class GridData3d<double>;
+    template class GridData3d<Half>;
+    template class GridData3d<std::uint8_t>;
+    template class GridData3dX<float>;
+    template class GridData3dX<double>;
+    template class GridData3dY<float>;
+    template class GridData3dY<double>;
+    template class GridData3dZ<float>;
+    template class GridData3dZ<double>;
+    INSTANTIATE_INTERP_GRID_DATA_3D(InterpLinear)
+    INSTANTIATE_INTERP_GRID_DATA_3D(InterpCatmullRom)
+    INSTANTIATE_INTERP_GRID_DATA_3D(InterpMonotoneCubic)
+    INSTANTIATE_INTERP_GRID_DATA_3D(InterpQuadraticBSpline)
 }
@@ -0,0 +1,100 @@
+﻿#include "GridPool.h"
+
+#include <cstdlib>
+#include <new>
+
+#if defined(_WIN32)
+#include <malloc.h>
+#elif defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+namespace Glb {
+
+	// 场存储的对齐字节数，与 GridData.h 中的 kGridDataAlignment 一致
+	static const std::size_t kPoolAlignment = 64;
+
+	void* GridMemoryPool::acquire(std::size_t bytes)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			std::multimap<std::size_t, void*>::iterator it = mFree.find(bytes);
+			if (it != mFree.end()) {
+				void* p = it->second;
+				mFree.erase(it);
+				mCachedBytes -= bytes;
+				return p;
+			}
+		}
+		return systemAlloc(bytes);
+	}
+
+	void GridMemoryPool::release(void* p, std::size_t bytes)
+	{
+		if (!p)
+			return;
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			if (mCachedBytes + bytes <= kMaxCachedBytes) {
+				mFree.insert(std::make_pair(bytes, p));
+				mCachedBytes += bytes;
+				return;
+			}
+		}
+		systemFree(p);
+	}
+
+	void GridMemoryPool::trim()
+	{
+		std::multimap<std::size_t, void*> blocks;
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			blocks.swap(mFree);
+			mCachedBytes = 0;
+		}
+		for (std::multimap<std::size_t, void*>::iterator it = blocks.begin(); it != blocks.end(); ++it)
+			systemFree(it->second);
+	}
+
+	std::size_t GridMemoryPool::cachedBytes() const
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		return mCachedBytes;
+	}
+
+	void* GridMemoryPool::systemAlloc(std::size_t bytes)
+	{
+		void* p = NULL;
+#if defined(_WIN32)
+		p = _aligned_malloc(bytes, kPoolAlignment);
+#else
+		std::size_t alignment = kPoolAlignment;
+#if defined(__linux__)
+		// 大块按大页对齐并把长度补齐到整页，整个区间都能由透明大页映射
+		if (bytes >= kHugePageBytes) {
+			alignment = kHugePageBytes;
+			bytes = (bytes + kHugePageBytes - 1) & ~(kHugePageBytes - 1);
+		}
+#endif
+		if (posix_memalign(&p, alignment, bytes) != 0)
+			p = NULL;
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+		// 只是建议，内核未开启 THP 时忽略失败
+		if (p && alignment == kHugePageBytes)
+			madvise(p, bytes, MADV_HUGEPAGE);
+#endif
+#endif
+		if (!p)
+			throw std::bad_alloc();
+		return p;
+	}
+
+	void GridMemoryPool::systemFree(void* p)
+	{
+#if defined(_WIN32)
+		_aligned_free(p);
+#else
+		std::free(p);
+#endif
+	}
+}
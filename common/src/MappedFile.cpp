@@ -0,0 +1,187 @@
+﻿#include "MappedFile.h"
+
+#include <algorithm>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace Glb {
+
+#if defined(_WIN32)
+
+	MappedFile::MappedFile() : mData(NULL), mSize(0), mFile(INVALID_HANDLE_VALUE), mMapping(NULL) {}
+
+	bool MappedFile::open(const std::string& path, std::size_t bytes)
+	{
+		close();
+		if (bytes == 0)
+			return false;
+		HANDLE file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+			FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, NULL);
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+		LARGE_INTEGER length;
+		length.QuadPart = (LONGLONG)bytes;
+		HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READWRITE, (DWORD)length.HighPart, length.LowPart, NULL);
+		void* data = mapping ? MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, bytes) : NULL;
+		if (!data) {
+			if (mapping)
+				CloseHandle(mapping);
+			CloseHandle(file);
+			return false;
+		}
+		mFile = file;
+		mMapping = mapping;
+		mData = data;
+		mSize = bytes;
+		return true;
+	}
+
+	void MappedFile::close()
+	{
+		if (mData) {
+			UnmapViewOfFile(mData);
+			CloseHandle((HANDLE)mMapping);
+			CloseHandle((HANDLE)mFile);
+		}
+		mData = NULL;
+		mSize = 0;
+		mFile = INVALID_HANDLE_VALUE;
+		mMapping = NULL;
+	}
+
+	void MappedFile::prefetch(std::size_t, std::size_t)
+	{
+		// PrefetchVirtualMemory 需要 Windows 8 以上，这里依赖缺页时系统自身的预读
+	}
+
+	void MappedFile::evict(std::size_t offset, std::size_t bytes)
+	{
+		std::size_t page = pageSize();
+		std::size_t begin = (offset + page - 1) / page * page;
+		std::size_t end = (std::min)(offset + bytes, mSize) / page * page;
+		if (!mData || begin >= end)
+			return;
+		char* p = (char*)mData + begin;
+		FlushViewOfFile(p, end - begin);
+		// 对未锁定的页调用 VirtualUnlock 会把它们移出工作集
+		VirtualUnlock(p, end - begin);
+	}
+
+	void MappedFile::flush()
+	{
+		if (mData)
+			FlushViewOfFile(mData, mSize);
+	}
+
+	std::size_t MappedFile::pageSize()
+	{
+		SYSTEM_INFO info;
+		GetSystemInfo(&info);
+		return info.dwPageSize;
+	}
+
+#else
+
+	MappedFile::MappedFile() : mData(NULL), mSize(0), mFd(-1) {}
+
+	bool MappedFile::open(const std::string& path, std::size_t bytes)
+	{
+		close();
+		if (bytes == 0)
+			return false;
+		int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+		if (fd < 0)
+			return false;
+		// 稀疏文件：未写入的部分读出为 0，不占用磁盘
+		if (ftruncate(fd, (off_t)bytes) != 0) {
+			::close(fd);
+			return false;
+		}
+		void* data = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		if (data == MAP_FAILED) {
+			::close(fd);
+			return false;
+		}
+		// 访问按 z 层顺序进行，预读由 prefetch 显式控制
+		madvise(data, bytes, MADV_RANDOM);
+		mFd = fd;
+		mData = data;
+		mSize = bytes;
+		return true;
+	}
+
+	void MappedFile::close()
+	{
+		if (mData) {
+			munmap(mData, mSize);
+			::close(mFd);
+		}
+		mData = NULL;
+		mSize = 0;
+		mFd = -1;
+	}
+
+	void MappedFile::prefetch(std::size_t offset, std::size_t bytes)
+	{
+		std::size_t page = pageSize();
+		std::size_t begin = offset / page * page;
+		std::size_t end = (std::min)(offset + bytes, mSize);
+		if (!mData || begin >= end)
+			return;
+		madvise((char*)mData + begin, end - begin, MADV_WILLNEED);
+	}
+
+	void MappedFile::evict(std::size_t offset, std::size_t bytes)
+	{
+		// 只处理完全落在区间内的页，相邻区间共用的页留给之后的调用
+		std::size_t page = pageSize();
+		std::size_t begin = (offset + page - 1) / page * page;
+		std::size_t end = (std::min)(offset + bytes, mSize) / page * page;
+		if (!mData || begin >= end)
+			return;
+		char* p = (char*)mData + begin;
+		// 共享映射上的 MADV_DONTNEED 不会丢失修改：脏页留在页缓存中由内核写回
+		msync(p, end - begin, MS_ASYNC);
+		madvise(p, end - begin, MADV_DONTNEED);
+	}
+
+	void MappedFile::flush()
+	{
+		if (mData)
+			msync(mData, mSize, MS_SYNC);
+	}
+
+	std::size_t MappedFile::pageSize()
+	{
+		static const std::size_t page = (std::size_t)sysconf(_SC_PAGESIZE);
+		return page;
+	}
+
+#endif
+
+	MappedFile::~MappedFile()
+	{
+		close();
+	}
+
+	void MappedFile::swap(MappedFile& other)
+	{
+		std::swap(mData, other.mData);
+		std::swap(mSize, other.mSize);
+#if defined(_WIN32)
+		std::swap(mFile, other.mFile);
+		std::swap(mMapping, other.mMapping);
+#else
+		std::swap(mFd, other.mFd);
+#endif
+	}
+}
@@ -0,0 +1,119 @@
+﻿#include "SparseGridData2d.h"
+#include "Configure.h"
+
+namespace Glb
+{
+
+    template <typename T, typename Policy>
+    SparseGridData2d<T, Policy>::SparseGridData2d() : mDfltValue(0.0), mMax(0.0, 0.0), cellSize(Eulerian2dPara::theCellSize2d)
+    {
+        dim[0] = Eulerian2dPara::theDim2d[0];
+        dim[1] = Eulerian2dPara::theDim2d[1];
+    }
+
+    template <typename T, typename Policy>
+    void SparseGridData2d<T, Policy>::initialize(double dfltValue)
+    {
+        mDfltValue = dfltValue;
+        mMax[0] = cellSize * dim[0];
+        mMax[1] = cellSize * dim[1];
+        mData.resize(dim, mDfltValue);
+    }
+
+    template <typename T, typename Policy>
+    void SparseGridData2d<T, Policy>::swap(SparseGridData2d<T, Policy> &other)
+    {
+        mData.swap(other.mData);
+        std::swap(mDfltValue, other.mDfltValue);
+        std::swap(mMax, other.mMax);
+        std::swap(cellSize, other.cellSize);
+        std::swap(dim[0], other.dim[0]);
+        std::swap(dim[1], other.dim[1]);
+    }
+
+    template <typename T, typename Policy>
+    double SparseGridData2d<T, Policy>::sample(const glm::vec2 &pos) const
+    {
+        const int W = Policy::kWidth;
+
+        int i = (int)(pos[0] / cellSize);
+        int j = (int)(pos[1] / cellSize);
+
+        double scale = 1.0 / cellSize;
+        double fractx = scale * (pos[0] - i * cellSize);
+        double fracty = scale * (pos[1] - j * cellSize);
+
+        assert(fractx < 1.0 && fractx >= 0);
+        assert(fracty < 1.0 && fracty >= 0);
+
+        int xi[W], yj[W];
+        Policy::stencil(i, xi);
+        Policy::stencil(j, yj);
+
+        // 模板中未分配或越界的位置取背景值，与稠密场 ghost 层中的默认值相同
+        double s[W][W];
+        for (int b = 0; b < W; b++)
+            for (int a = 0; a < W; a++)
+                s[b][a] = mData.get(xi[a], yj[b]);
+
+        // 先沿 y 归约，再沿 x
+        double col[W], q[W];
+        for (int a = 0; a < W; a++)
+        {
+            for (int b = 0; b < W; b++)
+                q[b] = s[b][a];
+            col[a] = Policy::reduce(q, fracty);
+        }
+        return Policy::reduce(col, fractx);
+    }
+
+    template <typename T, typename Policy>
+    double SparseGridData2d<T, Policy>::interpolate(const glm::vec2 &pt) const
+    {
+        return sample(worldToSelf(pt));
+    }
+
+    template <typename T, typename Policy>
+    void SparseGridData2d<T, Policy>::interpolate(const float *xs, const float *ys, double *out, std::size_t n) const
+    {
+        const double off = cellSize * 0.5;
+        for (std::size_t p = 0; p < n; p++)
+        {
+            glm::vec2 pos;
+            pos[0] = (std::min)((std::max)(0.0, xs[p] - off), (double)mMax[0]);
+            pos[1] = (std::min)((std::max)(0.0, ys[p] - off), (double)mMax[1]);
+            out[p] = sample(pos);
+        }
+    }
+
+    template <typename T, typename Policy>
+    void SparseGridData2d<T, Policy>::interpolate(const float *xs, const float *ys, float *out, std::size_t n) const
+    {
+        double buffer[64];
+        for (std::size_t p = 0; p < n; p += 64)
+        {
+            std::size_t m = (std::min)(n - p, (std::size_t)64);
+            interpolate(xs + p, ys + p, buffer, m);
+            for (std::size_t q = 0; q < m; q++)
+                out[p + q] = (float)buffer[q];
+        }
+    }
+
+    template <typename T, typename Policy>
+    glm::vec2 SparseGridData2d<T, Policy>::worldToSelf(const glm::vec2 &pt) const
+    {
+        glm::vec2 out;
+        out[0] = (std::min)((std::max)(0.0, pt[0] - cellSize * 0.5), (double)mMax[0]);
+        out[1] = (std::min)((std::max)(0.0, pt[1] - cellSize * 0.5), (double)mMax[1]);
+        return out;
+    }
+
+#define INSTANTIATE_SPARSE_GRID_DATA_2D(Policy)         \
+    template class SparseGridData2d<float, Policy>;     \
+    template class SparseGridData2d<Half, Policy>;
+
+    INSTANTIATE_SPARSE_GRID_DATA_2D(InterpLinear)
+    INSTANTIATE_SPARSE_GRID_DATA_2D(InterpCatmullRom)
+    INSTANTIATE_SPARSE_GRID_DATA_2D(InterpMonotoneCubic)
+    INSTANTIATE_SPARSE_GRID_DATA_2D(InterpQuadraticBSpline)
+}
@@ -31,6 +31,7 @@ namespace FluidSimulation {
             virtual void shutDown();       // ر,ͷԴ
             virtual void init();           // ʼ
             virtual void simulate();       // ִһģ
+            virtual void resample();       // ǰ״̬,زе·ֱ
             virtual GLuint getRenderedTexture();  // ȡȾ
         };
     }
@@ -10,6 +10,8 @@
 #include <windows.h>
 #include <glm/glm.hpp>
 #include "GridData2d.h"
+#include "SparseGridData2d.h"
+#include "MACGridCore.h"
 #include <Logger.h>
 
 namespace FluidSimulation
@@ -21,7 +23,7 @@ namespace FluidSimulation
          * 洢ٶȡܶȡ¶ȵ
          * MACʽٶȷ洢ģ洢Ԫ
          */
-        class MACGrid2d
+        class MACGrid2d : public Glb::MACGridCore<2, MACGrid2d>
         {
         public:
             MACGrid2d();
@@ -36,8 +38,18 @@ namespace FluidSimulation
 
             // Setup
             void initialize();
+            // ߴ뵱ǰһʱԭø trueڴ棩򷵻 false
+            bool reinitialize();
+            // ǰ״̬ٶȡܶȡ¶ز newDim ϣcellSize 䣬ӳ䵽
+            // ٶȰıţزٶҪͶӰһβɢSolver::onGridResampled
+            // ѭʹеĳߴ磬newDim Ӧ Eulerian2dPara::theDim2d һ
+            void resample(const int *newDim);
             void createSolids();
             void updateSources();
+            // д볡֮ˢ¸ ghost 㣬 at() ʹ
+            void fillGhosts();
+            // ٶȵǰ󻺳O(1)
+            void swapVelocity();
 
             // advect
             glm::vec2 semiLagrangian(const glm::vec2 &pt, double dt);
@@ -74,6 +86,8 @@ namespace FluidSimulation
             bool inSolid(const glm::vec2 &pt, int &i, int &j);
 
             bool intersects(const glm::vec2 &pt, const glm::vec2 &dir, int i, int j, double &time);
+            // ޸ĵԪĹǣµԪ
+            void setSolid(int i, int j, bool solid);
             int numSolidCells();
 
             // pressure
@@ -88,17 +102,32 @@ namespace FluidSimulation
             // Boussinesq Force
             double getBoussinesqForce(const glm::vec2 &pt);
 
-            float cellSize;             // ԪС
-            int dim[2];                 // ά [, ]
-
-            Glb::GridData2dX mU;        // Xٶȷ
-            Glb::GridData2dX mU_half;
-            Glb::GridData2dY mV;        // Yٶȷ
-            Glb::GridData2dY mV_half;
-            Glb::CubicGridData2d mD;    // ܶȳ
-            Glb::CubicGridData2d mT;    // ¶ȳ
-            Glb::CubicGridData2d mP;    // pressure
-            Glb::GridData2d mSolid;     // ǣ1ʾ壬0ʾ壩
+            // cellSizedim Լά޹صļΡɢȡѹϵ MACGridCore ṩ
+            typedef Glb::MACGridCore<2, MACGrid2d> Core;
+
+            // MACGridCore ʹõķʽӿ
+            int solidAt(const int *c);
+            double faceAt(int axis, const int *c);
+            void cellOf(const glm::vec2 &pt, int *c);
+
+            // Ĳֵڱȷ GridInterp.h
+            typedef Glb::DefaultInterpPolicies InterpPolicies;
+            typedef Glb::InterpGridData2d<Glb::GridData2dX<double>, InterpPolicies::Velocity> VelocityXField;
+            typedef Glb::InterpGridData2d<Glb::GridData2dY<double>, InterpPolicies::Velocity> VelocityYField;
+            // ܶȡ¶ֻڵĿд洢λöֵ
+            typedef Glb::SparseGridData2d<Glb::ScalarStorage, InterpPolicies::Scalar> ScalarField;
+
+            // ÿѡ洢ͣٶѹ double float uint8_t
+            VelocityXField mU;                  // Xٶȷ
+            VelocityXField mU_back;             // Xٶȵĺ󻺳д˴ mU 
+            VelocityYField mV;                  // Yٶȷ
+            VelocityYField mV_back;             // Yٶȵĺ󻺳
+            ScalarField mD;                     // ܶȳϡ裻float FLUID_HALF_SCALARS ʱΪ뾫ȣ
+            ScalarField mT;                     // ¶ȳ
+            Glb::CubicGridData2d<double> mP;    // pressure
+            Glb::GridData2d<std::uint8_t> mSolid; // ǣ1ʾ壬0ʾ壩
+            Glb::GridData2dX<std::uint8_t> mFaceMaskU; // ڲ X Ϊ 1ʽ븳ֵ
+            Glb::GridData2dY<std::uint8_t> mFaceMaskV; // ڲ Y Ϊ 1
         };
 
 /**
@@ -9,6 +9,13 @@
 
 #include "MACGrid2d.h"
 #include "Global.h"
+#include "PressureIteration.h"
+#include "TemporalBlocking.h"
+#include "AdaptiveTimeStep.h"
+#include "PressurePCG.h"
+#include "PressureMultigrid.h"
+#include "PressureDCT.h"
+#include <vector>
 
 namespace FluidSimulation {
     namespace Eulerian2d {
@@ -18,7 +25,18 @@ namespace FluidSimulation {
 
             void solve();
 
+            //  MACGrid2d::resample ıߴã³ߴؽڲ壬ͶӰһʹٶɢ
+            void onGridResampled();
+
         protected:
+            // ߴݻ塢Ҷܶȡ¶ȵĺ󻺳
+            void resizeBuffers();
+
+            // һӣ벽ĶͶӰ
+            void substep(float dt);
+
+            // ٶȷֵֵвйԼ
+            double maxVelocity();
 
             void vel_step(float dt);
             void dens_step(float dt);
@@ -28,13 +46,98 @@ namespace FluidSimulation {
             // 3. projection
             void advect(float dt);
 
+            // ԼͬһмӵϣԼ computeConfinement ڵԪ
             void computeforces(float dt);
 
+            // Ԫĵ omega = dv/dx - du/dyд mCurl
+            void computeCurl();
+
+            // ԪĵԼд mConfineXmConfineY
+            void computeConfinement();
+
             void project(float dt);
 
+            // ѹ Eulerian2dPara::pressureSolver ѡҶȡ mRhs mGrid.mP Ϊֵд mGrid.mP
+            // вҶ tolerance »޺ֹͣʵʵ
+            // ÿ Eulerian2dPara::residualInterval μһβвμ֮䰴 Eulerian2dPara::temporalBlocking ʱֿ
+            int relaxGaussSeidel(int iterations, double tolerance);
+            int relaxRedBlackSOR(int iterations, double omega, double tolerance);
+            int relaxChebyshevJacobi(int iterations, double tolerance);
+            // PCG Ԥ
+            enum Preconditioner { kPreconMIC, kPreconMultigrid, kPreconDCT };
+            int solvePCG(int maxIterations, double tolerance, Preconditioner precon = kPreconMIC);
+            // ѭѭÿѭӼ mMultigrid.cycleFactors()
+            int solveMultigrid(int maxCycles, double tolerance);
+            // ûйʱ DCT ֱ⣬mDCT Ѱǰ
+            void solveDCT();
+
+            // mGrid.mP Բв֮ȣҶȥ Neumann вɽĲ֣
+            double pressureResidual();
+            //  iteration εǷֹͣ
+            bool pressureConverged(int iteration, double tolerance);
+
             void reflectVelocity();
 
+            // ܶȡ¶ȵĶֻڵĿ鼰ڽ
+            void advectScalars(float dt);
+
+            //  Eulerian2dPara::advectionScheme յĽMacCormack / BFECCݵΧ phi Ƶ [min, max]
+            // hat ΪյĽԭдأΣл飩ţյ㡢Ԫ±ȡԵһд
+            // traceForward Ϊ false ʱһεõ׷յ㣨ܶȡ¶ȹʱֻ׷һΣ
+            template <typename Field, typename Position>
+            void correctAdvection(Field& hat, const Field& phi, int segments, Position position, float dt, bool traceForward = true);
+
             MACGrid2d& mGrid;
+
+            // ܶȡ¶ȵĺ󻺳д˴ mGrid.mDmGrid.mT 
+            // ʽҲΪյĽBFECC дΪĳֵ
+            MACGrid2d::ScalarField mNextD;
+            MACGrid2d::ScalarField mNextT;
+
+            // ʱյֵԤȷ
+            std::vector<float> mSampleX;
+            std::vector<float> mSampleY;
+            std::vector<double> mSampleOut;
+            std::vector<double> mSampleOutT;       // ¶ȵĲֵ mSampleOutܶȣͬʱʹ
+            std::vector<int> mSampleI;             // ڵĵԪ棩±꣬ʱʹ
+            std::vector<int> mSampleJ;
+            std::vector<std::size_t> mSegmentBegin; // ÿΣл飩е͸
+            std::vector<std::size_t> mSegmentCount;
+
+            // MacCormack / BFECC ׷յ㼰ڰսϵĲֵ
+            std::vector<float> mForwardX;
+            std::vector<float> mForwardY;
+            std::vector<double> mTilde;
+
+            // йԼĲֽmaxVelocitypressureResidualԤȷ
+            std::vector<double> mRowMax;
+            std::vector<double> mRowSum;
+            std::vector<double> mRowMaxR;
+            std::vector<double> mRowMaxB;
+            std::vector<int> mRowCount;
+
+            // Chebyshev һڸεȨأֻڶγʱ·
+            std::vector<double> mChebyshevWeights;
+
+            // ԪĵԼʱÿμǰ
+            Glb::GridData2d<double> mCurl;
+            Glb::GridData2d<double> mConfineX;  // ԪĵԼȡƽ
+            Glb::GridData2d<double> mConfineY;
+
+            // ѹ̵ҶÿͶӰһ
+            Glb::GridData2d<double> mRhs;
+
+            // Chebyshev һεѹ mGrid.mP ֻ
+            Glb::CubicGridData2d<double> mPressurePrev;
+
+            // PCG ÿͶӰǰĵԪؽԤ
+            Glb::PressurePCG<2> mPCG;
+
+            // ʹûΪ mPCG ԤӣͬÿͶӰؽ
+            Glb::PressureMultigrid<2> mMultigrid;
+
+            //  DCT ֱӽⷨ޹ʱʱΪ mPCG Ԥ
+            Glb::PressureDCT<2> mDCT;
         };
     }
 }
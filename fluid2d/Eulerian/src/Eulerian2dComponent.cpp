@@ -12,7 +12,9 @@ namespace FluidSimulation {
          * رͷԴ
          */
         void Eulerian2dComponent::shutDown() {
-            delete renderer, solver, grid;
+            delete renderer;
+            delete solver;
+            delete grid;
             renderer = NULL;
             solver = NULL;
             grid = NULL;
@@ -20,14 +22,22 @@ namespace FluidSimulation {
 
         // ʼ
         void Eulerian2dComponent::init() {
+            // ռʱ
+            Glb::Timer::getInstance().clear();
+
+            // ߴδı(Rerun)ʱԭø,Ⱦڴ,ֻؽ
+            if (grid != NULL && renderer != NULL && grid->reinitialize()) {
+                delete solver;
+                solver = new Solver(*grid);
+                Glb::Logger::getInstance().addLog("2d MAC gird reset in place.");
+                return;
+            }
+
             // Ѿʼ,ͷԴ
             if (renderer != NULL || solver != NULL || grid != NULL) {
                 shutDown();
             }
 
-            // ռʱ
-            Glb::Timer::getInstance().clear();
-
             // MAC
             grid = new MACGrid2d();
 
@@ -40,6 +50,27 @@ namespace FluidSimulation {
             solver = new Solver(*grid);
         }
 
+        // زе·ֱ,Դλð㵽
+        void Eulerian2dComponent::resample() {
+            if (grid == NULL || renderer == NULL || solver == NULL) {
+                init();
+                return;
+            }
+
+            const int *newDim = Eulerian2dPara::theDim2d;
+            for (auto &src : Eulerian2dPara::source) {
+                for (int d = 0; d < 2; d++) {
+                    int p = src.position[d] * newDim[d] / grid->dim[d];
+                    src.position[d] = (std::max)(0, (std::min)(p, newDim[d] - 1));
+                }
+            }
+            grid->resample(newDim);
+            solver->onGridResampled();
+
+            Glb::Logger::getInstance().addLog("2d MAC gird resampled. dimension: " + std::to_string(newDim[0]) + "x"
+                + std::to_string(newDim[1]) + ".");
+        }
+
         // ִһģ
         void Eulerian2dComponent::simulate() {
             // Դ
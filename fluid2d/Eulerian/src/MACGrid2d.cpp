@@ -3,6 +3,7 @@
 #include <math.h>
 #include <map>
 #include <stdio.h>
+#include <vector>
 
 namespace FluidSimulation
 {
@@ -17,13 +18,17 @@ namespace FluidSimulation
             initialize();
         }
 
-        MACGrid2d::MACGrid2d(const MACGrid2d &orig)
+        MACGrid2d::MACGrid2d(const MACGrid2d &orig) : Core(orig)
         {
             mU = orig.mU;
             mV = orig.mV;
+            mU_back = orig.mU_back;
+            mV_back = orig.mV_back;
             mD = orig.mD;
             mT = orig.mT;
             mSolid = orig.mSolid;
+            mFaceMaskU = orig.mFaceMaskU;
+            mFaceMaskV = orig.mFaceMaskV;
         }
 
         MACGrid2d &MACGrid2d::operator=(const MACGrid2d &orig)
@@ -32,11 +37,16 @@ namespace FluidSimulation
             {
                 return *this;
             }
+            Core::operator=(orig);
             mU = orig.mU;
             mV = orig.mV;
+            mU_back = orig.mU_back;
+            mV_back = orig.mV_back;
             mD = orig.mD;
             mT = orig.mT;
             mSolid = orig.mSolid;
+            mFaceMaskU = orig.mFaceMaskU;
+            mFaceMaskV = orig.mFaceMaskV;
 
             return *this;
         }
@@ -49,6 +59,9 @@ namespace FluidSimulation
         {
             mU.initialize(0.0);
             mV.initialize(0.0);
+            mU_back.initialize(0.0);
+            mV_back.initialize(0.0);
+            mP.initialize(0.0);
             mD.initialize(0.0);
             mT.initialize(Eulerian2dPara::ambientTemp);
         }
@@ -59,9 +72,24 @@ namespace FluidSimulation
             if (Eulerian2dPara::addSolid) {
                 int j = dim[1] / 2;
                 for (int i = dim[0] / 4; i < dim[0] * 3 / 4; i++) {
-                    mSolid(i, j) = 1;
+                    mSolid.set(i, j, 1);
                 }
             }
+            mSolid.fillGhost();
+            buildCellFlags();
+
+            // ߽ϵ棨Լ ghost 㣩
+            // ٶȳ ghost һ£ʽ洢±ԪضӦ
+            mFaceMaskU.setGhostLayers(mU.data().ghost());
+            mFaceMaskV.setGhostLayers(mV.data().ghost());
+            mFaceMaskU.initialize(0);
+            mFaceMaskV.initialize(0);
+            for (int j = 0; j < dim[1]; j++)
+                for (int i = 1; i < dim[0]; i++)
+                    mFaceMaskU.at(i, j) = 1;
+            for (int j = 1; j < dim[1]; j++)
+                for (int i = 0; i < dim[0]; i++)
+                    mFaceMaskV.at(i, j) = 1;
         }
 
         void MACGrid2d::updateSources()
@@ -69,11 +97,27 @@ namespace FluidSimulation
             for (int i = 0; i < Eulerian2dPara::source.size(); i++) {
                 int x = Eulerian2dPara::source[i].position.x;
                 int y = Eulerian2dPara::source[i].position.y;
-                mT(x, y) = Eulerian2dPara::source[i].temp;
-                mD(x, y) = Eulerian2dPara::source[i].density;
-                mU(x, y) = Eulerian2dPara::source[i].velocity.x;
-                mV(x, y) = Eulerian2dPara::source[i].velocity.y;
+                mT.set(x, y, Eulerian2dPara::source[i].temp);
+                mD.set(x, y, Eulerian2dPara::source[i].density);
+                mU.set(x, y, Eulerian2dPara::source[i].velocity.x);
+                mV.set(x, y, Eulerian2dPara::source[i].velocity.y);
             }
+            fillGhosts();
+        }
+
+        void MACGrid2d::swapVelocity()
+        {
+            mU.swap(mU_back);
+            mV.swap(mV_back);
+        }
+
+        void MACGrid2d::fillGhosts()
+        {
+            mU.fillGhost();
+            mV.fillGhost();
+            mD.fillGhost();
+            mT.fillGhost();
+            mSolid.fillGhost();
         }
 
         void MACGrid2d::initialize()
@@ -83,6 +127,85 @@ namespace FluidSimulation
             assert(checkDivergence());
         }
 
+        bool MACGrid2d::reinitialize()
+        {
+            if (cellSize != Eulerian2dPara::theCellSize2d ||
+                dim[0] != Eulerian2dPara::theDim2d[0] || dim[1] != Eulerian2dPara::theDim2d[1])
+                return false;
+            initialize();
+            return true;
+        }
+
+        // dst Ѱ³ߴʼ (i, j) λ (i + off) * h src ȡͬһλ pos / stretch Ĳֵ
+        // лвУÿеĲֵ
+        template <typename Field>
+        static void resampleField(Field &src, Field &dst, const glm::vec2 &off, const glm::vec2 &stretch, double valueScale)
+        {
+            const int n0 = dst.data().extent(0);
+            const int n1 = dst.data().extent(1);
+            const float h = dst.cellSize;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+            for (int j = 0; j < n1; j++) {
+                std::vector<float> xs(n0), ys(n0);
+                std::vector<double> out(n0);
+                for (int i = 0; i < n0; i++) {
+                    xs[i] = (i + off.x) * h / stretch.x;
+                    ys[i] = (j + off.y) * h / stretch.y;
+                }
+                src.interpolate(xs.data(), ys.data(), out.data(), n0);
+                for (int i = 0; i < n0; i++)
+                    dst.at(i, j) = (typename Field::value_type)(out[i] * valueScale);
+            }
+            dst.fillGhost();
+        }
+
+        // ϡд¿ʱڴ棬дд룻ڱֵλò
+        static void resampleField(MACGrid2d::ScalarField &src, MACGrid2d::ScalarField &dst, const glm::vec2 &off, const glm::vec2 &stretch, double valueScale)
+        {
+            const int n0 = dst.dim[0];
+            const int n1 = dst.dim[1];
+            const float h = dst.cellSize;
+            std::vector<float> xs(n0), ys(n0);
+            std::vector<double> out(n0);
+            for (int j = 0; j < n1; j++) {
+                for (int i = 0; i < n0; i++) {
+                    xs[i] = (i + off.x) * h / stretch.x;
+                    ys[i] = (j + off.y) * h / stretch.y;
+                }
+                src.interpolate(xs.data(), ys.data(), out.data(), n0);
+                for (int i = 0; i < n0; i++)
+                    dst.set(i, j, (MACGrid2d::ScalarField::value_type)(out[i] * valueScale));
+            }
+        }
+
+        void MACGrid2d::resample(const int *newDim)
+        {
+            glm::vec2 stretch((float)newDim[0] / dim[0], (float)newDim[1] / dim[1]);
+            VelocityXField oldU(mU);
+            VelocityYField oldV(mV);
+            ScalarField oldD(mD);
+            ScalarField oldT(mT);
+
+            dim[0] = newDim[0];
+            dim[1] = newDim[1];
+            Glb::GridData2d<double> *velocityFields[] = { &mU, &mU_back, &mV, &mV_back, &mP };
+            for (Glb::GridData2d<double> *f : velocityFields) {
+                f->dim[0] = dim[0];
+                f->dim[1] = dim[1];
+            }
+            mD.dim[0] = mT.dim[0] = mSolid.dim[0] = mFaceMaskU.dim[0] = mFaceMaskV.dim[0] = dim[0];
+            mD.dim[1] = mT.dim[1] = mSolid.dim[1] = mFaceMaskU.dim[1] = mFaceMaskV.dim[1] = dim[1];
+            reset();
+
+            resampleField(oldU, mU, glm::vec2(0.0f, 0.5f), stretch, stretch.x);
+            resampleField(oldV, mV, glm::vec2(0.5f, 0.0f), stretch, stretch.y);
+            resampleField(oldD, mD, glm::vec2(0.5f), stretch, 1.0);
+            resampleField(oldT, mT, glm::vec2(0.5f), stretch, 1.0);
+            createSolids();
+        }
+
         // Boussinesq Force
         double MACGrid2d::getBoussinesqForce(const glm::vec2 &pos)
         {
@@ -99,18 +222,8 @@ namespace FluidSimulation
         // ɢ
         double MACGrid2d::getDivergence(int i, int j)
         {
-
-            double x1 = isSolidCell(i + 1, j) ? 0.0 : mU(i + 1, j);
-            double x0 = isSolidCell(i - 1, j) ? 0.0 : mU(i, j);
-
-            double y1 = isSolidCell(i, j + 1) ? 0.0 : mV(i, j + 1);
-            double y0 = isSolidCell(i, j - 1) ? 0.0 : mV(i, j);
-
-            double xdiv = x1 - x0;
-            double ydiv = y1 - y0;
-            double div = (xdiv + ydiv) / cellSize;
-
-            return div;
+            int c[2] = {i, j};
+            return Core::getDivergence(c);
         }
 
         double MACGrid2d::checkDivergence(int i, int j)
@@ -140,126 +253,61 @@ namespace FluidSimulation
 
         glm::vec2 MACGrid2d::semiLagrangian(const glm::vec2 &pt, double dt)
         {
-            glm::vec2 vel = getVelocity(pt);
-            glm::vec2 pos = pt - vel * (float)dt;
-
-            pos[0] = max(0.0, min((dim[0] - 1) * cellSize, pos[0]));
-            pos[1] = max(0.0, min((dim[1] - 1) * cellSize, pos[1]));
-
-            int i, j;
-            if (inSolid(pt, i, j))
-            {
-                double t = 0;
-                if (intersects(pt, vel, i, j, t))
-                {
-                    pos = pt - vel * (float)t;
-                }
-                else
-                {
-                    Glb::Logger::getInstance().addLog("Error: something goes wrong during advection");
-                }
-            }
-            return pos;
+            return Core::semiLagrangian(pt, dt);
         }
 
         // ȡཻľʱ
         bool MACGrid2d::intersects(const glm::vec2 &wPos, const glm::vec2 &wDir, int i, int j, double &time)
         {
-            glm::vec2 pos = getCenter(i, j);
-
-            glm::vec2 rayStart = wPos - pos;
-            glm::vec2 rayDir = wDir;
-
-            double tmin = -9999999999.0;
-            double tmax = 9999999999.0;
-
-            double min = -0.5 * cellSize;
-            double max = 0.5 * cellSize;
-
-            for (int i = 0; i < 3; i++)
-            {
-                double e = rayStart[i];
-                double f = rayDir[i];
-                if (fabs(f) > 0.000000001)
-                {
-                    double t1 = (min - e) / f;
-                    double t2 = (max - e) / f;
-                    if (t1 > t2)
-                        std::swap(t1, t2);
-                    if (t1 > tmin)
-                        tmin = t1;
-                    if (t2 < tmax)
-                        tmax = t2;
-                    if (tmin > tmax)
-                        return false;
-                    if (tmax < 0)
-                        return false;
-                }
-                else if (e < min || e > max)
-                    return false;
-            }
-            if (tmin >= 0)
-            {
-                time = tmin;
-                return true;
-            }
-            else
-            {
-                time = tmax;
-                return true;
-            }
-            return false;
+            int c[2] = {i, j};
+            return Core::intersects(wPos, wDir, c, time);
         }
 
 
         int MACGrid2d::getIndex(int i, int j)
         {
-            if (i < 0 || i > dim[0] - 1)
-                return -1;
-            if (j < 0 || j > dim[1] - 1)
-                return -1;
-
-            int col = i;
-            int row = j * dim[0];
-            return col + row;
+            int c[2] = {i, j};
+            return Core::getIndex(c);
         }
 
 
         void MACGrid2d::getCell(int index, int &i, int &j)
         {
-            j = (int)index / dim[0]; // row
-            i = index - j * dim[0];  // col
+            int c[2];
+            Core::getCell(index, c);
+            i = c[0];
+            j = c[1];
         }
 
 
         glm::vec2 MACGrid2d::getCenter(int i, int j)
         {
-            double xstart = cellSize / 2.0;
-            double ystart = cellSize / 2.0;
-
-            double x = xstart + i * cellSize;
-            double y = ystart + j * cellSize;
-            return glm::vec2(x, y);
+            int c[2] = {i, j};
+            return Core::getCenter(c);
         }
 
         glm::vec2 MACGrid2d::getLeft(int i, int j)
         {
-            return getCenter(i, j) - glm::vec2(cellSize * 0.5, 0.0);
+            int c[2] = {i, j};
+            return getFace(c, X, -1);
         }
 
         glm::vec2 MACGrid2d::getRight(int i, int j)
         {
-            return getCenter(i, j) + glm::vec2(cellSize * 0.5, 0.0);
+            int c[2] = {i, j};
+            return getFace(c, X, 1);
         }
 
         glm::vec2 MACGrid2d::getTop(int i, int j)
         {
-            return getCenter(i, j) + glm::vec2(0.0, cellSize * 0.5);
+            int c[2] = {i, j};
+            return getFace(c, Y, 1);
         }
 
         glm::vec2 MACGrid2d::getBottom(int i, int j)
         {
-            return getCenter(i, j) - glm::vec2(0.0, cellSize * 0.5);
+            int c[2] = {i, j};
+            return getFace(c, Y, -1);
         }
 
         glm::vec2 MACGrid2d::getVelocity(const glm::vec2 &pt)
@@ -304,71 +352,47 @@ namespace FluidSimulation
 
         bool MACGrid2d::inSolid(const glm::vec2 &pt)
         {
-            int i, j, k;
-            mSolid.getCell(pt, i, j);
-            return isSolidCell(i, j) == 1;
+            int c[2];
+            cellOf(pt, c);
+            return Core::isSolidCell(c) == 1;
         }
 
         bool MACGrid2d::inSolid(const glm::vec2 &pt, int &i, int &j)
         {
-            mSolid.getCell(pt, i, j);
-            return isSolidCell(i, j) == 1;
+            int c[2];
+            cellOf(pt, c);
+            i = c[0];
+            j = c[1];
+            return Core::isSolidCell(c) == 1;
         }
 
         int MACGrid2d::isSolidCell(int i, int j)
         {
-            bool containerBoundary = (i < 0 || i > dim[0] - 1) ||
-                                     (j < 0 || j > dim[1] - 1);
-
-            bool objectBoundary = (mSolid(i, j) == 1);
-
-            return containerBoundary || objectBoundary ? 1 : 0;
+            int c[2] = {i, j};
+            return Core::isSolidCell(c);
         }
 
         int MACGrid2d::isSolidFace(int i, int j, MACGrid2d::Direction d)
         {
-            if (d == X && (i == 0 || i == dim[0]))
-                return 1;
-            else if (d == Y && (j == 0 || j == dim[1]))
-                return 1;
-
-            if (d == X && (mSolid(i, j) || mSolid(i - 1, j)))
-                return 1;
-            if (d == Y && (mSolid(i, j) || mSolid(i, j - 1)))
-                return 1;
-
-            return 0;
+            int c[2] = {i, j};
+            return Core::isSolidFace(c, d);
         }
 
 
         bool MACGrid2d::isNeighbor(int i0, int j0, int i1, int j1)
         {
-            if (abs(i0 - i1) == 1 && j0 == j1)
-                return true;
-            if (abs(j0 - j1) == 1 && i0 == i1)
-                return true;
-            return false;
+            int a[2] = {i0, j0};
+            int b[2] = {i1, j1};
+            return Core::isNeighbor(a, b);
         }
 
 
         double MACGrid2d::getPressureCoeffBetweenCells(
             int i, int j, int pi, int pj)
         {
-            // ͬһcell
-            if (i == pi && j == pj) // self
-            {
-                int numSolidNeighbors = (isSolidCell(i + 1, j) +
-                                         isSolidCell(i - 1, j) +
-                                         isSolidCell(i, j + 1) +
-                                         isSolidCell(i, j - 1));
-                // Return number of non-solid boundaries around cel ij
-                return 4.0 - numSolidNeighbors; // ά4
-            }
-            // ھҺΪ壬error
-            if (isNeighbor(i, j, pi, pj) && !isSolidCell(pi, pj))
-                return -1.0;
-            // ھ
-            return 0.0;
+            int c[2] = {i, j};
+            int p[2] = {pi, pj};
+            return Core::getPressureCoeffBetweenCells(c, p);
         }
 
 
@@ -389,17 +413,36 @@ namespace FluidSimulation
         // ȷڽ
         bool MACGrid2d::isValid(int i, int j, MACGrid2d::Direction d)
         {
-            switch (d)
+            if (d != X && d != Y)
             {
-            case X:
-                return (i >= 0 && i < dim[X] + 1 &&
-                        j >= 0 && j < dim[Y]);
-            case Y:
-                return (i >= 0 && i < dim[X] &&
-                        j >= 0 && j < dim[Y] + 1);
+                Glb::Logger::getInstance().addLog("Error: bad direction");
+                return false;
             }
-            Glb::Logger::getInstance().addLog("Error: bad direction");
-            return false;
+            int c[2] = {i, j};
+            return Core::isValid(c, d);
+        }
+
+        void MACGrid2d::setSolid(int i, int j, bool solid)
+        {
+            mSolid.set(i, j, solid ? 1 : 0);
+            mSolid.fillGhost();
+            int c[2] = {i, j};
+            updateCellFlags(c);
+        }
+
+        int MACGrid2d::solidAt(const int *c)
+        {
+            return mSolid.at(c[0], c[1]);
+        }
+
+        double MACGrid2d::faceAt(int axis, const int *c)
+        {
+            return axis == X ? mU.at(c[0], c[1]) : mV.at(c[0], c[1]);
+        }
+
+        void MACGrid2d::cellOf(const glm::vec2 &pt, int *c)
+        {
+            mSolid.getCell(pt, c[0], c[1]);
         }
     }
 }
\ No newline at end of file
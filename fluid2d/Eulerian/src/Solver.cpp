@@ -30,14 +30,102 @@ namespace FluidSimulation
 {
     namespace Eulerian2d
     {
+        // 求解器使用的线程数：Eulerian2dPara::numThreads 为 0 时取 OpenMP 的默认值
+        static int solverThreads()
+        {
+#ifdef _OPENMP
+            return Eulerian2dPara::numThreads > 0 ? Eulerian2dPara::numThreads : omp_get_max_threads();
+#else
+            return 1;
+#endif
+        }
+
         Solver::Solver(MACGrid2d& grid) : mGrid(grid)
         {
             mGrid.reset();
+            resizeBuffers();
+        }
+
+        void Solver::resizeBuffers()
+        {
+            mNextD.dim[0] = mNextT.dim[0] = mGrid.dim[0];
+            mNextD.dim[1] = mNextT.dim[1] = mGrid.dim[1];
+            mNextD.initialize(0.0);
+            mNextT.initialize(Eulerian2dPara::ambientTemp);
+
+            std::size_t faces = (std::max)((mGrid.dim[0] + 1) * mGrid.dim[1], mGrid.dim[0] * (mGrid.dim[1] + 1));
+            mSampleX.resize(faces);
+            mSampleY.resize(faces);
+            mSampleOut.resize(faces);
+            mSampleOutT.resize(faces);
+            mSampleI.resize(faces);
+            mSampleJ.resize(faces);
+            mForwardX.resize(faces);
+            mForwardY.resize(faces);
+            mTilde.resize(faces);
+            mSegmentBegin.resize(mGrid.dim[1] + 1);
+            mSegmentCount.resize(mGrid.dim[1] + 1);
+            mRowMax.resize(mGrid.dim[1] + 1);
+            mRowSum.resize(mGrid.dim[1]);
+            mRowMaxR.resize(mGrid.dim[1]);
+            mRowMaxB.resize(mGrid.dim[1]);
+            mRowCount.resize(mGrid.dim[1]);
+            mRhs.dim[0] = mGrid.dim[0];
+            mRhs.dim[1] = mGrid.dim[1];
+            mRhs.initialize(0.0);
+            mCurl.dim[0] = mGrid.dim[0];
+            mCurl.dim[1] = mGrid.dim[1];
+            mCurl.initialize(0.0);
+            mConfineX.dim[0] = mConfineY.dim[0] = mGrid.dim[0];
+            mConfineX.dim[1] = mConfineY.dim[1] = mGrid.dim[1];
+            mConfineX.initialize(0.0);
+            mConfineY.initialize(0.0);
+            mPressurePrev = mGrid.mP;
+        }
+
+        void Solver::onGridResampled()
+        {
+            resizeBuffers();
+            if (Eulerian2dPara::dt > 0.0f)
+                project(Eulerian2dPara::dt);
         }
 
         void Solver::solve()
         {
-            float dt = Eulerian2dPara::dt;
+            // 开启自适应步长时 Eulerian2dPara::dt 为一帧推进的时间，按 CFL 条件分成若干子步
+            Glb::AdaptiveTimeStep steps(Eulerian2dPara::dt, Eulerian2dPara::adaptiveTimeStep,
+                Eulerian2dPara::cflNumber, Eulerian2dPara::maxSubsteps, mGrid.cellSize);
+            while (!steps.done())
+                substep(steps.next(maxVelocity()));
+            steps.record();
+        }
+
+        double Solver::maxVelocity()
+        {
+            // OpenMP 2.0 没有 max 归约：每行的最大值写入独占的位置，再串行合并
+            const int numX = mGrid.dim[0];
+            const int numY = mGrid.dim[1];
+            std::vector<double>& rowMax = mRowMax;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(solverThreads())
+#endif
+            for (int j = 0; j <= numY; j++) {
+                double m = 0.0;
+                if (j < numY)
+                    for (int i = 0; i <= numX; i++)
+                        m = (std::max)(m, std::fabs(mGrid.mU.at(i, j)));
+                for (int i = 0; i < numX; i++)
+                    m = (std::max)(m, std::fabs(mGrid.mV.at(i, j)));
+                rowMax[j] = m;
+            }
+            double maxVel = 0.0;
+            for (int j = 0; j <= numY; j++)
+                maxVel = (std::max)(maxVel, rowMax[j]);
+            return maxVel;
+        }
+
+        void Solver::substep(float dt)
+        {
             float halfDt = 0.5f * dt;
             //// 第一步: 对流
             //advect(dt);
@@ -48,8 +136,6 @@ namespace FluidSimulation
             //// 第三步: 投影
             //project(dt);
 
-            mGrid.mU_half = mGrid.mU;
-            mGrid.mV_half = mGrid.mV;
             advect(halfDt);
             computeforces(halfDt);
             project(halfDt);
@@ -61,92 +147,336 @@ namespace FluidSimulation
         }
         void Solver::reflectVelocity()
         {
-            int numX = Eulerian2dPara::theDim2d[MACGrid2d::X];
-            int numY = Eulerian2dPara::theDim2d[MACGrid2d::Y];
-
-            // u½reflect = 2*u½ - u½tilde
-            for (int j = 0; j < numY; ++j)
-                for (int i = 1; i < numX; ++i)
-                    mGrid.mU(i, j) = 2.0f * mGrid.mU(i, j) - mGrid.mU_half(i, j);
+            // u½reflect = 2*u½ - u½tilde，只更新容器内部的面
+            // 第一次对流交换后，后缓冲区中保留的正是本步开始时的速度 u½tilde
+            mGrid.mU.masked(mGrid.mFaceMaskU) = 2.0 * mGrid.mU - mGrid.mU_back;
+            mGrid.mV.masked(mGrid.mFaceMaskV) = 2.0 * mGrid.mV - mGrid.mV_back;
 
-            for (int i = 0; i < numX; ++i)
-                for (int j = 1; j < numY; ++j)
-                    mGrid.mV(i, j) = 2.0f * mGrid.mV(i, j) - mGrid.mV_half(i, j);
+            mGrid.fillGhosts();
         }
         void Solver::advect(float dt)
         {
             // 对流步骤更新P
-            // 使用半拉格朗日方法
-            Glb::GridData2dX newU = mGrid.mU;
-            Glb::GridData2dY newV = mGrid.mV;
-            Glb::CubicGridData2d newD = mGrid.mD;
-            Glb::CubicGridData2d newT = mGrid.mT;
+            // 使用半拉格朗日方法，结果写入后缓冲区，最后与当前速度交换
+            Glb::GridData2dX<double>& newU = mGrid.mU_back;
+            Glb::GridData2dY<double>& newV = mGrid.mV_back;
 
             int numX = Eulerian2dPara::theDim2d[MACGrid2d::X];
             int numY = Eulerian2dPara::theDim2d[MACGrid2d::Y];
 
             // 对于速度
+
+            // 0. 容器边界上的面不参与对流，沿用当前值
+            for (int j = 0; j < numY; ++j)
+            {
+                newU.at(0, j) = mGrid.mU.at(0, j);
+                newU.at(numX, j) = mGrid.mU.at(numX, j);
+            }
+            for (int i = 0; i < numX; ++i)
+            {
+                newV.at(i, 0) = mGrid.mV.at(i, 0);
+                newV.at(i, numY) = mGrid.mV.at(i, numY);
+            }
             
+            // 按行并行：每行的回溯终点写入样本数组中该行独占的一段，批量插值后按相同顺序写回
+            // 各点的插值结果与分批方式无关，行之间也互不读写，因此结果与线程数无关
+            const int threads = solverThreads();
+            const int order = Eulerian2dPara::backtraceOrder;
+            const bool corrected = Eulerian2dPara::advectionScheme != Glb::kAdvectSemiLagrangian;
+
             // 1. 更新 U (左-face, i=1..numX-1, j=0..numY-1)
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(threads)
+#endif
             for (int j = 0; j < numY; ++j)
+            {
+                const std::size_t row = (std::size_t)j * (numX + 1);
+                float* xs = mSampleX.data() + row;
+                float* ys = mSampleY.data() + row;
+                double* out = mSampleOut.data() + row;
+                std::size_t n = 0;
                 for (int i = 1; i < numX; ++i)
                 {
                     if (mGrid.isSolidFace(i, j, MACGrid2d::Direction::X))
-                    {
-                        newU(i, j) = 0.0f;          // 或者继续保留原值
                         continue;
-                    }
                     glm::vec2 pos = mGrid.getLeft(i, j);   // 采样位置
-                    glm::vec2 vel = mGrid.semiLagrangian(pos, dt);
-                    newU(i, j) = mGrid.getVelocityX(vel);
+                    glm::vec2 vel = mGrid.backtrace(pos, dt, order);
+                    xs[n] = vel[0];
+                    ys[n] = vel[1];
+                    mSampleI[row + n] = i;
+                    mSampleJ[row + n] = j;
+                    n++;
+                }
+                mSegmentBegin[j] = row;
+                mSegmentCount[j] = n;
+                mGrid.mU.interpolate(xs, ys, out, n);
+                n = 0;
+                for (int i = 1; i < numX; ++i)
+                {
+                    if (mGrid.isSolidFace(i, j, MACGrid2d::Direction::X))
+                        newU.at(i, j) = 0.0f;          // 或者继续保留原值
+                    else
+                        newU.at(i, j) = out[n++];
                 }
+            }
+            // V 的对流会覆盖样本数组，U 的修正须在此之前完成
+            if (corrected) {
+                newU.fillGhost();
+                correctAdvection(mGrid.mU_back, mGrid.mU, numY, [&](int i, int j) { return mGrid.getLeft(i, j); }, dt);
+            }
 
             // 2. 更新 V (下-face, i=0..numX-1, j=1..numY-1)
-            for (int i = 0; i < numX; ++i)
-                for (int j = 1; j < numY; ++j)
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(threads)
+#endif
+            for (int j = 1; j < numY; ++j)
+            {
+                const std::size_t row = (std::size_t)j * numX;
+                float* xs = mSampleX.data() + row;
+                float* ys = mSampleY.data() + row;
+                double* out = mSampleOut.data() + row;
+                std::size_t n = 0;
+                for (int i = 0; i < numX; ++i)
                 {
                     if (mGrid.isSolidFace(i, j, MACGrid2d::Direction::Y))
-                    {
-                        newV(i, j) = 0.0f;
                         continue;
-                    }
                     glm::vec2 pos = mGrid.getBottom(i, j);
-                    glm::vec2 vel = mGrid.semiLagrangian(pos, dt);
-                    newV(i, j) = mGrid.getVelocityY(vel);
+                    glm::vec2 vel = mGrid.backtrace(pos, dt, order);
+                    xs[n] = vel[0];
+                    ys[n] = vel[1];
+                    mSampleI[row + n] = i;
+                    mSampleJ[row + n] = j;
+                    n++;
                 }
-            
+                mSegmentBegin[j] = row;
+                mSegmentCount[j] = n;
+                mGrid.mV.interpolate(xs, ys, out, n);
+                n = 0;
+                for (int i = 0; i < numX; ++i)
+                {
+                    if (mGrid.isSolidFace(i, j, MACGrid2d::Direction::Y))
+                        newV.at(i, j) = 0.0f;
+                    else
+                        newV.at(i, j) = out[n++];
+                }
+            }
+            if (corrected) {
+                mSegmentCount[0] = 0;
+                newV.fillGhost();
+                correctAdvection(mGrid.mV_back, mGrid.mV, numY, [&](int i, int j) { return mGrid.getBottom(i, j); }, dt);
+            }
 
             // 对于属性
-            FOR_EACH_CELL
-            {
-                // 判断是固体或者边界
-                if (mGrid.isSolidCell(i, j)) {
+            advectScalars(dt);
+
+            // 边界条件
+
+            mGrid.swapVelocity();
+            mGrid.fillGhosts();
+        }
+
+        void Solver::advectScalars(float dt)
+        {
+            typedef Glb::SparseGridData<Glb::ScalarStorage, 2> Bricks;
+            const int brickSize = Bricks::kBrickSize;
+            Bricks& nextD = mNextD.sparse();
+            Bricks& nextT = mNextT.sparse();
+            nextD.clear();
+            nextT.clear();
+
+            // 结果只在烟雾所在的块及烟雾源所在的块中计算，密度和温度使用相同的块集合
+            const Bricks& d = mGrid.mD.sparse();
+            const Bricks& t = mGrid.mT.sparse();
+            for (int a = 0; a < d.activeBrickCount(); a++)
+                nextD.activateBrick(d.activeBricks()[a]);
+            for (int a = 0; a < t.activeBrickCount(); a++)
+                nextD.activateBrick(t.activeBricks()[a]);
+            for (std::size_t s = 0; s < Eulerian2dPara::source.size(); s++) {
+                int x = Eulerian2dPara::source[s].position.x;
+                int y = Eulerian2dPara::source[s].position.y;
+                if (x < 0 || y < 0 || x >= mGrid.dim[0] || y >= mGrid.dim[1])
                     continue;
-                }
-                glm::vec2 pos_p = mGrid.getCenter(i, j);
-                glm::vec2 new_vel_p = mGrid.semiLagrangian(pos_p, dt);
-                // glm::vec2 new_vel_p = mGrid.RK2(pos_p, dt);
-                
-                newD(i, j) = mGrid.getDensity(new_vel_p);
-                newT(i, j) = mGrid.getTemperature(new_vel_p);
+                nextD.activateBrick(nextD.brickOf(x, y));
             }
 
-            // 边界条件
+            // 一步内回溯的最大距离（单元数）加上三次插值模板的宽度，换算为需要扩展的块数
+            double maxVel = maxVelocity();
+            int reach = (int)std::ceil(2.0 * maxVel * dt / mGrid.cellSize) + 3;
+            int radius = (reach + brickSize - 1) / brickSize;
+            nextD.dilate(radius);
+            for (int a = 0; a < nextD.activeBrickCount(); a++)
+                nextT.activateBrick(nextD.activeBricks()[a]);
+
+            // 块外的位置回溯到的都是背景值，结果仍为背景值，无需计算
+            // 按块并行：每块的回溯终点写入样本数组中该块独占的一段，对密度、温度各做一次批量三次插值
+            // 块已全部分配，各块只写自己的值，结果与线程数无关
+            const int bricks = nextD.activeBrickCount();
+            const std::size_t samples = (std::size_t)bricks * Bricks::kBrickVolume;
+            if (mSampleX.size() < samples) {
+                mSampleX.resize(samples);
+                mSampleY.resize(samples);
+                mSampleOut.resize(samples);
+                mSampleOutT.resize(samples);
+                mSampleI.resize(samples);
+                mSampleJ.resize(samples);
+                mForwardX.resize(samples);
+                mForwardY.resize(samples);
+                mTilde.resize(samples);
+            }
+            if (mSegmentBegin.size() < (std::size_t)bricks) {
+                mSegmentBegin.resize(bricks);
+                mSegmentCount.resize(bricks);
+            }
+            const int order = Eulerian2dPara::backtraceOrder;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(solverThreads())
+#endif
+            for (int a = 0; a < bricks; a++)
+            {
+                const int b = nextD.activeBricks()[a];
+                const std::size_t offset = (std::size_t)a * Bricks::kBrickVolume;
+                float* xs = mSampleX.data() + offset;
+                float* ys = mSampleY.data() + offset;
+                double* outD = mSampleOut.data() + offset;
+                double* outT = mSampleOutT.data() + offset;
+                std::size_t n = 0;
+                nextD.forEachInBrick(b, [&](const int* c, Glb::ScalarStorage&) {
+                    int i = c[0];
+                    int j = c[1];
+                    // 判断是固体或者边界
+                    if (mGrid.isSolidCell(i, j))
+                        return;
+                    glm::vec2 pos_p = mGrid.getCenter(i, j);
+                    glm::vec2 new_vel_p = mGrid.backtrace(pos_p, dt, order);
+                    xs[n] = new_vel_p[0];
+                    ys[n] = new_vel_p[1];
+                    mSampleI[offset + n] = i;
+                    mSampleJ[offset + n] = j;
+                    n++;
+                });
+                mSegmentBegin[a] = offset;
+                mSegmentCount[a] = n;
+                mGrid.mD.interpolate(xs, ys, outD, n);
+                mGrid.mT.interpolate(xs, ys, outT, n);
+
+                n = 0;
+                nextD.forEachInBrick(b, [&](const int* c, Glb::ScalarStorage& value) {
+                    int i = c[0];
+                    int j = c[1];
+                    if (mGrid.isSolidCell(i, j)) {
+                        value = mGrid.mD.get(i, j);
+                        mNextT.at(i, j) = mGrid.mT.get(i, j);
+                        return;
+                    }
+                    value = outD[n];
+                    mNextT.at(i, j) = outT[n];
+                    n++;
+                });
+            }
+
+            // 修正直接在后缓冲区上进行：未分配的块读出背景值，与回溯到块外的结果一致
+            if (Eulerian2dPara::advectionScheme != Glb::kAdvectSemiLagrangian) {
+                auto center = [&](int i, int j) { return mGrid.getCenter(i, j); };
+                correctAdvection(mNextD, mGrid.mD, bricks, center, dt);
+                correctAdvection(mNextT, mGrid.mT, bricks, center, dt, false);
+            }
 
-            mGrid.mU = newU;
-            mGrid.mV = newV;
-            mGrid.mD = newD;
-            mGrid.mT = newT;
+            mGrid.mD.swap(mNextD);
+            mGrid.mT.swap(mNextT);
+            mGrid.mD.sparse().prune();
+            mGrid.mT.sparse().prune();
+        }
+
+        template <typename Field, typename Position>
+        void Solver::correctAdvection(Field& hat, const Field& phi, int segments, Position position, float dt, bool traceForward)
+        {
+            const int order = Eulerian2dPara::backtraceOrder;
+            const bool bfecc = Eulerian2dPara::advectionScheme == Glb::kAdvectBFECC;
+            const int threads = solverThreads();
+
+            // 1. 从样本位置正向追踪 dt，在半拉格朗日的结果上插值得到 phi~，各段只写自己的一段样本
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(threads)
+#endif
+            for (int s = 0; s < segments; s++) {
+                const std::size_t begin = mSegmentBegin[s];
+                const std::size_t n = mSegmentCount[s];
+                if (traceForward)
+                    for (std::size_t k = begin; k < begin + n; k++) {
+                        glm::vec2 pos = mGrid.backtrace(position(mSampleI[k], mSampleJ[k]), -dt, order);
+                        mForwardX[k] = pos[0];
+                        mForwardY[k] = pos[1];
+                    }
+                hat.interpolate(mForwardX.data() + begin, mForwardY.data() + begin, mTilde.data() + begin, n);
+            }
+
+            // 2. MacCormack：phi^ + (phi - phi~) / 2；BFECC：把 phi + (phi - phi~) / 2 写入 hat，再在回溯终点插值一次
+            //    结果限制在回溯终点周围四个 phi 样本的 [min, max] 内，避免修正项带来新的极值
+            if (bfecc) {
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(threads)
+#endif
+                for (int s = 0; s < segments; s++)
+                    for (std::size_t k = mSegmentBegin[s]; k < mSegmentBegin[s] + mSegmentCount[s]; k++) {
+                        const double p = phi.at(mSampleI[k], mSampleJ[k]);
+                        hat.at(mSampleI[k], mSampleJ[k]) = p + 0.5 * (p - mTilde[k]);
+                    }
+                hat.fillGhost();
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(threads)
+#endif
+                for (int s = 0; s < segments; s++) {
+                    const std::size_t begin = mSegmentBegin[s];
+                    hat.interpolate(mSampleX.data() + begin, mSampleY.data() + begin, mTilde.data() + begin, mSegmentCount[s]);
+                }
+            }
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(threads)
+#endif
+            for (int s = 0; s < segments; s++)
+                for (std::size_t k = mSegmentBegin[s]; k < mSegmentBegin[s] + mSegmentCount[s]; k++) {
+                    const int i = mSampleI[k];
+                    const int j = mSampleJ[k];
+                    const double value = bfecc ? mTilde[k] : (double)hat.at(i, j) + 0.5 * ((double)phi.at(i, j) - mTilde[k]);
+
+                    glm::vec2 back = phi.worldToSelf(glm::vec2(mSampleX[k], mSampleY[k]));
+                    const int bi = (int)(back[0] / phi.cellSize);
+                    const int bj = (int)(back[1] / phi.cellSize);
+                    double lo = phi.at(bi, bj);
+                    double hi = lo;
+                    for (int dj = 0; dj < 2; dj++)
+                        for (int di = 0; di < 2; di++) {
+                            const double p = phi.at(bi + di, bj + dj);
+                            lo = (std::min)(lo, p);
+                            hi = (std::max)(hi, p);
+                        }
+                    hat.at(i, j) = (std::max)(lo, (std::min)(hi, value));
+                }
         }
 
         void Solver::computeforces(float dt)
         {
             int numX = mGrid.dim[0];
             int numY = mGrid.dim[1];
-            // 浮力
-            Glb::GridData2dY newV = mGrid.mV;
-            FOR_EACH_CELL
+            // 浮力只依赖密度和温度，涡量约束力只依赖事先算好的涡量，都直接在 u、v 上原地累加
+            Glb::GridData2dX<double>& newU = mGrid.mU;
+            Glb::GridData2dY<double>& newV = mGrid.mV;
+
+            // 涡量约束力事先算在单元中心，面上的力取两侧单元的平均
+            const bool confine = Eulerian2dPara::vorticityConst > 0.0;
+            if (confine)
+                computeConfinement();
+
+            // 每个面只读密度、温度和约束力，写自己所在的 u、v，按行并行
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(solverThreads())
+#endif
+            for (int j = 0; j < Eulerian2dPara::theDim2d[MACGrid2d::Y]; j++)
+                for (int i = 0; i < Eulerian2dPara::theDim2d[MACGrid2d::X]; i++)
             {
+                if (confine && i > 0 && !mGrid.isSolidFace(i, j, MACGrid2d::Direction::X))
+                    newU.at(i, j) += (mConfineX.at(i - 1, j) + mConfineX.at(i, j)) * 0.5 * dt;
+
                 if (mGrid.isSolidCell(i, j) || mGrid.isSolidCell(i, j - 1) || mGrid.isSolidCell(i, j + 1)) {
                     continue;
                 }
@@ -158,62 +488,463 @@ namespace FluidSimulation
                 float bforce0 = mGrid.getBoussinesqForce(pos0);
 
                 float v = (bforce1 + bforce0) * 0.5 * dt;
+                if (confine)
+                    v += (mConfineY.at(i, j - 1) + mConfineY.at(i, j)) * 0.5 * dt;
                 // 更新 v 分量
-                newV(i, j) += v;
+                newV.at(i, j) += v;
             }
 
-            mGrid.mV = newV;
+            if (confine)
+                mGrid.mU.fillGhost();
+            mGrid.mV.fillGhost();
+        }
+
+        void Solver::computeConfinement()
+        {
+            const int numX = mGrid.dim[0];
+            const int numY = mGrid.dim[1];
+            const double epsilon = Eulerian2dPara::vorticityConst;
+            computeCurl();
+
+            // N = grad|omega| / |grad|omega||，单元中心的力 f = epsilon * h * (N x omega) = epsilon * h * omega * (Ny, -Nx)
+            // 边界处退化为单侧差分；固体单元的涡量为 0，力也为 0
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(solverThreads())
+#endif
+            for (int j = 0; j < numY; j++)
+                for (int i = 0; i < numX; i++) {
+                    const int il = (std::max)(i - 1, 0), ir = (std::min)(i + 1, numX - 1);
+                    const int jl = (std::max)(j - 1, 0), jr = (std::min)(j + 1, numY - 1);
+                    const double gx = (std::fabs(mCurl.at(ir, j)) - std::fabs(mCurl.at(il, j))) / (ir - il);
+                    const double gy = (std::fabs(mCurl.at(i, jr)) - std::fabs(mCurl.at(i, jl))) / (jr - jl);
+                    const double scale = epsilon * mGrid.cellSize * mCurl.at(i, j) / (std::sqrt(gx * gx + gy * gy) + 1e-20);
+                    mConfineX.at(i, j) = gy * scale;
+                    mConfineY.at(i, j) = -gx * scale;
+                }
+        }
 
+        void Solver::computeCurl()
+        {
+            const int numX = mGrid.dim[0];
+            const int numY = mGrid.dim[1];
+            // 单元中心的速度取两侧面的平均，中心差分在边界处退化为单侧差分；固体单元的涡量为 0
+            auto centerU = [&](int i, int j) { return 0.5 * (mGrid.mU.at(i, j) + mGrid.mU.at(i + 1, j)); };
+            auto centerV = [&](int i, int j) { return 0.5 * (mGrid.mV.at(i, j) + mGrid.mV.at(i, j + 1)); };
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(solverThreads())
+#endif
+            for (int j = 0; j < numY; j++)
+                for (int i = 0; i < numX; i++) {
+                    if (mGrid.isSolidCell(i, j)) {
+                        mCurl.at(i, j) = 0.0;
+                        continue;
+                    }
+                    const int il = (std::max)(i - 1, 0), ir = (std::min)(i + 1, numX - 1);
+                    const int jl = (std::max)(j - 1, 0), jr = (std::min)(j + 1, numY - 1);
+                    const double dvdx = (centerV(ir, j) - centerV(il, j)) / ((ir - il) * mGrid.cellSize);
+                    const double dudy = (centerU(i, jr) - centerU(i, jl)) / ((jr - jl) * mGrid.cellSize);
+                    mCurl.at(i, j) = dvdx - dudy;
+                }
         }
 
-        void Solver::project(float dt)
+        // 单元 (i, j) 的一次 Jacobi 更新：(b + 非固体邻居压力之和) / 非固体邻居数
+        // 邻居是否为固体、对角系数（非固体邻居个数）都取自单元标记，固体单元不更新
+        template <typename Field>
+        static inline double jacobiUpdate(const Field& p, const Glb::GridData2d<double>& rhs, int i, int j, std::uint16_t flags)
         {
-            int numX = mGrid.dim[0];
-            int numY = mGrid.dim[1];
-            Glb::CubicGridData2d newP = mGrid.mP;
-            newP.initialize(0.0);
-            Glb::GridData2dY newV = mGrid.mV;
-            Glb::GridData2dX newU = mGrid.mU;
+            double px1 = (flags & MACGrid2d::neighborBit(MACGrid2d::X, 1)) ? 0.0 : p.at(i + 1, j);
+            double px0 = (flags & MACGrid2d::neighborBit(MACGrid2d::X, -1)) ? 0.0 : p.at(i - 1, j);
+            double py1 = (flags & MACGrid2d::neighborBit(MACGrid2d::Y, 1)) ? 0.0 : p.at(i, j + 1);
+            double py0 = (flags & MACGrid2d::neighborBit(MACGrid2d::Y, -1)) ? 0.0 : p.at(i, j - 1);
+            double s = 4.0 - MACGrid2d::solidNeighborCount(flags);
+            return (rhs.at(i, j) + px1 + px0 + py1 + py0) / s;
+        }
 
-            float aird = Eulerian2dPara::airDensity;
+        // 从第 done 次迭代起到下一次检查残差（或迭代上限）之间的迭代次数，这些迭代可以放在一起做时间分块
+        static int iterationsToCheck(int done, int iterations, double tolerance)
+        {
+            const int interval = Eulerian2dPara::residualInterval;
+            int count = iterations - done;
+            if (tolerance > 0.0 && interval > 0)
+                count = (std::min)(count, interval - done % interval);
+            return count;
+        }
 
-            float cellSize = mGrid.cellSize;
+        // 时间分块的行块行数：每行涉及压力、右端项（double）和单元标记，Chebyshev 另有一个压力缓冲区
+        static int blockRows(int numX, int pressureArrays)
+        {
+            return Glb::TemporalBlocking::blockRows((std::size_t)numX * (sizeof(double) * (pressureArrays + 1) + sizeof(std::uint16_t)));
+        }
 
-            for (int iteration = 100; iteration > 0; iteration--) {
-                FOR_EACH_CELL{
-                    if (mGrid.isSolidCell(i, j)) {
-                        continue;
+        int Solver::relaxGaussSeidel(int iterations, double tolerance)
+        {
+            // 字典序原地更新，后面的单元使用本轮已更新的值，只能串行；时间分块用斜向波前，更新次序的依赖关系不变
+            Glb::CubicGridData2d<double>& newP = mGrid.mP;
+            const int numX = mGrid.dim[0];
+            const int numY = mGrid.dim[1];
+            const int band = blockRows(numX, 1);
+            const std::uint16_t solidBit = MACGrid2d::kCellSolid;
+            const std::uint16_t xp = MACGrid2d::neighborBit(MACGrid2d::X, 1);
+            const std::uint16_t xm = MACGrid2d::neighborBit(MACGrid2d::X, -1);
+            const std::uint16_t yp = MACGrid2d::neighborBit(MACGrid2d::Y, 1);
+            const std::uint16_t ym = MACGrid2d::neighborBit(MACGrid2d::Y, -1);
+
+            auto sweepRows = [&](int, int j0, int j1) {
+                for (int j = j0; j < j1; j++)
+                    for (int i = 0; i < numX; i++) {
+                        int c[2] = {i, j};
+                        std::uint16_t flags = mGrid.cellFlags(c);
+                        if (flags & solidBit) {
+                            continue;
+                        }
+                        /*
+                        if (mGrid.isSolidCell(i - 1, j)) {
+                            newP(i - 1, j) = newP(i, j) - cellSize * aird * newU(i + 1, j) / dt;
+                        }
+                        if (mGrid.isSolidCell(i, j - 1)) {
+                            newP(i, j - 1) = newP(i, j) - cellSize * aird * newV(i, j + 1) / dt;
+                        }
+                        */ 
+                        double px1 = (flags & xp) ? 0.0 : newP.at(i + 1, j);
+                        double px0 = (flags & xm) ? 0.0 : newP.at(i - 1, j);
+
+                        double py1 = (flags & yp) ? 0.0 : newP.at(i, j + 1);
+                        double py0 = (flags & ym) ? 0.0 : newP.at(i, j - 1);
+
+                        // b
+                        // double b = -1 * (newU(i + 1, j) - newU(i, j) + newV(i, j + 1) - newV(i, j)) * (aird) * cellSize / (dt);
+                        double b = mRhs.at(i, j);
+                        // sum
+                        double sum = (px1 + px0 + py1 + py0);
+                        double s = 4.0 - MACGrid2d::solidNeighborCount(flags);
+                        newP.at(i, j) = (b + sum) / s;
                     }
-                    /*
-                    if (mGrid.isSolidCell(i - 1, j)) {
-                        newP(i - 1, j) = newP(i, j) - cellSize * aird * newU(i + 1, j) / dt;
+            };
+
+            int done = 0;
+            while (done < iterations) {
+                const int count = iterationsToCheck(done, iterations, tolerance);
+                Glb::TemporalBlocking::skewed(numY, count, Eulerian2dPara::temporalBlocking, band, sweepRows);
+                done += count;
+                if (pressureConverged(done, tolerance))
+                    break;
+            }
+            return done;
+        }
+
+        int Solver::relaxRedBlackSOR(int iterations, double omega, double tolerance)
+        {
+            // (i + j) 为偶数的红色单元只与黑色单元相邻，反之亦然：先更新全部红色单元，再更新黑色单元
+            // 每个单元的新值只依赖另一种颜色，结果与线程数无关；时间分块以半次迭代（一种颜色）为一次遍历
+            Glb::CubicGridData2d<double>& p = mGrid.mP;
+            const int numX = mGrid.dim[0];
+            const int numY = mGrid.dim[1];
+            const double w = Glb::sorRelaxation(omega, Glb::jacobiSpectralRadius(mGrid.dim, 2));
+            const int threads = solverThreads();
+            const int band = blockRows(numX, 1);
+
+            auto sweepRows = [&](int half, int j0, int j1) {
+                const int color = half & 1;
+                for (int j = j0; j < j1; j++)
+                    for (int i = (j + color) & 1; i < numX; i += 2) {
+                        int c[2] = { i, j };
+                        std::uint16_t flags = mGrid.cellFlags(c);
+                        if (flags & MACGrid2d::kCellSolid)
+                            continue;
+                        double& pc = p.at(i, j);
+                        pc += w * (jacobiUpdate(p, mRhs, i, j, flags) - pc);
                     }
-                    if (mGrid.isSolidCell(i, j - 1)) {
-                        newP(i, j - 1) = newP(i, j) - cellSize * aird * newV(i, j + 1) / dt;
+            };
+
+            int done = 0;
+            while (done < iterations) {
+                const int count = iterationsToCheck(done, iterations, tolerance);
+                Glb::TemporalBlocking::tiled(numY, 2 * count, 2 * Eulerian2dPara::temporalBlocking, band, threads, sweepRows);
+                done += count;
+                if (pressureConverged(done, tolerance))
+                    break;
+            }
+            return done;
+        }
+
+        int Solver::relaxChebyshevJacobi(int iterations, double tolerance)
+        {
+            // 新值写入保存上一次解的缓冲区：x(k+1) = omega * J x(k) + (1 - omega) * x(k-1)，两个缓冲区轮流读写
+            // 一段迭代结束后最新的解若在 mPressurePrev 中，再与 mGrid.mP 交换
+            const int numX = mGrid.dim[0];
+            const int numY = mGrid.dim[1];
+            Glb::ChebyshevSchedule schedule(Glb::jacobiSpectralRadius(mGrid.dim, 2));
+            const int threads = solverThreads();
+            const int band = blockRows(numX, 2);
+            mPressurePrev.data().fill(0.0);
+            // 实测以上一步的压力为初值时各步残差反而比从 0 开始大数倍，Chebyshev 总是从 0 开始
+            mGrid.mP.data().fill(0.0);
+
+            Glb::CubicGridData2d<double>* buffers[2] = { &mGrid.mP, &mPressurePrev };
+            std::vector<double>& weights = mChebyshevWeights;
+            auto sweepRows = [&](int s, int j0, int j1) {
+                const double w = weights[s];
+                const Glb::CubicGridData2d<double>& p = *buffers[s & 1];
+                Glb::CubicGridData2d<double>& next = *buffers[(s & 1) ^ 1];
+                for (int j = j0; j < j1; j++)
+                    for (int i = 0; i < numX; i++) {
+                        int c[2] = { i, j };
+                        std::uint16_t flags = mGrid.cellFlags(c);
+                        if (flags & MACGrid2d::kCellSolid) {
+                            next.at(i, j) = p.at(i, j);
+                            continue;
+                        }
+                        next.at(i, j) = w * jacobiUpdate(p, mRhs, i, j, flags) + (1.0 - w) * next.at(i, j);
                     }
-                    */ 
-                    double px1 = mGrid.isSolidCell(i + 1, j) ? 0.0 : newP(i + 1, j);
-                    double px0 = mGrid.isSolidCell(i - 1, j) ? 0.0 : newP(i - 1, j);
+            };
+
+            int done = 0;
+            while (done < iterations) {
+                const int count = iterationsToCheck(done, iterations, tolerance);
+                weights.resize(count);
+                for (int s = 0; s < count; s++)
+                    weights[s] = schedule.next();
+                Glb::TemporalBlocking::tiled(numY, count, Eulerian2dPara::temporalBlocking, band, threads, sweepRows);
+                if (count & 1)
+                    mGrid.mP.swap(mPressurePrev);
+                done += count;
+                if (pressureConverged(done, tolerance))
+                    break;
+            }
+            return done;
+        }
 
-                    double py1 = mGrid.isSolidCell(i, j + 1) ? 0.0 : newP(i, j + 1);
-                    double py0 = mGrid.isSolidCell(i, j - 1) ? 0.0 : newP(i, j - 1);
-                    
+        double Solver::pressureResidual()
+        {
+            const int numX = mGrid.dim[0];
+            const int numY = mGrid.dim[1];
+            const Glb::CubicGridData2d<double>& p = mGrid.mP;
+            const int threads = solverThreads();
+            // 按行求部分和与部分最大值，再按顺序合并，结果与线程数无关
+            std::vector<double>& rowSum = mRowSum;
+            std::vector<double>& rowMaxR = mRowMaxR;
+            std::vector<double>& rowMaxB = mRowMaxB;
+            std::vector<int>& rowCount = mRowCount;
+            std::fill(rowSum.begin(), rowSum.end(), 0.0);
+            std::fill(rowMaxR.begin(), rowMaxR.end(), 0.0);
+            std::fill(rowMaxB.begin(), rowMaxB.end(), 0.0);
+            std::fill(rowCount.begin(), rowCount.end(), 0);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(threads)
+#endif
+            for (int j = 0; j < numY; j++)
+                for (int i = 0; i < numX; i++) {
+                    int c[2] = { i, j };
+                    std::uint16_t flags = mGrid.cellFlags(c);
+                    if ((flags & MACGrid2d::kCellSolid) || MACGrid2d::solidNeighborCount(flags) == 4)
+                        continue;
+                    rowSum[j] += mRhs.at(i, j);
+                    rowCount[j]++;
+                }
+            double sum = 0.0;
+            int count = 0;
+            for (int j = 0; j < numY; j++) {
+                sum += rowSum[j];
+                count += rowCount[j];
+            }
+            const double mean = count > 0 ? sum / count : 0.0;
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(threads)
+#endif
+            for (int j = 0; j < numY; j++)
+                for (int i = 0; i < numX; i++) {
+                    int c[2] = { i, j };
+                    std::uint16_t flags = mGrid.cellFlags(c);
+                    if ((flags & MACGrid2d::kCellSolid) || MACGrid2d::solidNeighborCount(flags) == 4)
+                        continue;
+                    // b + sum(p_nb) - s * p = s * (jacobiUpdate - p)
+                    const double s = 4.0 - MACGrid2d::solidNeighborCount(flags);
+                    const double r = s * (jacobiUpdate(p, mRhs, i, j, flags) - p.at(i, j)) - mean;
+                    rowMaxR[j] = (std::max)(rowMaxR[j], std::fabs(r));
+                    rowMaxB[j] = (std::max)(rowMaxB[j], std::fabs(mRhs.at(i, j) - mean));
+                }
+            double maxR = 0.0, maxB = 0.0;
+            for (int j = 0; j < numY; j++) {
+                maxR = (std::max)(maxR, rowMaxR[j]);
+                maxB = (std::max)(maxB, rowMaxB[j]);
+            }
+            return maxB > 0.0 ? maxR / maxB : 0.0;
+        }
 
-                    double div = mGrid.getDivergence(i, j);
+        bool Solver::pressureConverged(int iteration, double tolerance)
+        {
+            const int interval = Eulerian2dPara::residualInterval;
+            if (tolerance <= 0.0 || interval <= 0 || iteration % interval != 0)
+                return false;
+            return pressureResidual() <= tolerance;
+        }
 
-                    // b
-                    // double b = -1 * (newU(i + 1, j) - newU(i, j) + newV(i, j + 1) - newV(i, j)) * (aird) * cellSize / (dt);
-                    double b = -1 * (div) * (aird) * cellSize * cellSize / (dt);
-                    // sum
-                    double sum = (px1 + px0 + py1 + py0);
-                    double s = mGrid.getPressureCoeffBetweenCells(i, j, i, j);
-                    newP(i, j) = (b + sum) / s;
-                };
+        int Solver::solvePCG(int maxIterations, double tolerance, Preconditioner precon)
+        {
+            // 固体可能由 setSolid 修改，预条件子每次按当前标记重建，代价与一次迭代相当
+            mPCG.build(mGrid, solverThreads());
+            switch (precon) {
+            case kPreconMultigrid:
+                mMultigrid.build(mGrid, solverThreads());
+                mPCG.setPreconditioner([this](const std::vector<double>& r, std::vector<double>& z) {
+                    mMultigrid.precondition(r, z);
+                });
+                break;
+            case kPreconDCT:
+                mPCG.setPreconditioner([this](const std::vector<double>& r, std::vector<double>& z) {
+                    mDCT.precondition(r, z);
+                });
+                break;
+            default:
+                mPCG.setPreconditioner(Glb::PressurePCG<2>::Preconditioner());
+                break;
             }
+            std::vector<double>& rhs = mPCG.rhs();
+            std::vector<double>& p = mPCG.pressure();
+            for (int j = 0; j < mGrid.dim[1]; j++)
+                for (int i = 0; i < mGrid.dim[0]; i++) {
+                    int c[2] = { i, j };
+                    int n = mPCG.index(c);
+                    rhs[n] = mRhs.at(i, j);
+                    p[n] = mGrid.mP.at(i, j);
+                }
+            const int iterations = mPCG.solve(tolerance, maxIterations);
+            for (int j = 0; j < mGrid.dim[1]; j++)
+                for (int i = 0; i < mGrid.dim[0]; i++) {
+                    int c[2] = { i, j };
+                    mGrid.mP.at(i, j) = p[mPCG.index(c)];
+                }
+            return iterations;
+        }
+
+        int Solver::solveMultigrid(int maxCycles, double tolerance)
+        {
+            mMultigrid.build(mGrid, solverThreads());
+            std::vector<double>& rhs = mMultigrid.rhs();
+            std::vector<double>& p = mMultigrid.pressure();
+            for (int j = 0; j < mGrid.dim[1]; j++)
+                for (int i = 0; i < mGrid.dim[0]; i++) {
+                    int c[2] = { i, j };
+                    int n = mMultigrid.index(c);
+                    rhs[n] = mRhs.at(i, j);
+                    p[n] = mGrid.mP.at(i, j);
+                }
+            const int cycles = mMultigrid.solve(tolerance, maxCycles, Eulerian2dPara::multigridCycle == 1);
+            for (int j = 0; j < mGrid.dim[1]; j++)
+                for (int i = 0; i < mGrid.dim[0]; i++) {
+                    int c[2] = { i, j };
+                    mGrid.mP.at(i, j) = p[mMultigrid.index(c)];
+                }
+            return cycles;
+        }
+
+        void Solver::solveDCT()
+        {
+            std::vector<double>& rhs = mDCT.rhs();
+            std::vector<double>& p = mDCT.pressure();
+            for (int j = 0; j < mGrid.dim[1]; j++)
+                for (int i = 0; i < mGrid.dim[0]; i++) {
+                    int c[2] = { i, j };
+                    rhs[mDCT.index(c)] = mRhs.at(i, j);
+                }
+            mDCT.solve();
+            for (int j = 0; j < mGrid.dim[1]; j++)
+                for (int i = 0; i < mGrid.dim[0]; i++) {
+                    int c[2] = { i, j };
+                    mGrid.mP.at(i, j) = p[mDCT.index(c)];
+                }
+        }
+
+        void Solver::project(float dt)
+        {
+            // 压力迭代只读取速度，梯度修正在迭代结束后进行，因此都可以原地更新
+            // 相邻两步的压力相差不大，默认以上一步的压力为初值
+            Glb::CubicGridData2d<double>& newP = mGrid.mP;
+            if (!Eulerian2dPara::warmStart)
+                newP.data().fill(0.0);
+            Glb::GridData2dY<double>& newV = mGrid.mV;
+            Glb::GridData2dX<double>& newU = mGrid.mU;
+
+            float aird = Eulerian2dPara::airDensity;
+
+            float cellSize = mGrid.cellSize;
+
+            // 迭代过程中速度不变，右端项只需计算一次
+            FOR_EACH_CELL{
+                if (mGrid.isSolidCell(i, j))
+                    continue;
+                double div = mGrid.getDivergence(i, j);
+                mRhs.at(i, j) = -1 * (div) * (aird) * cellSize * cellSize / (dt);
+            }
+
+            const int iterations = (std::max)(Eulerian2dPara::pressureIterations, 0);
+            const double tolerance = Eulerian2dPara::pressureTolerance;
+            // 没有固体时 DCT 直接给出精确解；固体很少时 DCT 代替 MIC(0) 作为 PCG 的预条件子
+            bool boxDomain = false;
+            if (Eulerian2dPara::fastPoisson) {
+                mDCT.build(mGrid, solverThreads());
+                boxDomain = mDCT.solidFraction() <= Eulerian2dPara::dctSolidFraction;
+            }
+            int done = 0;
+            std::string method;
+            if (boxDomain && mDCT.solidCells() == 0) {
+                solveDCT();
+                method = "DCT";
+            }
+            else {
+                switch (Eulerian2dPara::pressureSolver) {
+                case Glb::kPressureRedBlackSOR:
+                    done = relaxRedBlackSOR(iterations, Eulerian2dPara::sorOmega, tolerance);
+                    method = "Red-Black SOR";
+                    break;
+                case Glb::kPressureChebyshevJacobi:
+                    done = relaxChebyshevJacobi(iterations, tolerance);
+                    method = "Chebyshev Jacobi";
+                    break;
+                case Glb::kPressurePCG:
+                    done = solvePCG(iterations, tolerance, boxDomain ? kPreconDCT : kPreconMIC);
+                    method = boxDomain ? "DCT-PCG" : "MIC(0)-PCG";
+                    break;
+                case Glb::kPressureMultigrid:
+                    done = solveMultigrid(iterations, tolerance);
+                    method = "Multigrid";
+                    break;
+                case Glb::kPressureMGPCG:
+                    done = solvePCG(iterations, tolerance, kPreconMultigrid);
+                    method = "Multigrid-PCG";
+                    break;
+                default:
+                    done = relaxGaussSeidel(iterations, tolerance);
+                    method = "Gauss-Seidel";
+                    break;
+                }
+            }
+
+            // 纯 Neumann 问题的压力只确定到一个常数，去掉均值，热启动时常数分量不会逐步漂移
+            if (Eulerian2dPara::warmStart) {
+                double sum = 0.0;
+                int count = 0;
+                FOR_EACH_CELL{
+                    if (!mGrid.isSolidCell(i, j)) {
+                        sum += newP(i, j);
+                        count++;
+                    }
+                }
+                const double mean = count > 0 ? sum / count : 0.0;
+                FOR_EACH_CELL{
+                    if (!mGrid.isSolidCell(i, j))
+                        newP.at(i, j) -= mean;
+                }
+            }
+
+            Glb::Timer::getInstance().recordValue("Pressure solver", method);
+            Glb::Timer::getInstance().recordValue("Pressure iterations", done);
+            Glb::Timer::getInstance().recordValue("Pressure residual", pressureResidual());
            
             FOR_EACH_CELL{
-                newU(i + 1,j) -= dt * (newP(i + 1,j) - newP(i,j)) / (cellSize * aird);
-                newV(i, j + 1) -= dt * (newP(i, j + 1) - newP(i, j)) / (cellSize * aird);
+                newU.at(i + 1, j) -= dt * (newP(i + 1,j) - newP(i,j)) / (cellSize * aird);
+                newV.at(i, j + 1) -= dt * (newP(i, j + 1) - newP(i, j)) / (cellSize * aird);
             }
 
             // 边界处理
@@ -221,17 +952,15 @@ namespace FluidSimulation
             {
                 // 对U
                 if (mGrid.isSolidFace(i, j, MACGrid2d::Direction::X)) {
-                    newU(i, j) = 0;
+                    newU.set(i, j, 0);
                 }
                 // 对V
                 if (mGrid.isSolidFace(i, j, MACGrid2d::Direction::Y)) {
-                    newV(i, j) = 0;
+                    newV.set(i, j, 0);
                 }
             }
             
-            mGrid.mU = newU;
-            mGrid.mV = newV;
-            mGrid.mP = newP;
+            mGrid.fillGhosts();
 
 
         }
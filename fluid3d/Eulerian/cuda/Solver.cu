@@ -1,6 +1,8 @@
 #include <cuda_runtime.h>
 #include <device_launch_parameters.h>
 #include <math_functions.h>
+#include <cuda_fp16.h>
+#include <cstring>
 
 // =========================================================
 // ѧ
@@ -9,6 +11,42 @@ inline __host__ __device__ float3 operator+(float3 a, float3 b) { return make_fl
 inline __host__ __device__ float3 operator-(float3 a, float3 b) { return make_float3(a.x - b.x, a.y - b.y, a.z - b.z); }
 inline __host__ __device__ float3 operator*(float3 a, float s)  { return make_float3(a.x * s, a.y * s, a.z * s); }
 inline __host__ __device__ float3 operator*(float s, float3 a)  { return make_float3(a.x * s, a.y * s, a.z * s); }
+inline __host__ __device__ float  length(float3 a)          { return sqrtf(a.x * a.x + a.y * a.y + a.z * a.z); }
+inline __host__ __device__ float3 cross(float3 a, float3 b)     { return make_float3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x); }
+
+// =========================================================
+// ĶдFLUID_HALF_SCALARS ʱΪ R16Fsurface  16 λд
+//  tex3D<float> ԰뾫ԶתΪ float
+// =========================================================
+#ifdef FLUID_HALF_SCALARS
+typedef unsigned short ScalarTexel;
+
+__device__ inline float readScalar(cudaSurfaceObject_t surf, int x, int y, int z)
+{
+    ScalarTexel v;
+    surf3Dread(&v, surf, x * sizeof(ScalarTexel), y, z);
+    return __half2float(__ushort_as_half(v));
+}
+
+__device__ inline void writeScalar(float v, cudaSurfaceObject_t surf, int x, int y, int z)
+{
+    surf3Dwrite(__half_as_ushort(__float2half(v)), surf, x * sizeof(ScalarTexel), y, z);
+}
+#else
+typedef float ScalarTexel;
+
+__device__ inline float readScalar(cudaSurfaceObject_t surf, int x, int y, int z)
+{
+    float v;
+    surf3Dread(&v, surf, x * sizeof(ScalarTexel), y, z);
+    return v;
+}
+
+__device__ inline void writeScalar(float v, cudaSurfaceObject_t surf, int x, int y, int z)
+{
+    surf3Dwrite(v, surf, x * sizeof(ScalarTexel), y, z);
+}
+#endif
 
 // =========================================================
 // helper functionٶȳԲֵ
@@ -77,7 +115,7 @@ __global__ void advect_density_kernel(
     // д
     float result = tex3D<float>(inputTex, prevPos.x, prevPos.y, prevPos.z);
     result = fmaxf(0.0f, result);
-    surf3Dwrite(result, outputSurf, x * sizeof(float), y, z);
+    writeScalar(result, outputSurf, x, y, z);
 }
 
 // BFECC ƽ (Back and Forth Error Compensation and Correction)
@@ -114,7 +152,7 @@ __global__ void advect_density_BFECC_kernel(
     // 4. Sample & Write
     float result = tex3D<float>(inputTex, pos_final.x, pos_final.y, pos_final.z);
     result = fmaxf(0.0f, result);
-    surf3Dwrite(result, outputSurf, x * sizeof(float), y, z);
+    writeScalar(result, outputSurf, x, y, z);
 }
 
 __global__ void advect_velocity_kernel(
@@ -165,6 +203,66 @@ __global__ void apply_buoyancy_kernel(
     }
 }
 
+// Force: Vorticity Confinement AĲ omega = curl(u)λ
+__global__ void compute_vorticity_kernel(
+    float3* vorticity, float3* velocity,
+    int width, int height, int depth)
+{
+    int x = blockIdx.x * blockDim.x + threadIdx.x;
+    int y = blockIdx.y * blockDim.y + threadIdx.y;
+    int z = blockIdx.z * blockDim.z + threadIdx.z;
+    if (x >= width || y >= height || z >= depth) return;
+
+    int idx = x + y * width + z * width * height;
+
+    // ߽紦˻Ϊ
+    int xl = max(x - 1, 0); int xr = min(x + 1, width - 1);
+    int yl = max(y - 1, 0); int yr = min(y + 1, height - 1);
+    int zl = max(z - 1, 0); int zr = min(z + 1, depth - 1);
+    float rx = 1.0f / max(xr - xl, 1);
+    float ry = 1.0f / max(yr - yl, 1);
+    float rz = 1.0f / max(zr - zl, 1);
+
+    float3 v_xr = velocity[xr + y * width + z * width * height];
+    float3 v_xl = velocity[xl + y * width + z * width * height];
+    float3 v_yr = velocity[x + yr * width + z * width * height];
+    float3 v_yl = velocity[x + yl * width + z * width * height];
+    float3 v_zr = velocity[x + y * width + zr * width * height];
+    float3 v_zl = velocity[x + y * width + zl * width * height];
+
+    vorticity[idx] = make_float3(
+        (v_yr.z - v_yl.z) * ry - (v_zr.y - v_zl.y) * rz,
+        (v_zr.x - v_zl.x) * rz - (v_xr.z - v_xl.z) * rx,
+        (v_xr.y - v_xl.y) * rx - (v_yr.x - v_yl.x) * ry);
+}
+
+// Force: Vorticity Confinement Bf = epsilon * (N x omega)N = grad|omega| / |grad|omega||
+__global__ void apply_vorticity_confinement_kernel(
+    float3* velocity, float3* vorticity, float epsilon, float dt,
+    int width, int height, int depth)
+{
+    int x = blockIdx.x * blockDim.x + threadIdx.x;
+    int y = blockIdx.y * blockDim.y + threadIdx.y;
+    int z = blockIdx.z * blockDim.z + threadIdx.z;
+    if (x >= width || y >= height || z >= depth) return;
+
+    int idx = x + y * width + z * width * height;
+
+    int xl = max(x - 1, 0); int xr = min(x + 1, width - 1);
+    int yl = max(y - 1, 0); int yr = min(y + 1, height - 1);
+    int zl = max(z - 1, 0); int zr = min(z + 1, depth - 1);
+
+    float3 grad = make_float3(
+        (length(vorticity[xr + y * width + z * width * height]) - length(vorticity[xl + y * width + z * width * height])) / max(xr - xl, 1),
+        (length(vorticity[x + yr * width + z * width * height]) - length(vorticity[x + yl * width + z * width * height])) / max(yr - yl, 1),
+        (length(vorticity[x + y * width + zr * width * height]) - length(vorticity[x + y * width + zl * width * height])) / max(zr - zl, 1));
+    float norm = length(grad);
+    if (norm < 1e-6f) return;
+
+    float3 f = cross(grad * (1.0f / norm), vorticity[idx]);
+    velocity[idx] = velocity[idx] + f * (epsilon * dt);
+}
+
 // Project A: Compute Divergence
 __global__ void compute_divergence_kernel(
     float* divergence, float3* velocity,
@@ -223,6 +321,49 @@ __global__ void jacobi_pressure_kernel(
     p_next[idx] = (pl + pr + pd + pu + pb + pf - div) / 6.0f;
 }
 
+// Project B': ѹ̵Ĳв
+// вɢȵֵǸ float λģʽֵСһ£ڹԼ޷ atomicMax ϲ
+__device__ unsigned int d_maxResidualBits;
+__device__ unsigned int d_maxDivergenceBits;
+
+__global__ void pressure_residual_kernel(
+    float* p, float* divergence,
+    int width, int height, int depth)
+{
+    __shared__ float sResidual[512];
+    __shared__ float sDivergence[512];
+
+    int x = blockIdx.x * blockDim.x + threadIdx.x;
+    int y = blockIdx.y * blockDim.y + threadIdx.y;
+    int z = blockIdx.z * blockDim.z + threadIdx.z;
+    int tid = threadIdx.x + (threadIdx.y + threadIdx.z * blockDim.y) * blockDim.x;
+
+    //  jacobi_pressure_kernel ֻͬͳڲԪ̶߳ҪԼǰ
+    float r = 0.0f, b = 0.0f;
+    if (x >= 1 && x < width - 1 && y >= 1 && y < height - 1 && z >= 1 && z < depth - 1) {
+        int idx = x + y * width + z * width * height;
+        float sum = p[idx - 1] + p[idx + 1] + p[idx - width] + p[idx + width]
+            + p[idx - width * height] + p[idx + width * height];
+        b = fabsf(divergence[idx]);
+        r = fabsf(sum - divergence[idx] - 6.0f * p[idx]);
+    }
+    sResidual[tid] = r;
+    sDivergence[tid] = b;
+    __syncthreads();
+
+    for (int s = blockDim.x * blockDim.y * blockDim.z / 2; s > 0; s >>= 1) {
+        if (tid < s) {
+            sResidual[tid] = fmaxf(sResidual[tid], sResidual[tid + s]);
+            sDivergence[tid] = fmaxf(sDivergence[tid], sDivergence[tid + s]);
+        }
+        __syncthreads();
+    }
+    if (tid == 0) {
+        atomicMax(&d_maxResidualBits, __float_as_uint(sResidual[0]));
+        atomicMax(&d_maxDivergenceBits, __float_as_uint(sDivergence[0]));
+    }
+}
+
 // Project C: Subtract Gradient
 __global__ void subtract_gradient_kernel(
     float3* velocity, float* pressure,
@@ -268,6 +409,30 @@ __global__ void reflect_velocity_kernel(float3* vel_curr, float3* vel_old, int s
     vel_curr[idx] = 2.0f * u_mid - u_old;
 }
 
+// ٶȷֵֵ CFL ѡӲѹвͬ float λģʽ atomicMax
+__device__ unsigned int d_maxVelocityBits;
+
+__global__ void max_velocity_kernel(float3* velocity, int size)
+{
+    __shared__ float sMax[256];
+    int idx = blockIdx.x * blockDim.x + threadIdx.x;
+    float m = 0.0f;
+    if (idx < size) {
+        float3 v = velocity[idx];
+        m = fmaxf(fabsf(v.x), fmaxf(fabsf(v.y), fabsf(v.z)));
+    }
+    sMax[threadIdx.x] = m;
+    __syncthreads();
+
+    for (int s = blockDim.x / 2; s > 0; s >>= 1) {
+        if (threadIdx.x < s)
+            sMax[threadIdx.x] = fmaxf(sMax[threadIdx.x], sMax[threadIdx.x + s]);
+        __syncthreads();
+    }
+    if (threadIdx.x == 0)
+        atomicMax(&d_maxVelocityBits, __float_as_uint(sMax[0]));
+}
+
 // Դ
 __global__ void add_source_kernel(cudaSurfaceObject_t outputSurf, int x, int y, int z, float radius, float amount) {
     int i = blockIdx.x * blockDim.x + threadIdx.x;
@@ -275,9 +440,8 @@ __global__ void add_source_kernel(cudaSurfaceObject_t outputSurf, int x, int y,
     int k = blockIdx.z * blockDim.z + threadIdx.z;
     float dist = sqrtf((float)((i-x)*(i-x) + (j-y)*(j-y) + (k-z)*(k-z)));
     if (dist < radius) {
-         float oldVal;
-         surf3Dread(&oldVal, outputSurf, i * sizeof(float), j, k);
-         surf3Dwrite(oldVal + amount, outputSurf, i * sizeof(float), j, k);
+         float oldVal = readScalar(outputSurf, i, j, k);
+         writeScalar(oldVal + amount, outputSurf, i, j, k);
     }
 }
 
@@ -302,13 +466,39 @@ __global__ void dissipate_kernel(cudaSurfaceObject_t densitySurf, int width, int
     int z = blockIdx.z * blockDim.z + threadIdx.z;
     if (x >= width || y >= height || z >= depth) return;
 
-    float val;
-    surf3Dread(&val, densitySurf, x * sizeof(float), y, z);
+    float val = readScalar(densitySurf, x, y, z);
     
     // ˥ʽ: val = val / (1 + dt * rate)
     val *= dissipationRate;
     
-    surf3Dwrite(val, densitySurf, x * sizeof(float), y, z);
+    writeScalar(val, densitySurf, x, y, z);
+}
+
+// زԪ (x, y, z) ӳ䵽ͬһλúֵ
+__global__ void resample_scalar_kernel(cudaSurfaceObject_t outputSurf, cudaTextureObject_t inputTex,
+    float3 scale, int width, int height, int depth)
+{
+    int x = blockIdx.x * blockDim.x + threadIdx.x;
+    int y = blockIdx.y * blockDim.y + threadIdx.y;
+    int z = blockIdx.z * blockDim.z + threadIdx.z;
+    if (x >= width || y >= height || z >= depth) return;
+
+    float3 pos = make_float3((x + 0.5f) * scale.x, (y + 0.5f) * scale.y, (z + 0.5f) * scale.z);
+    writeScalar(tex3D<float>(inputTex, pos.x, pos.y, pos.z), outputSurf, x, y, z);
+}
+
+// ٶԸ/Ϊλٳ¾ɸ֮
+__global__ void resample_velocity_kernel(float3* new_vel, float3* old_vel, int3 oldDim, float3 scale,
+    int width, int height, int depth)
+{
+    int x = blockIdx.x * blockDim.x + threadIdx.x;
+    int y = blockIdx.y * blockDim.y + threadIdx.y;
+    int z = blockIdx.z * blockDim.z + threadIdx.z;
+    if (x >= width || y >= height || z >= depth) return;
+
+    float3 pos = make_float3((x + 0.5f) * scale.x, (y + 0.5f) * scale.y, (z + 0.5f) * scale.z);
+    float3 vel = sample_velocity_trilinear(old_vel, pos, oldDim);
+    new_vel[x + y * width + z * width * height] = make_float3(vel.x / scale.x, vel.y / scale.y, vel.z / scale.z);
 }
 
 // =========================================================
@@ -342,6 +532,13 @@ extern "C" void LaunchApplyBuoyancy(float3* d_velocity, cudaTextureObject_t dens
     apply_buoyancy_kernel<<<gridSize, blockSize>>>(d_velocity, densityTex, tempTex, dt, alpha, beta, ambientTemp, w, h, d);
 }
 
+extern "C" void LaunchVorticityConfinement(float3* d_velocity, float3* d_vorticity, float epsilon, float dt, int w, int h, int d) {
+    dim3 blockSize(8, 8, 8);
+    dim3 gridSize((w + 7) / 8, (h + 7) / 8, (d + 7) / 8);
+    compute_vorticity_kernel<<<gridSize, blockSize>>>(d_vorticity, d_velocity, w, h, d);
+    apply_vorticity_confinement_kernel<<<gridSize, blockSize>>>(d_velocity, d_vorticity, epsilon, dt, w, h, d);
+}
+
 extern "C" void LaunchComputeDivergence(float* d_div, float3* d_vel, int w, int h, int d, float halfrdx) {
     dim3 blockSize(8, 8, 8);
     dim3 gridSize((w + 7) / 8, (h + 7) / 8, (d + 7) / 8);
@@ -354,6 +551,23 @@ extern "C" void LaunchJacobiPressure(float* p_next, float* p_curr, float* d_div,
     jacobi_pressure_kernel<<<gridSize, blockSize>>>(p_next, p_curr, d_div, w, h, d);
 }
 
+// زвɢ֮ȣ追ȴ֮ǰύк˺
+extern "C" float LaunchPressureResidual(float* d_p, float* d_div, int w, int h, int d) {
+    unsigned int zero = 0;
+    cudaMemcpyToSymbol(d_maxResidualBits, &zero, sizeof(zero));
+    cudaMemcpyToSymbol(d_maxDivergenceBits, &zero, sizeof(zero));
+    dim3 blockSize(8, 8, 8);
+    dim3 gridSize((w + 7) / 8, (h + 7) / 8, (d + 7) / 8);
+    pressure_residual_kernel<<<gridSize, blockSize>>>(d_p, d_div, w, h, d);
+    unsigned int residualBits = 0, divergenceBits = 0;
+    cudaMemcpyFromSymbol(&residualBits, d_maxResidualBits, sizeof(residualBits));
+    cudaMemcpyFromSymbol(&divergenceBits, d_maxDivergenceBits, sizeof(divergenceBits));
+    float residual, divergence;
+    memcpy(&residual, &residualBits, sizeof(float));
+    memcpy(&divergence, &divergenceBits, sizeof(float));
+    return divergence > 0.0f ? residual / divergence : 0.0f;
+}
+
 extern "C" void LaunchSubtractGradient(float3* d_vel, float* d_p, int w, int h, int d, float halfrdx, float airDensity) {
     dim3 blockSize(8, 8, 8);
     dim3 gridSize((w + 7) / 8, (h + 7) / 8, (d + 7) / 8);
@@ -366,6 +580,20 @@ extern "C" void LaunchReflectVelocity(float3* d_vel_curr, float3* d_vel_old, int
     reflect_velocity_kernel<<<numBlocks, blockSize>>>(d_vel_curr, d_vel_old, size);
 }
 
+// 追ȴ֮ǰύк˺
+extern "C" float LaunchMaxVelocity(float3* d_velocity, int size) {
+    unsigned int zero = 0;
+    cudaMemcpyToSymbol(d_maxVelocityBits, &zero, sizeof(zero));
+    int blockSize = 256;
+    int numBlocks = (size + 255) / blockSize;
+    max_velocity_kernel<<<numBlocks, blockSize>>>(d_velocity, size);
+    unsigned int bits = 0;
+    cudaMemcpyFromSymbol(&bits, d_maxVelocityBits, sizeof(bits));
+    float maxVelocity;
+    memcpy(&maxVelocity, &bits, sizeof(float));
+    return maxVelocity;
+}
+
 extern "C" void LaunchAddSource(cudaSurfaceObject_t destSurf, int x, int y, int z, float radius, float amount, int w, int h, int d) {
     dim3 blockSize(8, 8, 8);
     dim3 gridSize((w + 7) / 8, (h + 7) / 8, (d + 7) / 8);
@@ -382,4 +610,17 @@ extern "C" void LaunchDissipate(cudaSurfaceObject_t densitySurf, int w, int h, i
     dim3 blockSize(8, 8, 8);
     dim3 gridSize((w + 7) / 8, (h + 7) / 8, (d + 7) / 8);
     dissipate_kernel<<<gridSize, blockSize>>>(densitySurf, w, h, d, rate);
-}
\ No newline at end of file
+}
+extern "C" void LaunchResampleScalar(cudaSurfaceObject_t dst, cudaTextureObject_t src, int sw, int sh, int sd, int w, int h, int d) {
+    dim3 blockSize(8, 8, 8);
+    dim3 gridSize((w + 7) / 8, (h + 7) / 8, (d + 7) / 8);
+    float3 scale = make_float3((float)sw / w, (float)sh / h, (float)sd / d);
+    resample_scalar_kernel<<<gridSize, blockSize>>>(dst, src, scale, w, h, d);
+}
+
+extern "C" void LaunchResampleVelocity(float3* dst, float3* src, int sw, int sh, int sd, int w, int h, int d) {
+    dim3 blockSize(8, 8, 8);
+    dim3 gridSize((w + 7) / 8, (h + 7) / 8, (d + 7) / 8);
+    float3 scale = make_float3((float)sw / w, (float)sh / h, (float)sd / d);
+    resample_velocity_kernel<<<gridSize, blockSize>>>(dst, src, make_int3(sw, sh, sd), scale, w, h, d);
+}
@@ -10,6 +10,7 @@
 #include <windows.h>
 #include <glm/glm.hpp>
 #include "GridData3d.h"
+#include "MACGridCore.h"
 #include <Logger.h>
 #include <cuda_runtime.h>
 #include <cuda_gl_interop.h>
@@ -23,7 +24,7 @@ namespace FluidSimulation
          * 洢ٶȡܶȡ¶ȵ
          * MACʽٶȷ洢ģ洢Ԫ
          */
-        class MACGrid3d
+        class MACGrid3d : public Glb::MACGridCore<3, MACGrid3d>
         {
             friend MACGrid3d;
 
@@ -40,7 +41,18 @@ namespace FluidSimulation
             glm::vec4 getRenderColor(const glm::vec3 &pt);
 
             void initialize();
+            // ߴ뵱ǰһʱԭ CPU  GPU 岢 trueԴ棩򷵻 false
+            bool reinitialize();
+            // ǰ״̬ CPU  GPU ˵ٶȡܶȡ¶ز newDim ϣcellSize 䣩
+            // ٶȰıţ֮ Solver::onGridResampled ͶӰһʹٶɢ
+            // Ⱦʹеĳߴ磬newDim Ӧ Eulerian3dPara::theDim3d һ
+            void resample(const int *newDim);
             void createSolids();
+            //  Eulerian3dPara::brickedLayout ѡĴ洢֣ڸ initialize ֮ǰ
+            // ֵȡٶȡܶȡ¶ȿԷֿ洢ֻ±ʣʼΪԲ
+            void applyLayout();
+            // д볡֮ˢ¸ ghost 㣬 at() ʹ
+            void fillGhosts();
 
             glm::vec3 semiLagrangian(const glm::vec3 &pt, double dt);
             glm::vec3 getVelocity(const glm::vec3 &pt);
@@ -74,6 +86,8 @@ namespace FluidSimulation
             bool inSolid(const glm::vec3 &pt);
             bool inSolid(const glm::vec3 &pt, int &i, int &j, int &k);
             bool intersects(const glm::vec3 &pt, const glm::vec3 &dir, int i, int j, int k, double &time);
+            // ޸ĵԪĹǣµԪ
+            void setSolid(int i, int j, int k, bool solid);
             int numSolidCells();
 
             double getPressureCoeffBetweenCells(int i0, int j0, int k0, int i1, int j1, int k1);
@@ -83,19 +97,55 @@ namespace FluidSimulation
 
             double getBoussinesqForce(const glm::vec3 &pt);
 
-            float cellSize;             // ԪС
-            int dim[3];                 // ά [, , ]
+            // cellSizedim Լά޹صļΡɢȡѹϵ MACGridCore ṩ
+            typedef Glb::MACGridCore<3, MACGrid3d> Core;
+
+            // MACGridCore ʹõķʽӿ
+            int solidAt(const int *c);
+            double faceAt(int axis, const int *c);
+            void cellOf(const glm::vec3 &pt, int *c);
 
             void InitCUDA();
+            //  GPU ˸ܶȡ¶Դ
+            void ResetCUDA();
             void CleanupCUDA();
 
+            // GPU Դľزʱ¾Դͬʱ
+            struct GpuResources
+            {
+                unsigned int densityTexID;
+                cudaGraphicsResource* cuda_density_res;
+                cudaArray* d_densityArrayTemp;
+                cudaTextureObject_t densityTexObjRead;
+                unsigned int temperatureTexID;
+                cudaGraphicsResource* cuda_temperature_res;
+                cudaArray* d_temperatureArrayTemp;
+                cudaTextureObject_t temperatureTexObjRead;
+                float3* d_velocity;
+                float3* d_velocity_backup;
+                float* d_pressure;
+                float* d_pressure_temp;
+                float* d_divergence;
+                float3* d_vorticity;
+                dim3 gpuDim;
+            };
+            //  res 滻ǰľԭľ
+            GpuResources exchangeGpuResources(const GpuResources &res);
+            // ǰ dim  GPU ԴӳߴΪ oldDim ľԴزٶȡܶȡ¶
+            void resampleCUDA(const int *oldDim);
+
         public:
-            Glb::GridData3dX mU;        // Xٶȷ
-            Glb::GridData3dY mV;        // Yٶȷ
-            Glb::GridData3dZ mW;        // Zٶȷ
-            Glb::CubicGridData3d mD;    // ܶȳ
-            Glb::CubicGridData3d mT;    // ¶ȳ
-            Glb::GridData3d mSolid;     // ǣ1ʾ壬0ʾ壩
+            // CPU ˸ GPU һʹ float uint8_t
+            // CPU ˸Ĳֵڱȷ GridInterp.hGPU ʹӰ
+            typedef Glb::DefaultInterpPolicies InterpPolicies;
+            typedef Glb::InterpGridData3d<Glb::GridData3d<Glb::ScalarStorage>, InterpPolicies::Scalar> ScalarField;
+
+            Glb::InterpGridData3d<Glb::GridData3dX<float>, InterpPolicies::Velocity> mU;  // Xٶȷ
+            Glb::InterpGridData3d<Glb::GridData3dY<float>, InterpPolicies::Velocity> mV;  // Yٶȷ
+            Glb::InterpGridData3d<Glb::GridData3dZ<float>, InterpPolicies::Velocity> mW;  // Zٶȷ
+            ScalarField mD;                     // ܶȳfloat FLUID_HALF_SCALARS ʱΪ뾫ȣ
+            ScalarField mT;                     // ¶ȳ
+            Glb::GridData3d<std::uint8_t> mSolid; // ǣ1ʾ壬0ʾ壩
 
             // ܶȳ (Ⱦ) - OpenGL 
             unsigned int densityTexID = 0;
@@ -117,6 +167,7 @@ namespace FluidSimulation
             float* d_pressure = nullptr;      // ѹ P
             float* d_pressure_temp = nullptr; //  Jacobi  Ping-Pong 
             float* d_divergence = nullptr;    // ٶɢ div(u)
+            float3* d_vorticity = nullptr; //  curl(u)Լ
             dim3 gpuDim;   // άȵ CUDA 
         };
 
@@ -0,0 +1,70 @@
+﻿/**
+ * OutOfCoreGrid3d.h: 外存 3D MAC 网格头文件
+ * 各场存放在内存映射文件中，网格可以超过物理内存，供离线仿真使用
+ */
+
+#pragma once
+#ifndef __EULERIAN_3D_OUT_OF_CORE_GRID_3D_H__
+#define __EULERIAN_3D_OUT_OF_CORE_GRID_3D_H__
+
+#include <cstdint>
+#include <string>
+#include <glm/glm.hpp>
+#include "MappedGridData3d.h"
+
+namespace FluidSimulation
+{
+    namespace Eulerian3d
+    {
+        /**
+         * 外存 3D MAC 网格
+         * 与 MACGrid3d 相同的交错布局：速度分量在面中心，标量在单元中心，Z 轴向上
+         * 场按 z 层连续存放（下标 i + j * n0 + k * n0 * n1），由 OutOfCoreSolver 按 z 层窗口流式处理
+         */
+        class OutOfCoreGrid3d
+        {
+        public:
+            OutOfCoreGrid3d();
+
+            // 在 dir 下创建各场的映射文件并重置，失败时记录日志并返回 false
+            bool open(const std::string &dir);
+
+            void reset();
+            void createSolids();
+            void updateSources();
+
+            glm::vec3 getCenter(int i, int j, int k) const;
+            glm::vec3 getVelocity(const glm::vec3 &pt) const;
+            double getDensity(const glm::vec3 &pt) const;
+            double getTemperature(const glm::vec3 &pt) const;
+            // order 为回溯的 Runge-Kutta 阶数（1 ~ 3），各阶段的速度都取自 pt 的 maxVel * dt 范围内，不会超出流式处理的 halo
+            glm::vec3 semiLagrangian(const glm::vec3 &pt, double dt, int order = 1) const;
+
+            // 网格之外视为固体（容器壁）
+            bool isSolidCell(int i, int j, int k) const;
+            // 单元 (i, j, k) 在 axis 负方向上的面，两侧有一侧为固体即为固体面
+            bool isSolidFace(int i, int j, int k, int axis) const;
+
+            // 以单元为单位的场内采样：off 为场的样本相对单元角点的偏移（面中心为 0 / 0.5，单元中心为 0.5）
+            static double sample(const Glb::MappedGridData3d<float> &field, const glm::vec3 &pt, const glm::vec3 &off, float cellSize);
+            // sample 所用的 8 个样本的 [lo, hi]
+            static void sampleRange(const Glb::MappedGridData3d<float> &field, const glm::vec3 &pt, const glm::vec3 &off, float cellSize, double &lo, double &hi);
+
+            enum Direction { X, Y, Z };
+
+            float cellSize;
+            int dim[3];
+
+            Glb::MappedGridData3d<float> mU, mV, mW;                // 面中心速度
+            Glb::MappedGridData3d<float> mU_back, mV_back, mW_back; // 对流的目标缓冲
+            Glb::MappedGridData3d<float> mD, mT;                    // 密度、温度
+            Glb::MappedGridData3d<float> mD_back, mT_back;
+            Glb::MappedGridData3d<float> mP;                        // 压力
+            Glb::MappedGridData3d<float> mP_back;                   // Chebyshev 迭代保存的上一次的压力
+            Glb::MappedGridData3d<float> mRhs;                      // 压力方程右端项
+            Glb::MappedGridData3d<std::uint8_t> mSolid;             // 固体标记（1表示固体）
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,86 @@
+﻿/**
+ * OutOfCoreSolver.h: 外存 3D 欧拉流体求解器头文件
+ * 在 CPU 上按 z 层窗口流式处理 OutOfCoreGrid3d，工作集只包含窗口及其 halo
+ */
+
+#pragma once
+#ifndef __EULERIAN_3D_OUT_OF_CORE_SOLVER_H__
+#define __EULERIAN_3D_OUT_OF_CORE_SOLVER_H__
+
+#include <initializer_list>
+#include "OutOfCoreGrid3d.h"
+#include "AdaptiveTimeStep.h"
+#include "Configure.h"
+#include "PressureIteration.h"
+
+namespace FluidSimulation
+{
+    namespace Eulerian3d
+    {
+        /**
+         * 外存求解器
+         * 对流、浮力、散度、压力迭代、梯度修正都按 z 层顺序遍历：
+         * 处理当前窗口时预取下一窗口，处理完后释放之后不再读取的层，内存占用与网格总大小无关
+         */
+        class OutOfCoreSolver
+        {
+        public:
+            OutOfCoreSolver(OutOfCoreGrid3d &grid);
+
+            // 执行一帧仿真（自适应步长时可能分为多个子步），烟雾源由调用方通过 grid.updateSources() 写入
+            void solve();
+
+        protected:
+            // 估计的最大速度分量：上一次投影记录的值与源速度取大
+            double maxVelocity() const;
+
+            // 半拉格朗日的结果写入后缓冲区后交换；Eulerian3dPara::advectionScheme 为 MacCormack / BFECC 时
+            // 再按窗口修正一遍（BFECC 两遍），结果经 mDeferred 延迟写回 mU 等，不再交换
+            void advect(float dt);
+            // 浮力与涡量约束力（Eulerian3dPara::vorticityConst > 0 时）在同一遍中加到面上
+            void computeforces(float dt);
+            // 单元中心的涡量写入 mU_back、mV_back、mW_back，模写入 mD_back；后缓冲区在两次对流之间不保存数据
+            void computeCurl();
+            void project(float dt);
+
+            // 压力迭代，按 Eulerian3dPara::pressureSolver 选择；右端项取自 mGrid.mRhs，结果写入 mGrid.mP
+            // 每次迭代（红黑 SOR 每种颜色）按 z 层窗口遍历一遍，窗口内按行并行
+            void relaxGaussSeidel(int iterations);
+            void relaxRedBlackSOR(int iterations, double omega);
+            void relaxChebyshevJacobi(int iterations);
+
+            // 单元 (i, j, k) 的一次 Jacobi 更新：(右端项 + 非固体邻居压力之和) / 非固体邻居数
+            // 没有非固体邻居时返回 false
+            bool jacobiUpdate(const Glb::MappedGridData3d<float> &p, int i, int j, int k, double &value) const;
+
+            // 对流单个场：dst 的每个样本从 src 回溯采样；axis 为面的法向，单元中心的场为 -1
+            void advectField(const Glb::MappedGridData3d<float> &src, Glb::MappedGridData3d<float> &dst,
+                             const glm::vec3 &off, int axis, int k0, int k1, float dt);
+
+            // 修正对流的各遍，phi 为对流前的场，hat 为半拉格朗日的结果（BFECC 最后一遍为修正后的初值）
+            enum CorrectionPass
+            {
+                kMacCormackPass,    // out = hat + (phi - phi~) / 2，phi~ 为 hat 在正向追踪终点的插值
+                kBFECCInitialPass,  // out = phi + (phi - phi~) / 2，不做限制
+                kBFECCFinalPass     // out = hat 在回溯终点的插值
+            };
+            // 修正一个场的窗口 [k0, k1)，除 kBFECCInitialPass 外结果都限制在回溯终点周围 phi 样本的 [min, max] 内
+            void correctField(const Glb::MappedGridData3d<float> &phi, const Glb::MappedGridData3d<float> &hat,
+                              Glb::DeferredSlabWriter<float> &out, const glm::vec3 &off, int axis,
+                              int k0, int k1, float dt, CorrectionPass pass);
+
+            // 按 z 层窗口遍历 [0, dim[2] + 1) 层，fn(k0, k1) 处理窗口 [k0, k1)
+            // halo 为窗口之外需要读取的层数，决定预取与释放的范围
+            template <typename F>
+            void streamSlabs(std::initializer_list<Glb::MappedSlabStorage *> fields, int halo, F fn);
+
+            OutOfCoreGrid3d &mGrid;
+            double mMaxVelocity;    // 上一步结束时的最大速度分量，用于估计对流回溯的 halo 和子步长
+            // 修正对流时 u、v、w、密度、温度的结果暂存在这里，直到之后的窗口不再读取对应的层
+            // 每个场最多暂存窗口深度加 halo 层，与网格总大小无关
+            Glb::DeferredSlabWriter<float> mDeferred[5];
+        };
+    }
+}
+
+#endif
@@ -8,7 +8,11 @@
 #define __EULERIAN_3D_SOLVER_H__
 
 #include "MACGrid3d.h"
+#include "AdaptiveTimeStep.h"
 #include "Configure.h"
+#include "PressurePCG.h"
+#include "PressureMultigrid.h"
+#include "PressureDCT.h"
 #include <cuda_runtime.h>
 #include <cuda_gl_interop.h>
 
@@ -37,8 +41,20 @@ namespace FluidSimulation
 			 */
 			void solve();
 
+			// ͶӰѹȥѹݶȣʹ GPU ٶɢ
+			void project(float dt);
+
+			//  MACGrid3d::resample ıߴãͶӰһʹزٶɢ
+			void onGridResampled();
+
+			// CPU  MAC ٶȳmUmVmWͶӰ MACGrid3d ĵԪǽ̣޹ʱ DCT ֱ⣬ PCG 
+			void projectMAC(float dt);
+
 		protected:
 			MACGrid3d &mGrid;  // MAC
+			Glb::PressurePCG<3> mPCG;  // CPU ͶӰʹõ PCG 
+			Glb::PressureMultigrid<3> mMultigrid;  // mPCG Ԥ
+			Glb::PressureDCT<3> mDCT;  // ֱӽⷨʱΪ mPCG Ԥ
 		};
 	}
 }
@@ -12,7 +12,9 @@ namespace FluidSimulation {
          */
         void Eulerian3dComponent::shutDown() {
             // ͷԴ
-            delete renderer, solver, grid;
+            delete renderer;
+            delete solver;
+            delete grid;
             renderer = NULL;
             solver = NULL;
             grid = NULL;
@@ -23,14 +25,22 @@ namespace FluidSimulation {
          * MACȾ
          */
         void Eulerian3dComponent::init() {
+            // üʱ
+            Glb::Timer::getInstance().clear();
+
+            // ߴδı(Rerun)ʱԭ CPU  GPU ,Դ,ֻؽ
+            if (grid != NULL && renderer != NULL && grid->reinitialize()) {
+                delete solver;
+                solver = new Solver(*grid);
+                Glb::Logger::getInstance().addLog("3d MAC gird reset in place.");
+                return;
+            }
+
             // Ѵͷ
             if (renderer != NULL || solver != NULL || grid != NULL) {
                 shutDown();
             }
 
-            // üʱ
-            Glb::Timer::getInstance().clear();
-
             // MAC
             grid = new MACGrid3d();
 
@@ -45,6 +55,34 @@ namespace FluidSimulation {
             solver = new Solver(*grid);
         }
 
+        /**
+         * زе·ֱ
+         * Դλð㵽ȾİΧ仯Ҫؽ
+         */
+        void Eulerian3dComponent::resample() {
+            if (grid == NULL || renderer == NULL || solver == NULL) {
+                init();
+                return;
+            }
+
+            const int *newDim = Eulerian3dPara::theDim3d;
+            for (auto &src : Eulerian3dPara::source) {
+                for (int d = 0; d < 3; d++) {
+                    int p = src.position[d] * newDim[d] / grid->dim[d];
+                    src.position[d] = (std::max)(0, (std::min)(p, newDim[d] - 1));
+                }
+            }
+            grid->resample(newDim);
+            solver->onGridResampled();
+
+            delete renderer;
+            renderer = new Renderer(*grid);
+
+            Glb::Logger::getInstance().addLog("3d MAC gird resampled. dimension: " + std::to_string(newDim[0]) + "x"
+                + std::to_string(newDim[1]) + "x"
+                + std::to_string(newDim[2]) + ".");
+        }
+
         void Eulerian3dComponent::simulate() {
             // Դһ
             grid->updateSources();
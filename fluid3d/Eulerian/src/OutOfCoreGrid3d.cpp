@@ -0,0 +1,150 @@
+﻿#include "fluid3d/Eulerian/include/OutOfCoreGrid3d.h"
+#include "Configure.h"
+#include "Logger.h"
+
+namespace FluidSimulation
+{
+    namespace Eulerian3d
+    {
+        OutOfCoreGrid3d::OutOfCoreGrid3d()
+        {
+            cellSize = Eulerian3dPara::theCellSize3d;
+            dim[0] = Eulerian3dPara::theDim3d[0];
+            dim[1] = Eulerian3dPara::theDim3d[1];
+            dim[2] = Eulerian3dPara::theDim3d[2];
+        }
+
+        bool OutOfCoreGrid3d::open(const std::string &dir)
+        {
+            struct Entry { Glb::MappedGridData3d<float> *field; const char *name; int extra; };
+            const Entry entries[] = {
+                { &mU, "u", X }, { &mU_back, "u_back", X },
+                { &mV, "v", Y }, { &mV_back, "v_back", Y },
+                { &mW, "w", Z }, { &mW_back, "w_back", Z },
+                { &mD, "density", -1 }, { &mD_back, "density_back", -1 },
+                { &mT, "temperature", -1 }, { &mT_back, "temperature_back", -1 },
+                { &mP, "pressure", -1 }, { &mP_back, "pressure_back", -1 }, { &mRhs, "rhs", -1 },
+            };
+            for (const Entry &e : entries) {
+                std::string path = dir + "/" + e.name + ".bin";
+                // 面中心的场在法向上多一层
+                if (!e.field->open(path, dim[0] + (e.extra == X), dim[1] + (e.extra == Y), dim[2] + (e.extra == Z))) {
+                    Glb::Logger::getInstance().addLog("out-of-core grid: failed to map " + path);
+                    return false;
+                }
+            }
+            if (!mSolid.open(dir + "/solid.bin", dim[0], dim[1], dim[2])) {
+                Glb::Logger::getInstance().addLog("out-of-core grid: failed to map " + dir + "/solid.bin");
+                return false;
+            }
+            reset();
+            createSolids();
+            return true;
+        }
+
+        void OutOfCoreGrid3d::reset()
+        {
+            mU.fill(0.0f);
+            mV.fill(0.0f);
+            mW.fill(0.0f);
+            mD.fill(0.0f);
+            mT.fill(Eulerian3dPara::ambientTemp);
+            mP.fill(0.0f);
+        }
+
+        void OutOfCoreGrid3d::createSolids()
+        {
+            mSolid.fill(0);
+            if (Eulerian3dPara::addSolid) {
+                for (int k = dim[2] / 2 - 2; k <= dim[2] / 2 + 2; k++)
+                    for (int j = dim[1] / 2 - 2; j <= dim[1] / 2 + 2; j++)
+                        for (int i = dim[0] / 2 - 2; i <= dim[0] / 2 + 2; i++)
+                            mSolid.at(i, j, k) = 1;
+            }
+        }
+
+        void OutOfCoreGrid3d::updateSources()
+        {
+            for (std::size_t s = 0; s < Eulerian3dPara::source.size(); s++) {
+                int x = Eulerian3dPara::source[s].position.x;
+                int y = Eulerian3dPara::source[s].position.y;
+                int z = Eulerian3dPara::source[s].position.z;
+                if (x < 0 || y < 0 || z < 0 || x >= dim[0] || y >= dim[1] || z >= dim[2])
+                    continue;
+                mT.at(x, y, z) = Eulerian3dPara::source[s].temp;
+                mD.at(x, y, z) = Eulerian3dPara::source[s].density;
+                mU.at(x, y, z) = Eulerian3dPara::source[s].velocity.x;
+                mV.at(x, y, z) = Eulerian3dPara::source[s].velocity.y;
+                mW.at(x, y, z) = Eulerian3dPara::source[s].velocity.z;
+            }
+        }
+
+        glm::vec3 OutOfCoreGrid3d::getCenter(int i, int j, int k) const
+        {
+            return glm::vec3((i + 0.5f) * cellSize, (j + 0.5f) * cellSize, (k + 0.5f) * cellSize);
+        }
+
+        double OutOfCoreGrid3d::sample(const Glb::MappedGridData3d<float> &field, const glm::vec3 &pt, const glm::vec3 &off, float cellSize)
+        {
+            return field.trilinear(pt.x / cellSize - off.x, pt.y / cellSize - off.y, pt.z / cellSize - off.z);
+        }
+
+        void OutOfCoreGrid3d::sampleRange(const Glb::MappedGridData3d<float> &field, const glm::vec3 &pt, const glm::vec3 &off, float cellSize, double &lo, double &hi)
+        {
+            field.trilinearRange(pt.x / cellSize - off.x, pt.y / cellSize - off.y, pt.z / cellSize - off.z, lo, hi);
+        }
+
+        glm::vec3 OutOfCoreGrid3d::getVelocity(const glm::vec3 &pt) const
+        {
+            return glm::vec3(
+                (float)sample(mU, pt, glm::vec3(0.0f, 0.5f, 0.5f), cellSize),
+                (float)sample(mV, pt, glm::vec3(0.5f, 0.0f, 0.5f), cellSize),
+                (float)sample(mW, pt, glm::vec3(0.5f, 0.5f, 0.0f), cellSize));
+        }
+
+        double OutOfCoreGrid3d::getDensity(const glm::vec3 &pt) const
+        {
+            return sample(mD, pt, glm::vec3(0.5f), cellSize);
+        }
+
+        double OutOfCoreGrid3d::getTemperature(const glm::vec3 &pt) const
+        {
+            return sample(mT, pt, glm::vec3(0.5f), cellSize);
+        }
+
+        glm::vec3 OutOfCoreGrid3d::semiLagrangian(const glm::vec3 &pt, double dt, int order) const
+        {
+            auto clampToGrid = [&](glm::vec3 pos) {
+                for (int d = 0; d < 3; d++)
+                    pos[d] = (std::min)((std::max)(pos[d], 0.0f), dim[d] * cellSize);
+                return pos;
+            };
+            // 1 前向 Euler，2 中点法，3 Ralston 三阶法
+            glm::vec3 vel = getVelocity(pt);
+            if (order >= 2) {
+                const glm::vec3 k1 = vel;
+                const glm::vec3 k2 = getVelocity(clampToGrid(pt - k1 * (float)(0.5 * dt)));
+                vel = k2;
+                if (order >= 3) {
+                    const glm::vec3 k3 = getVelocity(clampToGrid(pt - k2 * (float)(0.75 * dt)));
+                    vel = k1 * (2.0f / 9.0f) + k2 * (3.0f / 9.0f) + k3 * (4.0f / 9.0f);
+                }
+            }
+            return clampToGrid(pt - vel * (float)dt);
+        }
+
+        bool OutOfCoreGrid3d::isSolidCell(int i, int j, int k) const
+        {
+            if (i < 0 || j < 0 || k < 0 || i >= dim[0] || j >= dim[1] || k >= dim[2])
+                return true;
+            return mSolid.at(i, j, k) == 1;
+        }
+
+        bool OutOfCoreGrid3d::isSolidFace(int i, int j, int k, int axis) const
+        {
+            int c[3] = { i, j, k };
+            c[axis]--;
+            return isSolidCell(i, j, k) || isSolidCell(c[0], c[1], c[2]);
+        }
+    }
+}
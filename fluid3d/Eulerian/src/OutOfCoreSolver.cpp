@@ -0,0 +1,500 @@
+﻿#include "fluid3d/Eulerian/include/OutOfCoreSolver.h"
+#include <cmath>
+#include "MACGridCore.h"
+
+namespace FluidSimulation
+{
+    namespace Eulerian3d
+    {
+        OutOfCoreSolver::OutOfCoreSolver(OutOfCoreGrid3d &grid) : mGrid(grid), mMaxVelocity(0.0)
+        {
+        }
+
+        void OutOfCoreSolver::solve()
+        {
+            // 开启自适应步长时 dt 为一帧推进的时间，按 CFL 条件分成若干子步
+            // 最大速度取上一次投影时顺便记录的值，不需要额外遍历外存
+            Glb::AdaptiveTimeStep steps(Eulerian3dPara::dt, Eulerian3dPara::adaptiveTimeStep,
+                Eulerian3dPara::cflNumber, Eulerian3dPara::maxSubsteps, mGrid.cellSize);
+            while (!steps.done()) {
+                float dt = steps.next(maxVelocity());
+                advect(dt);
+                computeforces(dt);
+                project(dt);
+            }
+            steps.record();
+        }
+
+        double OutOfCoreSolver::maxVelocity() const
+        {
+            // 上一次投影后的最大速度分量，源注入的速度可能更大
+            double maxVel = mMaxVelocity;
+            for (std::size_t s = 0; s < Eulerian3dPara::source.size(); s++) {
+                const glm::vec3 &v = Eulerian3dPara::source[s].velocity;
+                maxVel = (std::max)(maxVel, (double)(std::max)(std::fabs(v.x), (std::max)(std::fabs(v.y), std::fabs(v.z))));
+            }
+            return maxVel;
+        }
+
+        template <typename F>
+        void OutOfCoreSolver::streamSlabs(std::initializer_list<Glb::MappedSlabStorage *> fields, int halo, F fn)
+        {
+            // 面中心的 W 比单元多一层
+            const int layers = mGrid.dim[2] + 1;
+            const int depth = (std::max)(Eulerian3dPara::slabDepth, 1);
+            for (Glb::MappedSlabStorage *f : fields)
+                f->prefetchSlabs(0, depth + halo);
+            int evicted = 0;
+            for (int k0 = 0; k0 < layers; k0 += depth) {
+                int k1 = (std::min)(k0 + depth, layers);
+                // 处理当前窗口的同时由内核读入下一个窗口
+                for (Glb::MappedSlabStorage *f : fields)
+                    f->prefetchSlabs(k1 + halo, k1 + depth + halo);
+                fn(k0, k1);
+                // 之后的窗口只读取 k1 - halo 及以上的层
+                int keep = k1 - halo;
+                if (keep > evicted) {
+                    for (Glb::MappedSlabStorage *f : fields)
+                        f->evictSlabs(evicted, keep);
+                    evicted = keep;
+                }
+            }
+            for (Glb::MappedSlabStorage *f : fields)
+                f->evictSlabs(evicted, layers);
+        }
+
+        void OutOfCoreSolver::advectField(const Glb::MappedGridData3d<float> &src, Glb::MappedGridData3d<float> &dst,
+                                          const glm::vec3 &off, int axis, int k0, int k1, float dt)
+        {
+            const int n0 = dst.extent(0);
+            const int n1 = dst.extent(1);
+            const int rows = ((std::min)(k1, dst.extent(2)) - k0) * n1;
+            const float h = mGrid.cellSize;
+            // 每个样本只写一次，按行并行的结果与串行相同
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+            for (int r = 0; r < rows; r++) {
+                int k = k0 + r / n1;
+                int j = r % n1;
+                for (int i = 0; i < n0; i++) {
+                    int c[3] = { i, j, k };
+                    if (axis >= 0) {
+                        // 容器边界上的面不参与对流，沿用当前值
+                        if (c[axis] == 0 || c[axis] == mGrid.dim[axis]) {
+                            dst.at(i, j, k) = src.at(i, j, k);
+                            continue;
+                        }
+                        if (mGrid.isSolidFace(i, j, k, axis)) {
+                            dst.at(i, j, k) = 0.0f;
+                            continue;
+                        }
+                    }
+                    else if (mGrid.isSolidCell(i, j, k)) {
+                        dst.at(i, j, k) = src.at(i, j, k);
+                        continue;
+                    }
+                    glm::vec3 pos((i + off.x) * h, (j + off.y) * h, (k + off.z) * h);
+                    dst.at(i, j, k) = (float)OutOfCoreGrid3d::sample(src, mGrid.semiLagrangian(pos, dt, Eulerian3dPara::backtraceOrder), off, h);
+                }
+            }
+        }
+
+        void OutOfCoreSolver::correctField(const Glb::MappedGridData3d<float> &phi, const Glb::MappedGridData3d<float> &hat,
+                                           Glb::DeferredSlabWriter<float> &out, const glm::vec3 &off, int axis,
+                                           int k0, int k1, float dt, CorrectionPass pass)
+        {
+            const int n0 = phi.extent(0);
+            const int n1 = phi.extent(1);
+            const int rows = ((std::min)(k1, phi.extent(2)) - k0) * n1;
+            const float h = mGrid.cellSize;
+            const int order = Eulerian3dPara::backtraceOrder;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+            for (int r = 0; r < rows; r++) {
+                int k = k0 + r / n1;
+                int j = r % n1;
+                for (int i = 0; i < n0; i++) {
+                    int c[3] = { i, j, k };
+                    const double p = phi.at(i, j, k);
+                    float &result = out.at(i, j, k);
+                    // 与 advectField 相同：边界面和固体单元保持原值，固体面为 0（BFECC 的初值仍取原值）
+                    if (axis >= 0) {
+                        if (c[axis] == 0 || c[axis] == mGrid.dim[axis]) {
+                            result = (float)p;
+                            continue;
+                        }
+                        if (mGrid.isSolidFace(i, j, k, axis)) {
+                            result = pass == kBFECCInitialPass ? (float)p : 0.0f;
+                            continue;
+                        }
+                    }
+                    else if (mGrid.isSolidCell(i, j, k)) {
+                        result = (float)p;
+                        continue;
+                    }
+                    glm::vec3 pos((i + off.x) * h, (j + off.y) * h, (k + off.z) * h);
+                    double value;
+                    if (pass == kBFECCFinalPass) {
+                        value = OutOfCoreGrid3d::sample(hat, mGrid.semiLagrangian(pos, dt, order), off, h);
+                    }
+                    else {
+                        // 正向追踪 dt 后在半拉格朗日的结果上插值，与 phi 的差为一来一回的误差
+                        double tilde = OutOfCoreGrid3d::sample(hat, mGrid.semiLagrangian(pos, -dt, order), off, h);
+                        if (pass == kBFECCInitialPass) {
+                            result = (float)(p + 0.5 * (p - tilde));
+                            continue;
+                        }
+                        value = hat.at(i, j, k) + 0.5 * (p - tilde);
+                    }
+                    double lo, hi;
+                    OutOfCoreGrid3d::sampleRange(phi, mGrid.semiLagrangian(pos, dt, order), off, h, lo, hi);
+                    result = (float)(std::max)(lo, (std::min)(hi, value));
+                }
+            }
+        }
+
+        void OutOfCoreSolver::advect(float dt)
+        {
+            // 回溯距离不超过 maxVel * dt，再加上三线性插值模板和取整的余量
+            // 修正对流的正向追踪距离相同，各遍使用同样的 halo
+            double maxVel = maxVelocity();
+            int halo = (int)std::ceil(maxVel * dt / mGrid.cellSize) + 2;
+
+            const glm::vec3 offU(0.0f, 0.5f, 0.5f), offV(0.5f, 0.0f, 0.5f), offW(0.5f, 0.5f, 0.0f), offC(0.5f);
+            streamSlabs({ &mGrid.mU, &mGrid.mV, &mGrid.mW, &mGrid.mD, &mGrid.mT, &mGrid.mSolid,
+                          &mGrid.mU_back, &mGrid.mV_back, &mGrid.mW_back, &mGrid.mD_back, &mGrid.mT_back },
+                        halo, [&](int k0, int k1) {
+                advectField(mGrid.mU, mGrid.mU_back, offU, OutOfCoreGrid3d::X, k0, k1, dt);
+                advectField(mGrid.mV, mGrid.mV_back, offV, OutOfCoreGrid3d::Y, k0, k1, dt);
+                advectField(mGrid.mW, mGrid.mW_back, offW, OutOfCoreGrid3d::Z, k0, k1, dt);
+                advectField(mGrid.mD, mGrid.mD_back, offC, -1, k0, k1, dt);
+                advectField(mGrid.mT, mGrid.mT_back, offC, -1, k0, k1, dt);
+            });
+
+            if (Eulerian3dPara::advectionScheme == Glb::kAdvectSemiLagrangian) {
+                // 交换映射文件代替整场拷贝
+                mGrid.mU.swap(mGrid.mU_back);
+                mGrid.mV.swap(mGrid.mV_back);
+                mGrid.mW.swap(mGrid.mW_back);
+                mGrid.mD.swap(mGrid.mD_back);
+                mGrid.mT.swap(mGrid.mT_back);
+                return;
+            }
+
+            // 修正的每一遍都要读取窗口及其 halo 内的 phi、hat 和对流前的速度，结果不能直接写回这些场：
+            // 先暂存，等窗口推进到之后不再读取的层时再写入；MacCormack 与 BFECC 最后一遍写回 mU 等，BFECC 的初值写回后缓冲区
+            Glb::MappedGridData3d<float> *phi[5] = { &mGrid.mU, &mGrid.mV, &mGrid.mW, &mGrid.mD, &mGrid.mT };
+            Glb::MappedGridData3d<float> *hat[5] = { &mGrid.mU_back, &mGrid.mV_back, &mGrid.mW_back, &mGrid.mD_back, &mGrid.mT_back };
+            const glm::vec3 off[5] = { offU, offV, offW, offC, offC };
+            const int axis[5] = { OutOfCoreGrid3d::X, OutOfCoreGrid3d::Y, OutOfCoreGrid3d::Z, -1, -1 };
+            const int layers = mGrid.dim[2] + 1;
+            const int capacity = (std::max)(Eulerian3dPara::slabDepth, 1) + halo;
+            auto correct = [&](CorrectionPass pass, Glb::MappedGridData3d<float> *const *target) {
+                for (int f = 0; f < 5; f++)
+                    mDeferred[f].begin(*target[f], capacity);
+                streamSlabs({ &mGrid.mU, &mGrid.mV, &mGrid.mW, &mGrid.mD, &mGrid.mT, &mGrid.mSolid,
+                              &mGrid.mU_back, &mGrid.mV_back, &mGrid.mW_back, &mGrid.mD_back, &mGrid.mT_back },
+                            halo, [&](int k0, int k1) {
+                    for (int f = 0; f < 5; f++)
+                        correctField(*phi[f], *hat[f], mDeferred[f], off[f], axis[f], k0, k1, dt, pass);
+                    // 之后的窗口只读取 k1 - halo 及以上的层，在这些层被释放之前写入
+                    for (int f = 0; f < 5; f++)
+                        mDeferred[f].commit(k1 < layers ? k1 - halo : layers);
+                });
+            };
+            if (Eulerian3dPara::advectionScheme == Glb::kAdvectBFECC) {
+                correct(kBFECCInitialPass, hat);
+                correct(kBFECCFinalPass, phi);
+            }
+            else {
+                correct(kMacCormackPass, phi);
+            }
+        }
+
+        void OutOfCoreSolver::computeforces(float dt)
+        {
+            const double alpha = Eulerian3dPara::boussinesqAlpha;
+            const double beta = Eulerian3dPara::boussinesqBeta;
+            const double ambient = Eulerian3dPara::ambientTemp;
+            Glb::MappedGridData3d<float> &D = mGrid.mD;
+            Glb::MappedGridData3d<float> &T = mGrid.mT;
+            const int numX = mGrid.dim[0], numY = mGrid.dim[1], numZ = mGrid.dim[2];
+
+            // 涡量约束：N = grad|omega| / |grad|omega||，单元中心的力 f = epsilon * h * (N x omega)，面上的力取两侧单元的平均
+            const double epsilon = Eulerian3dPara::vorticityConst;
+            const bool confine = epsilon > 0.0;
+            if (confine)
+                computeCurl();
+            const Glb::MappedGridData3d<float> *curl[3] = { &mGrid.mU_back, &mGrid.mV_back, &mGrid.mW_back };
+            const Glb::MappedGridData3d<float> &curlNorm = mGrid.mD_back;
+            auto confinement = [&](int i, int j, int k) {
+                const int c[3] = { i, j, k };
+                glm::dvec3 grad, omega;
+                for (int axis = 0; axis < 3; axis++) {
+                    // 边界处退化为单侧差分
+                    int lo[3] = { i, j, k }, hi[3] = { i, j, k };
+                    lo[axis] = (std::max)(c[axis] - 1, 0);
+                    hi[axis] = (std::min)(c[axis] + 1, mGrid.dim[axis] - 1);
+                    grad[axis] = (curlNorm.at(hi[0], hi[1], hi[2]) - curlNorm.at(lo[0], lo[1], lo[2])) / (hi[axis] - lo[axis]);
+                    omega[axis] = curl[axis]->at(i, j, k);
+                }
+                return glm::cross(grad, omega) * (epsilon * mGrid.cellSize / (glm::length(grad) + 1e-20));
+            };
+
+            // 浮力沿 Z 轴向上，加在两侧单元都不是固体的 W 面上；每个面只写一次，按行并行
+            auto apply = [&](int k0, int k1) {
+                const int kBegin = confine ? k0 : (std::max)(k0, 1);
+                const int rows = ((std::min)(k1, numZ) - kBegin) * numY;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+                for (int r = 0; r < rows; r++) {
+                    const int k = kBegin + r / numY;
+                    const int j = r % numY;
+                    for (int i = 0; i < numX; i++) {
+                        if (confine) {
+                            if (!mGrid.isSolidFace(i, j, k, OutOfCoreGrid3d::X))
+                                mGrid.mU.at(i, j, k) += (float)((confinement(i - 1, j, k).x + confinement(i, j, k).x) * 0.5 * dt);
+                            if (!mGrid.isSolidFace(i, j, k, OutOfCoreGrid3d::Y))
+                                mGrid.mV.at(i, j, k) += (float)((confinement(i, j - 1, k).y + confinement(i, j, k).y) * 0.5 * dt);
+                        }
+                        if (k == 0 || mGrid.isSolidCell(i, j, k) || mGrid.isSolidCell(i, j, k - 1))
+                            continue;
+                        double f1 = -alpha * D.at(i, j, k) + beta * (T.at(i, j, k) - ambient);
+                        double f0 = -alpha * D.at(i, j, k - 1) + beta * (T.at(i, j, k - 1) - ambient);
+                        double w = (f1 + f0) * 0.5 * dt;
+                        if (confine)
+                            w += (confinement(i, j, k - 1).z + confinement(i, j, k).z) * 0.5 * dt;
+                        mGrid.mW.at(i, j, k) += (float)w;
+                    }
+                }
+            };
+            // 约束力在 W 面 k 上需要单元 k - 1、k 的力，即 k - 2 ~ k + 1 层的涡量
+            if (confine)
+                streamSlabs({ &mGrid.mU, &mGrid.mV, &mGrid.mW, &D, &T, &mGrid.mSolid,
+                              &mGrid.mU_back, &mGrid.mV_back, &mGrid.mW_back, &mGrid.mD_back }, 2, apply);
+            else
+                streamSlabs({ &mGrid.mW, &D, &T, &mGrid.mSolid }, 1, apply);
+        }
+
+        void OutOfCoreSolver::computeCurl()
+        {
+            const int numX = mGrid.dim[0], numY = mGrid.dim[1], numZ = mGrid.dim[2];
+            const double h = mGrid.cellSize;
+            const Glb::MappedGridData3d<float> *vel[3] = { &mGrid.mU, &mGrid.mV, &mGrid.mW };
+            Glb::MappedGridData3d<float> *curl[3] = { &mGrid.mU_back, &mGrid.mV_back, &mGrid.mW_back };
+
+            // 单元中心的速度分量取两侧面的平均
+            auto center = [&](int comp, const int *c) {
+                int up[3] = { c[0], c[1], c[2] };
+                up[comp]++;
+                return 0.5 * (vel[comp]->at(c[0], c[1], c[2]) + vel[comp]->at(up[0], up[1], up[2]));
+            };
+            // 速度分量 comp 沿 axis 的中心差分，边界处退化为单侧差分
+            auto derivative = [&](int comp, int axis, const int *c) {
+                int lo[3] = { c[0], c[1], c[2] }, hi[3] = { c[0], c[1], c[2] };
+                lo[axis] = (std::max)(c[axis] - 1, 0);
+                hi[axis] = (std::min)(c[axis] + 1, mGrid.dim[axis] - 1);
+                return (center(comp, hi) - center(comp, lo)) / ((hi[axis] - lo[axis]) * h);
+            };
+
+            // 单元 k 的中心速度读到 W 的 k + 2 层；固体单元的涡量为 0
+            streamSlabs({ &mGrid.mU, &mGrid.mV, &mGrid.mW, &mGrid.mSolid,
+                          &mGrid.mU_back, &mGrid.mV_back, &mGrid.mW_back, &mGrid.mD_back }, 2, [&](int k0, int k1) {
+                const int rows = ((std::min)(k1, numZ) - k0) * numY;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+                for (int r = 0; r < rows; r++) {
+                    const int k = k0 + r / numY;
+                    const int j = r % numY;
+                    for (int i = 0; i < numX; i++) {
+                        const int c[3] = { i, j, k };
+                        glm::dvec3 omega(0.0);
+                        if (!mGrid.isSolidCell(i, j, k))
+                            omega = glm::dvec3(derivative(2, 1, c) - derivative(1, 2, c),
+                                               derivative(0, 2, c) - derivative(2, 0, c),
+                                               derivative(1, 0, c) - derivative(0, 1, c));
+                        for (int axis = 0; axis < 3; axis++)
+                            curl[axis]->at(i, j, k) = (float)omega[axis];
+                        mGrid.mD_back.at(i, j, k) = (float)glm::length(omega);
+                    }
+                }
+            });
+        }
+
+        bool OutOfCoreSolver::jacobiUpdate(const Glb::MappedGridData3d<float> &p, int i, int j, int k, double &value) const
+        {
+            const int nb[6][3] = { { i + 1, j, k }, { i - 1, j, k }, { i, j + 1, k },
+                                   { i, j - 1, k }, { i, j, k + 1 }, { i, j, k - 1 } };
+            double sum = 0.0;
+            int s = 0;
+            for (int n = 0; n < 6; n++) {
+                if (mGrid.isSolidCell(nb[n][0], nb[n][1], nb[n][2]))
+                    continue;
+                sum += p.at(nb[n][0], nb[n][1], nb[n][2]);
+                s++;
+            }
+            if (s == 0)
+                return false;
+            value = (mGrid.mRhs.at(i, j, k) + sum) / s;
+            return true;
+        }
+
+        void OutOfCoreSolver::relaxGaussSeidel(int iterations)
+        {
+            // 按 z 层顺序原地更新，只需要相邻一层作为 halo；后面的单元使用本轮已更新的值，只能串行
+            const int numX = mGrid.dim[0], numY = mGrid.dim[1], numZ = mGrid.dim[2];
+            Glb::MappedGridData3d<float> &P = mGrid.mP;
+            for (int iteration = 0; iteration < iterations; iteration++) {
+                streamSlabs({ &P, &mGrid.mRhs, &mGrid.mSolid }, 1, [&](int k0, int k1) {
+                    for (int k = k0; k < (std::min)(k1, numZ); k++)
+                        for (int j = 0; j < numY; j++)
+                            for (int i = 0; i < numX; i++) {
+                                double value;
+                                if (!mGrid.isSolidCell(i, j, k) && jacobiUpdate(P, i, j, k, value))
+                                    P.at(i, j, k) = (float)value;
+                            }
+                });
+            }
+        }
+
+        void OutOfCoreSolver::relaxRedBlackSOR(int iterations, double omega)
+        {
+            // (i + j + k) 为偶数的红色单元只与黑色单元相邻：每种颜色遍历一遍窗口，同色单元互不依赖
+            // 每个单元的新值只依赖另一种颜色，窗口划分和线程数都不影响结果
+            const int numX = mGrid.dim[0], numY = mGrid.dim[1], numZ = mGrid.dim[2];
+            Glb::MappedGridData3d<float> &P = mGrid.mP;
+            const double w = Glb::sorRelaxation(omega, Glb::jacobiSpectralRadius(mGrid.dim, 3));
+            for (int iteration = 0; iteration < iterations; iteration++) {
+                for (int color = 0; color < 2; color++) {
+                    streamSlabs({ &P, &mGrid.mRhs, &mGrid.mSolid }, 1, [&](int k0, int k1) {
+                        const int rows = ((std::min)(k1, numZ) - k0) * numY;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+                        for (int r = 0; r < rows; r++) {
+                            int k = k0 + r / numY;
+                            int j = r % numY;
+                            for (int i = (j + k + color) & 1; i < numX; i += 2) {
+                                double value;
+                                if (mGrid.isSolidCell(i, j, k) || !jacobiUpdate(P, i, j, k, value))
+                                    continue;
+                                float &p = P.at(i, j, k);
+                                p = (float)(p + w * (value - p));
+                            }
+                        }
+                    });
+                }
+            }
+        }
+
+        void OutOfCoreSolver::relaxChebyshevJacobi(int iterations)
+        {
+            // 新值写入保存上一次解的 mP_back：x(k+1) = omega * J x(k) + (1 - omega) * x(k-1)，再与 mP 交换
+            // 第一次迭代 omega 为 1，不读取 mP_back，因此不需要先清零
+            const int numX = mGrid.dim[0], numY = mGrid.dim[1], numZ = mGrid.dim[2];
+            Glb::ChebyshevSchedule schedule(Glb::jacobiSpectralRadius(mGrid.dim, 3));
+            for (int iteration = 0; iteration < iterations; iteration++) {
+                const double w = schedule.next();
+                const Glb::MappedGridData3d<float> &P = mGrid.mP;
+                Glb::MappedGridData3d<float> &next = mGrid.mP_back;
+                streamSlabs({ &mGrid.mP, &next, &mGrid.mRhs, &mGrid.mSolid }, 1, [&](int k0, int k1) {
+                    const int rows = ((std::min)(k1, numZ) - k0) * numY;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+                    for (int r = 0; r < rows; r++) {
+                        int k = k0 + r / numY;
+                        int j = r % numY;
+                        for (int i = 0; i < numX; i++) {
+                            double value;
+                            if (mGrid.isSolidCell(i, j, k) || !jacobiUpdate(P, i, j, k, value)) {
+                                next.at(i, j, k) = P.at(i, j, k);
+                                continue;
+                            }
+                            double prev = iteration == 0 ? 0.0 : next.at(i, j, k);
+                            next.at(i, j, k) = (float)(w * value + (1.0 - w) * prev);
+                        }
+                    }
+                });
+                mGrid.mP.swap(mGrid.mP_back);
+            }
+        }
+
+        void OutOfCoreSolver::project(float dt)
+        {
+            const int numX = mGrid.dim[0], numY = mGrid.dim[1], numZ = mGrid.dim[2];
+            const double h = mGrid.cellSize;
+            const double aird = Eulerian3dPara::airDensity;
+            Glb::MappedGridData3d<float> *face[3] = { &mGrid.mU, &mGrid.mV, &mGrid.mW };
+            Glb::MappedGridData3d<float> &P = mGrid.mP;
+            Glb::MappedGridData3d<float> &rhs = mGrid.mRhs;
+
+            // 默认以上一步的压力为初值；Chebyshev 迭代从 0 开始收敛更好
+            const bool warmStart = Eulerian3dPara::warmStart
+                && Eulerian3dPara::pressureSolver != Glb::kPressureChebyshevJacobi;
+
+            // 1. 右端项，固体面上的速度按 0 计
+            streamSlabs({ &mGrid.mU, &mGrid.mV, &mGrid.mW, &rhs, &P, &mGrid.mSolid }, 1, [&](int k0, int k1) {
+                for (int k = k0; k < (std::min)(k1, numZ); k++)
+                    for (int j = 0; j < numY; j++)
+                        for (int i = 0; i < numX; i++) {
+                            if (!warmStart)
+                                P.at(i, j, k) = 0.0f;
+                            if (mGrid.isSolidCell(i, j, k)) {
+                                rhs.at(i, j, k) = 0.0f;
+                                continue;
+                            }
+                            double div = 0.0;
+                            for (int axis = 0; axis < 3; axis++) {
+                                int c[3] = { i, j, k };
+                                double v0 = mGrid.isSolidFace(c[0], c[1], c[2], axis) ? 0.0 : face[axis]->at(c[0], c[1], c[2]);
+                                c[axis]++;
+                                double v1 = mGrid.isSolidFace(c[0], c[1], c[2], axis) ? 0.0 : face[axis]->at(c[0], c[1], c[2]);
+                                div += v1 - v0;
+                            }
+                            div /= h;
+                            rhs.at(i, j, k) = (float)(-div * aird * h * h / dt);
+                        }
+            });
+
+            // 2. 压力迭代
+            const int iterations = (std::max)(Eulerian3dPara::pressureIterations, 0);
+            switch (Eulerian3dPara::pressureSolver) {
+            case Glb::kPressureRedBlackSOR:
+                relaxRedBlackSOR(iterations, Eulerian3dPara::sorOmega);
+                break;
+            case Glb::kPressureChebyshevJacobi:
+                relaxChebyshevJacobi(iterations);
+                break;
+            default:
+                relaxGaussSeidel(iterations);
+                break;
+            }
+
+            // 3. 减去压力梯度，固体面（含容器壁）速度置 0；顺便记录最大速度供下一步估计 halo
+            double maxVel = 0.0;
+            streamSlabs({ &mGrid.mU, &mGrid.mV, &mGrid.mW, &P, &mGrid.mSolid }, 1, [&](int k0, int k1) {
+                for (int axis = 0; axis < 3; axis++) {
+                    Glb::MappedGridData3d<float> &u = *face[axis];
+                    for (int k = k0; k < (std::min)(k1, u.extent(2)); k++)
+                        for (int j = 0; j < u.extent(1); j++)
+                            for (int i = 0; i < u.extent(0); i++) {
+                                if (mGrid.isSolidFace(i, j, k, axis)) {
+                                    u.at(i, j, k) = 0.0f;
+                                    continue;
+                                }
+                                int c[3] = { i, j, k };
+                                c[axis]--;
+                                u.at(i, j, k) -= (float)(dt * (P.at(i, j, k) - P.at(c[0], c[1], c[2])) / (h * aird));
+                                maxVel = (std::max)(maxVel, (double)std::fabs(u.at(i, j, k)));
+                            }
+                }
+            });
+            mMaxVelocity = maxVel;
+        }
+    }
+}
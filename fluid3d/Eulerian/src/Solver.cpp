@@ -11,10 +11,13 @@
 extern "C" void LaunchAdvect(cudaSurfaceObject_t targetSurf, cudaTextureObject_t sourceTex, float3* d_velocity, float dt, int w, int h, int d, bool useBFECC);
 extern "C" void LaunchAdvectVelocity(float3* new_vel, float3* old_vel, float dt, int w, int h, int d);
 extern "C" void LaunchApplyBuoyancy(float3* d_velocity, cudaTextureObject_t densityTex, cudaTextureObject_t tempTex, float dt, float alpha, float beta, float ambientTemp, int w, int h, int d);
+extern "C" void LaunchVorticityConfinement(float3* d_velocity, float3* d_vorticity, float epsilon, float dt, int w, int h, int d);
 extern "C" void LaunchSubtractGradient(float3* d_vel, float* d_p, int w, int h, int d, float halfrdx, float airDensity);
 extern "C" void LaunchComputeDivergence(float* d_div, float3* d_vel, int w, int h, int d, float halfrdx);
 extern "C" void LaunchJacobiPressure(float* p_next, float* p_curr, float* d_div, int w, int h, int d);
+extern "C" float LaunchPressureResidual(float* d_p, float* d_div, int w, int h, int d);
 extern "C" void LaunchReflectVelocity(float3* d_vel_curr, float3* d_vel_old, int size);
+extern "C" float LaunchMaxVelocity(float3* d_velocity, int size);
 extern "C" void LaunchAddSource(cudaSurfaceObject_t destSurf, int x, int y, int z, float radius, float amount, int w, int h, int d);
 extern "C" void LaunchAddSourceVelocity(float3* velocity, int x, int y, int z, float radius, float3 amount, int w, int h, int d);
 extern "C" void LaunchDissipate(cudaSurfaceObject_t densitySurf, int w, int h, int d, float rate);
@@ -49,7 +52,9 @@ namespace FluidSimulation
             copyParams.dstArray = mGrid.d_temperatureArrayTemp;
             cudaMemcpy3D(&copyParams);
 
-            cudaMemcpy(mGrid.d_velocity_backup, mGrid.d_velocity, w * h * d * sizeof(float3), cudaMemcpyDeviceToDevice);
+            // ǰ󻺳 backup ȡд d_velocity ÿԪ
+            //  backup Ǳʼʱٶȣ벽ֱʹ
+            std::swap(mGrid.d_velocity, mGrid.d_velocity_backup);
             LaunchAdvectVelocity(mGrid.d_velocity, mGrid.d_velocity_backup, dt, w, h, d);
 
             // 2. Advect
@@ -67,18 +72,48 @@ namespace FluidSimulation
                 Eulerian3dPara::ambientTemp,
                 w, h, d
             );
+            if (Eulerian3dPara::vorticityConst > 0.0f)
+                LaunchVorticityConfinement(mGrid.d_velocity, mGrid.d_vorticity, Eulerian3dPara::vorticityConst, dt, w, h, d);
 
             // 4. Project
+            project(dt);
+        }
+
+        void Solver::project(float dt)
+        {
+            int w = mGrid.dim[0], h = mGrid.dim[1], d = mGrid.dim[2];
             float scaleDiv = (mGrid.cellSize * Eulerian3dPara::airDensity) / (2.0f * dt);
             LaunchComputeDivergence(mGrid.d_divergence, mGrid.d_velocity, w, h, d, scaleDiv);
-            cudaMemset(mGrid.d_pressure, 0, w * h * d * sizeof(float));
-            cudaMemset(mGrid.d_pressure_temp, 0, w * h * d * sizeof(float));
+            // ѹĬһѹΪֵ
+            // ߽һȦѹ̶Ϊ 0Jacobi ˺ֻдڲԪҪ
+            if (!Eulerian3dPara::warmStart) {
+                cudaMemset(mGrid.d_pressure, 0, w * h * d * sizeof(float));
+                cudaMemset(mGrid.d_pressure_temp, 0, w * h * d * sizeof(float));
+            }
 
-            int iterations = 40;
-            for (int i = 0; i < iterations; i++) {
+            // ÿ residualInterval εһβв gpuPressureTolerance ǰ
+            // ÿμ鶼Ҫȴ GPU ؽ˹С
+            const int iterations = (std::max)(Eulerian3dPara::gpuPressureIterations, 0);
+            const float tolerance = Eulerian3dPara::gpuPressureTolerance;
+            const int interval = Eulerian3dPara::residualInterval;
+            int done = 0;
+            int checked = -1;
+            float residual = 0.0f;
+            while (done < iterations) {
                 LaunchJacobiPressure(mGrid.d_pressure_temp, mGrid.d_pressure, mGrid.d_divergence, w, h, d);
                 std::swap(mGrid.d_pressure, mGrid.d_pressure_temp);
+                done++;
+                if (tolerance > 0.0f && interval > 0 && done % interval == 0) {
+                    residual = LaunchPressureResidual(mGrid.d_pressure, mGrid.d_divergence, w, h, d);
+                    checked = done;
+                    if (residual <= tolerance)
+                        break;
+                }
             }
+            if (checked != done)
+                residual = LaunchPressureResidual(mGrid.d_pressure, mGrid.d_divergence, w, h, d);
+            Glb::Timer::getInstance().recordValue("Pressure iterations", done);
+            Glb::Timer::getInstance().recordValue("Pressure residual", (double)residual);
 
             float halfrdx = 0.5f / mGrid.cellSize;
             float scaleSub = Eulerian3dPara::airDensity / dt;
@@ -91,6 +126,78 @@ namespace FluidSimulation
             );
         }
 
+        void Solver::onGridResampled()
+        {
+            if (Eulerian3dPara::dt > 0.0f) {
+                project(Eulerian3dPara::dt);
+                projectMAC(Eulerian3dPara::dt);
+                cudaDeviceSynchronize();
+            }
+        }
+
+        void Solver::projectMAC(float dt)
+        {
+            const int numX = mGrid.dim[0], numY = mGrid.dim[1], numZ = mGrid.dim[2];
+            const double h = mGrid.cellSize;
+            const double aird = Eulerian3dPara::airDensity;
+
+            mPCG.build(mGrid);
+            // ûйʱ DCT ֱ⣻ʱ DCT ΪԤӣöԤ
+            // زٶȳɢȴƵ׿ԤĵԶ MIC(0)
+            mDCT.build(mGrid);
+            const bool boxDomain = Eulerian3dPara::fastPoisson && mDCT.solidFraction() <= Eulerian3dPara::dctSolidFraction;
+            if (boxDomain) {
+                mPCG.setPreconditioner([this](const std::vector<double>& r, std::vector<double>& z) {
+                    mDCT.precondition(r, z);
+                });
+            }
+            else {
+                mMultigrid.build(mGrid);
+                mPCG.setPreconditioner([this](const std::vector<double>& r, std::vector<double>& z) {
+                    mMultigrid.precondition(r, z);
+                });
+            }
+            std::vector<double>& rhs = mPCG.rhs();
+            std::vector<double>& p = mPCG.pressure();
+            for (int k = 0; k < numZ; k++)
+                for (int j = 0; j < numY; j++)
+                    for (int i = 0; i < numX; i++) {
+                        int c[3] = { i, j, k };
+                        int n = mPCG.index(c);
+                        p[n] = 0.0;
+                        rhs[n] = mGrid.isSolidCell(i, j, k) ? 0.0 : -mGrid.getDivergence(i, j, k) * aird * h * h / dt;
+                    }
+            if (boxDomain && mDCT.solidCells() == 0) {
+                mDCT.rhs() = rhs;
+                mDCT.solve();
+                p = mDCT.pressure();
+            }
+            else {
+                // ֻزͶӰһΣޱÿѹ
+                mPCG.solve(Eulerian3dPara::pressureTolerance, (std::max)(Eulerian3dPara::pressureIterations, 500));
+            }
+
+            // ȥѹݶȣ棨ڣٶ 0
+            for (int k = 0; k <= numZ; k++)
+                for (int j = 0; j <= numY; j++)
+                    for (int i = 0; i <= numX; i++) {
+                        int c[3] = { i, j, k };
+                        for (int axis = 0; axis < 3; axis++) {
+                            if (!mGrid.isValid(i, j, k, (MACGrid3d::Direction)axis))
+                                continue;
+                            float &u = axis == 0 ? mGrid.mU.at(i, j, k) : axis == 1 ? mGrid.mV.at(i, j, k) : mGrid.mW.at(i, j, k);
+                            if (mGrid.isSolidFace(i, j, k, (MACGrid3d::Direction)axis)) {
+                                u = 0.0f;
+                                continue;
+                            }
+                            int lower[3] = { i, j, k };
+                            lower[axis]--;
+                            u -= (float)(dt * (p[mPCG.index(c)] - p[mPCG.index(lower)]) / (h * aird));
+                        }
+                    }
+            mGrid.fillGhosts();
+        }
+
         /**
          * 巽
          * ʵһ3DҪ
@@ -126,21 +233,25 @@ namespace FluidSimulation
             cudaSurfaceObject_t tempSurf;
             cudaCreateSurfaceObject(&tempSurf, &surfResDesc);
 
-            if (Eulerian3dPara::useReflection) {
-                if (mGrid.d_velocity_backup) {
-                    cudaMemcpy(mGrid.d_velocity_backup, mGrid.d_velocity, size * sizeof(float3), cudaMemcpyDeviceToDevice);
+            // Ӧʱ dt Ϊһ֡ƽʱ䣬 CFL ֳӲGPU ٶԵԪ߳Ϊȵλ
+            // Դͺɢÿ֡һ
+            Glb::AdaptiveTimeStep steps(dt, Eulerian3dPara::adaptiveTimeStep, Eulerian3dPara::cflNumber, Eulerian3dPara::maxSubsteps, 1.0);
+            while (!steps.done()) {
+                float step = steps.next(LaunchMaxVelocity(mGrid.d_velocity, size));
+                if (Eulerian3dPara::useReflection) {
+                    solveOneStep(densitySurf, densityArrayGL, tempSurf, tempArrayGL, step * 0.5f);
+                    if (mGrid.d_velocity_backup) {
+                        LaunchReflectVelocity(mGrid.d_velocity, mGrid.d_velocity_backup, size);
+                    }
+                    solveOneStep(densitySurf, densityArrayGL, tempSurf, tempArrayGL, step * 0.5f);
                 }
-                solveOneStep(densitySurf, densityArrayGL, tempSurf, tempArrayGL, dt * 0.5f);
-                if (mGrid.d_velocity_backup) {
-                    LaunchReflectVelocity(mGrid.d_velocity, mGrid.d_velocity_backup, size);
+                else {
+                    solveOneStep(densitySurf, densityArrayGL, tempSurf, tempArrayGL, step);
                 }
-                solveOneStep(densitySurf, densityArrayGL, tempSurf, tempArrayGL, dt * 0.5f);
-            }
-            else {
-                solveOneStep(densitySurf, densityArrayGL, tempSurf, tempArrayGL, dt);
             }
 
             cudaDeviceSynchronize();
+            steps.record();
 
 			// Add Sources
             for (size_t i = 0; i < Eulerian3dPara::source.size(); i++) {
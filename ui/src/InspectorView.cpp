@@ -92,6 +92,18 @@ namespace FluidSimulation
 			Glb::Logger::getInstance().addLog("Rerun succeeded.");
 		}
 
+		// 保留当前状态，重采样到新设置的网格尺寸后继续仿真
+		ImGui::SameLine();
+		if (ImGui::Button("Resample") && Manager::getInstance().getMethod() != NULL)
+		{
+			glfwMakeContextCurrent(window);
+
+			Manager::getInstance().getMethod()->resample();
+
+			Manager::getInstance().getSceneView()->texture = -1;
+			Glb::Logger::getInstance().addLog("Resample succeeded.");
+		}
+
 		ImGui::Separator();
 
 		if (Manager::getInstance().getMethod() == NULL)
@@ -146,11 +158,66 @@ namespace FluidSimulation
 				ImGui::SliderFloat("Ambient Temperature", &Eulerian2dPara::ambientTemp, 0.0f, 50.0f);
 				ImGui::SliderFloat("Boussinesq Alpha", &Eulerian2dPara::boussinesqAlpha, 0.0f, 1000.0f);
 				ImGui::SliderFloat("Boussinesq Beta", &Eulerian2dPara::boussinesqBeta, 0.0f, 5000.0f);
+				ImGui::SliderFloat("Vorticity Confinement", &Eulerian2dPara::vorticityConst, 0.0f, 1.0f);
 
 				ImGui::Separator();
 
 				ImGui::Text("Solver:");
 				ImGui::SliderFloat("Delta Time", &Eulerian2dPara::dt, 0.0f, 0.1f, "%.5f");
+				// 开启后 Delta Time 为每帧推进的时间，按 CFL 数自动分成若干子步
+				ImGui::Checkbox("Adaptive Time Step", &Eulerian2dPara::adaptiveTimeStep);
+				if (Eulerian2dPara::adaptiveTimeStep) {
+					ImGui::SliderFloat("CFL Number", &Eulerian2dPara::cflNumber, 0.1f, 10.0f);
+					ImGui::InputScalar("Max Substeps", ImGuiDataType_S32, &Eulerian2dPara::maxSubsteps, &intStep, NULL);
+					Eulerian2dPara::maxSubsteps = (std::max)(Eulerian2dPara::maxSubsteps, 1);
+				}
+				// 对流：回溯的 Runge-Kutta 阶数与误差修正格式
+				ImGui::SliderInt("Backtrace Order", &Eulerian2dPara::backtraceOrder, 1, 3);
+				ImGui::RadioButton("Semi-Lagrangian", &Eulerian2dPara::advectionScheme, Glb::kAdvectSemiLagrangian);
+				ImGui::SameLine();
+				ImGui::RadioButton("MacCormack", &Eulerian2dPara::advectionScheme, Glb::kAdvectMacCormack);
+				ImGui::SameLine();
+				ImGui::RadioButton("BFECC", &Eulerian2dPara::advectionScheme, Glb::kAdvectBFECC);
+				// 0 表示使用全部核心；结果与线程数无关
+				ImGui::InputScalar("Threads (0 = all)", ImGuiDataType_S32, &Eulerian2dPara::numThreads, &intStep, NULL);
+				Eulerian2dPara::numThreads = (std::max)(Eulerian2dPara::numThreads, 0);
+				ImGui::Text("Pressure:");
+				ImGui::RadioButton("Gauss-Seidel", &Eulerian2dPara::pressureSolver, 0);
+				ImGui::SameLine();
+				ImGui::RadioButton("Red-Black SOR", &Eulerian2dPara::pressureSolver, 1);
+				ImGui::SameLine();
+				ImGui::RadioButton("Chebyshev Jacobi", &Eulerian2dPara::pressureSolver, 2);
+				ImGui::SameLine();
+				ImGui::RadioButton("MIC(0)-PCG", &Eulerian2dPara::pressureSolver, 3);
+				ImGui::RadioButton("Multigrid", &Eulerian2dPara::pressureSolver, 4);
+				ImGui::SameLine();
+				ImGui::RadioButton("Multigrid-PCG", &Eulerian2dPara::pressureSolver, 5);
+				// 无固体时直接求解，固体比例不超过阈值时作为 PCG 的预条件子
+				ImGui::Checkbox("DCT for Box Domain", &Eulerian2dPara::fastPoisson);
+				if (Eulerian2dPara::fastPoisson) {
+					ImGui::SliderFloat("DCT Max Solid Fraction", &Eulerian2dPara::dctSolidFraction, 0.0f, 0.2f);
+				}
+				ImGui::InputScalar("Iterations", ImGuiDataType_S32, &Eulerian2dPara::pressureIterations, &intStep, NULL);
+				Eulerian2dPara::pressureIterations = (std::max)(Eulerian2dPara::pressureIterations, 0);
+				if (Eulerian2dPara::pressureSolver == 1) {
+					// 0 表示按网格尺寸取渐近最优值
+					ImGui::SliderFloat("SOR Omega (0 = auto)", &Eulerian2dPara::sorOmega, 0.0f, 1.99f);
+				}
+				// 相对残差降到 Tolerance 以下提前结束（0 表示总是迭代 Iterations 次），定常迭代每 Check Interval 次检查一次
+				ImGui::InputFloat("Tolerance", &Eulerian2dPara::pressureTolerance, 0.0f, 0.0f, "%.1e");
+				if (Eulerian2dPara::pressureSolver <= 2) {
+					ImGui::InputScalar("Check Interval", ImGuiDataType_S32, &Eulerian2dPara::residualInterval, &intStep, NULL);
+					Eulerian2dPara::residualInterval = (std::max)(Eulerian2dPara::residualInterval, 1);
+					// 每个行块连续做的迭代次数，只改变遍历顺序，结果不变
+					ImGui::InputScalar("Temporal Blocking", ImGuiDataType_S32, &Eulerian2dPara::temporalBlocking, &intStep, NULL);
+					Eulerian2dPara::temporalBlocking = (std::max)(Eulerian2dPara::temporalBlocking, 1);
+				}
+				ImGui::Checkbox("Warm Start", &Eulerian2dPara::warmStart);
+				if (Eulerian2dPara::pressureSolver == 4) {
+					ImGui::RadioButton("V-cycle", &Eulerian2dPara::multigridCycle, 0);
+					ImGui::SameLine();
+					ImGui::RadioButton("F-cycle", &Eulerian2dPara::multigridCycle, 1);
+				}
 
 				ImGui::Separator();
 
@@ -180,6 +247,7 @@ namespace FluidSimulation
 				ImGui::InputScalar("Dim.z", ImGuiDataType_S32, &Eulerian3dPara::theDim3d[2], &intStep, NULL);
 
 				ImGui::Checkbox("Add Solid", &Eulerian3dPara::addSolid);
+				ImGui::Checkbox("Bricked Layout", &Eulerian3dPara::brickedLayout);
 				ImGui::Text("---------------------------------");
 				for (int i = 0; i < Eulerian3dPara::source.size(); i++) {
 					ImGui::Text(("source grid " + std::to_string(i)).c_str());
@@ -211,13 +279,30 @@ namespace FluidSimulation
 				ImGui::SliderFloat("Ambient Temperature", &Eulerian3dPara::ambientTemp, 0.0f, 50.0f);
 				ImGui::SliderFloat("Boussinesq Alpha", &Eulerian3dPara::boussinesqAlpha, 0.0f, 1000.0f);
 				ImGui::SliderFloat("Boussinesq Beta", &Eulerian3dPara::boussinesqBeta, 0.0f, 5000.0f);				
+				ImGui::SliderFloat("Vorticity Confinement", &Eulerian3dPara::vorticityConst, 0.0f, 1.0f);
 
 				ImGui::Separator();
 
 				ImGui::Text("Solver:");
 				ImGui::SliderFloat("Delta Time", &Eulerian3dPara::dt, 0.0f, 0.01f, "%.05f");
+				// 开启后 Delta Time 为每帧推进的时间，按 CFL 数自动分成若干子步
+				ImGui::Checkbox("Adaptive Time Step", &Eulerian3dPara::adaptiveTimeStep);
+				if (Eulerian3dPara::adaptiveTimeStep) {
+					ImGui::SliderFloat("CFL Number", &Eulerian3dPara::cflNumber, 0.1f, 10.0f);
+					ImGui::InputScalar("Max Substeps", ImGuiDataType_S32, &Eulerian3dPara::maxSubsteps, &intStep, NULL);
+					Eulerian3dPara::maxSubsteps = (std::max)(Eulerian3dPara::maxSubsteps, 1);
+				}
 				ImGui::Checkbox("Back and Forth Error Compensation and Correction", &Eulerian3dPara::useBFECC);
 				ImGui::Checkbox("Half-Step Reflection", &Eulerian3dPara::useReflection);
+				// 只用于 CPU 端 MAC 场的投影（重采样后）
+				ImGui::Checkbox("DCT for Box Domain (CPU projection)", &Eulerian3dPara::fastPoisson);
+				// GPU 端 Jacobi 压力迭代：每 Check Interval 次检查残差，降到 Tolerance 以下提前结束
+				ImGui::InputScalar("Pressure Iterations", ImGuiDataType_S32, &Eulerian3dPara::gpuPressureIterations, &intStep, NULL);
+				Eulerian3dPara::gpuPressureIterations = (std::max)(Eulerian3dPara::gpuPressureIterations, 0);
+				ImGui::InputFloat("Pressure Tolerance", &Eulerian3dPara::gpuPressureTolerance, 0.0f, 0.0f, "%.1e");
+				ImGui::InputScalar("Check Interval", ImGuiDataType_S32, &Eulerian3dPara::residualInterval, &intStep, NULL);
+				Eulerian3dPara::residualInterval = (std::max)(Eulerian3dPara::residualInterval, 1);
+				ImGui::Checkbox("Warm Start", &Eulerian3dPara::warmStart);
 
 				ImGui::Separator();
 